@@ -0,0 +1,516 @@
+/**
+ * @file benchmark.cpp
+ * @brief EventBus micro benchmarks
+ *
+ * Not part of CTest. Run with `cmake --build build --target run_benchmark`
+ * on a Release build; numbers are only comparable on the same machine.
+ */
+
+#include "eventbus.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace eventbus;
+
+struct BenchFill
+{
+    double price;
+    std::int32_t qty;
+    std::uint64_t order_id;
+    std::uint64_t account;
+    char venue[16];
+};
+
+EVENTBUS_BATCH_FIELDS(BenchFill, &BenchFill::price, &BenchFill::qty, &BenchFill::order_id, &BenchFill::account);
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+const char* backing_name(PageBacking backing)
+{
+    switch (backing) {
+    case PageBacking::heap:
+        return "heap";
+    case PageBacking::normal_pages:
+        return "normal";
+    case PageBacking::transparent_huge_pages:
+        return "thp";
+    case PageBacking::explicit_huge_pages:
+        return "hugetlb";
+    }
+    return "?";
+}
+
+void report(const std::string& name, const std::string& variant, double ops, double seconds)
+{
+    std::cout << std::left << std::setw(28) << name
+              << std::setw(12) << variant
+              << std::right << std::setw(14) << std::fixed << std::setprecision(1)
+              << ops / seconds / 1e6 << " Mops/s" << std::endl;
+}
+
+// Streams fixed-size records through a large ring, the shape of journal and queue traffic.
+void bench_ring(HugePagePolicy policy, const char* label)
+{
+    constexpr std::size_t ring_bytes = std::size_t{256} * 1024 * 1024;
+    constexpr std::size_t record_size = 64;
+    constexpr std::size_t batch = 4096;
+    constexpr std::size_t rounds = 2000;
+
+    detail::ByteRing ring(ring_bytes, policy);
+    std::vector<std::byte> record(record_size, std::byte{0x5a});
+    std::vector<std::byte> out(record_size);
+
+    // Fault every page in before timing.
+    for (std::size_t i = 0; i < ring.capacity() / record_size; ++i) {
+        (void)ring.try_write(record.data(), record_size);
+    }
+    ring.consume(ring.size());
+
+    const auto start = Clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            (void)ring.try_write(record.data(), record_size);
+        }
+        for (std::size_t i = 0; i < batch; ++i) {
+            (void)ring.try_read(out.data(), record_size);
+        }
+    }
+    report("ring stream 64B", std::string(label) + "/" + backing_name(ring.buffer().backing()),
+           static_cast<double>(rounds * batch), seconds_since(start));
+}
+
+// Random 8-byte touches over a large arena: dominated by TLB reach.
+void bench_arena_random(HugePagePolicy policy, const char* label)
+{
+    constexpr std::size_t arena_bytes = std::size_t{512} * 1024 * 1024;
+    constexpr std::size_t touches = std::size_t{20} * 1000 * 1000;
+
+    BufferArena arena(arena_bytes, policy);
+    auto* words = static_cast<std::uint64_t*>(arena.allocate(arena_bytes, 64));
+    const std::size_t count = arena_bytes / sizeof(std::uint64_t);
+    std::memset(words, 1, arena_bytes);
+
+    std::mt19937_64 rng(42);
+    std::vector<std::size_t> indexes(1 << 16);
+    for (auto& index : indexes) {
+        index = rng() % count;
+    }
+
+    std::uint64_t sum = 0;
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < touches; ++i) {
+        sum += words[(indexes[i & (indexes.size() - 1)] + i * 4099) % count];
+    }
+    const double elapsed = seconds_since(start);
+    report("arena random touch", std::string(label) + "/" + (arena.uses_huge_pages() ? "huge" : "normal"),
+           static_cast<double>(touches), elapsed);
+    volatile std::uint64_t sink = sum;
+    (void)sink;
+}
+
+
+struct BenchQuote
+{
+    std::int32_t symbol;
+    std::int32_t venue;
+    double bid;
+    double ask;
+    double bid_size;
+    double ask_size;
+    double last;
+    std::int64_t volume;
+    std::int64_t timestamp;
+};
+
+// Quote stream where each update changes one or two fields of the symbol's previous quote.
+std::vector<BenchQuote> make_quote_stream(std::size_t count, std::int32_t symbols)
+{
+    std::mt19937_64 rng(7);
+    std::vector<BenchQuote> last(static_cast<std::size_t>(symbols));
+    for (std::int32_t i = 0; i < symbols; ++i) {
+        last[static_cast<std::size_t>(i)] = BenchQuote{i, 1, 100.0 + i, 100.5 + i, 500, 700, 100.2 + i, 0, 0};
+    }
+
+    std::vector<BenchQuote> stream;
+    stream.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto& quote = last[rng() % last.size()];
+        switch (rng() % 4) {
+        case 0:
+            quote.bid += 0.01;
+            break;
+        case 1:
+            quote.ask -= 0.01;
+            break;
+        case 2:
+            quote.bid_size += 100;
+            break;
+        default:
+            quote.last = quote.bid;
+            quote.volume += 100;
+            break;
+        }
+        quote.timestamp = static_cast<std::int64_t>(i);
+        stream.push_back(quote);
+    }
+    return stream;
+}
+
+void bench_delta_codec()
+{
+    constexpr std::size_t count = 2000000;
+    const auto stream = make_quote_stream(count, 5000);
+
+    DeltaEncoder encoder;
+    DeltaDecoder decoder;
+    std::vector<std::byte> payload;
+    std::vector<std::byte> frame;
+    std::vector<std::byte> decoded;
+    std::size_t full_bytes = 0;
+    std::size_t delta_bytes = 0;
+
+    const auto start = Clock::now();
+    for (const auto& quote : stream) {
+        payload.clear();
+        detail::encode_payload(payload, quote.symbol, quote);
+        frame.clear();
+        const bool delta = encoder.encode(detail::compaction_key(quote.symbol), detail::journal_type_hash<int, BenchQuote>(),
+                                          payload.data(), payload.size(), frame);
+        (void)decoder.decode(delta, detail::journal_type_hash<int, BenchQuote>(), frame.data(), frame.size(), decoded);
+        full_bytes += payload.size();
+        delta_bytes += frame.size();
+    }
+    report("delta encode+decode", "quotes", static_cast<double>(count), seconds_since(start));
+    std::cout << "  bytes per quote: full " << std::setprecision(1)
+              << static_cast<double>(full_bytes) / count << ", delta "
+              << static_cast<double>(delta_bytes) / count << std::endl;
+}
+
+void bench_delta_journal(bool delta)
+{
+    constexpr std::size_t count = 1000000;
+    const auto stream = make_quote_stream(count, 5000);
+    const std::string path = "eventbus_bench.journal";
+
+    JournalOptions options;
+    options.truncate = true;
+    options.delta_encoding = delta;
+    JournalStats stats{};
+    const auto start = Clock::now();
+    {
+        EventJournal journal(path, options);
+        for (const auto& quote : stream) {
+            journal.append("quotes", quote.symbol, quote);
+        }
+        (void)journal.flush();
+        stats = journal.stats();
+    }
+    report("journal append quotes", delta ? "delta" : "full", static_cast<double>(count), seconds_since(start));
+    std::cout << "  bytes written: " << stats.bytes / (1024 * 1024) << " MiB" << std::endl;
+    std::remove(path.c_str());
+}
+
+// Publishes over many topics with a skewed rate, the case the tracker exists for.
+void bench_hot_topics(bool enabled)
+{
+    constexpr std::size_t count = 2000000;
+    constexpr std::size_t topics = 100000;
+    std::vector<std::string> names;
+    names.reserve(topics);
+    for (std::size_t i = 0; i < topics; ++i) {
+        names.push_back("topic." + std::to_string(i));
+    }
+    std::mt19937_64 rng(7);
+    std::vector<std::uint32_t> order(count);
+    for (auto& index : order) {
+        // Roughly half the traffic goes to 1% of the topics.
+        index = static_cast<std::uint32_t>(rng() % 2 == 0 ? rng() % (topics / 100) : rng() % topics);
+    }
+
+    EventBus bus;
+    if (enabled) {
+        bus.enableHotTopics();
+    }
+    bus.subscribe(names[0], [](int) {});
+    const auto start = Clock::now();
+    for (const auto index : order) {
+        bus.publish(names[index], 1);
+    }
+    report("publish 100k topics", enabled ? "tracked" : "untracked", static_cast<double>(count), seconds_since(start));
+    if (enabled) {
+        const auto top = bus.getHotTopics(3);
+        for (const auto& topic : top) {
+            std::cout << "  " << topic.name << ": ~" << topic.publishes << " publishes" << std::endl;
+        }
+    }
+}
+
+// Legacy string-keyed publishes to a few hot topics in a large registry.
+void bench_fast_path(const char* variant)
+{
+    constexpr std::size_t count = 2000000;
+    EventBus bus;
+    for (int i = 0; i < 10000; ++i) {
+        bus.subscribe("topic." + std::to_string(i), [](int) {});
+    }
+    const std::string hot[] = {"md.quotes", "md.trades", "orders.new", "orders.fill"};
+    for (const auto& name : hot) {
+        for (int i = 0; i < 4; ++i) {
+            bus.subscribe(name, [](int) {});
+        }
+    }
+    const std::string mode = variant;
+    if (mode == "tracked") {
+        bus.enableHotTopics();
+    } else if (mode == "fast path") {
+        FastPathOptions options;
+        options.refresh_interval = std::chrono::milliseconds(0);
+        bus.enableFastPath(options);
+        for (int i = 0; i < 1000; ++i) {
+            bus.publish(hot[i % 4], i);
+        }
+        bus.refreshFastPath();
+    }
+
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bus.publish(hot[i % 4], static_cast<int>(i));
+    }
+    report("publish hot topics", variant, static_cast<double>(count), seconds_since(start));
+}
+
+// Nine in ten publishes go to debug topics nobody subscribes to. A prefix
+// rate limit on an unrelated pattern turns the topic filter off.
+void bench_empty_topics(bool filtered)
+{
+    constexpr std::size_t count = 2000000;
+    EventBus bus;
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back("debug.trace." + std::to_string(i));
+        if (i % 10 == 0) {
+            names.back() = "app.event." + std::to_string(i);
+            bus.subscribe(names.back(), [](int) {});
+        }
+    }
+    if (!filtered) {
+        bus.setRateLimit("unrelated.*", RateLimit{});
+    }
+
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bus.publish(names[(i * 7) % names.size()], static_cast<int>(i));
+    }
+    report("publish 90% empty topics", filtered ? "filter" : "registry", static_cast<double>(count),
+           seconds_since(start));
+}
+
+// Two numeric predicates over 500-event batches: a lambda per event versus a columnar SIMD filter.
+void bench_batch_filter(bool declarative)
+{
+    using Quote = std::tuple<std::string, double, int>;
+    constexpr std::size_t batch_size = 500;
+    constexpr std::size_t rounds = 20000;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> price(90.0, 110.0);
+    std::uniform_int_distribution<int> qty(0, 40);
+    std::vector<Quote> quotes;
+    for (std::size_t i = 0; i < batch_size; ++i) {
+        quotes.emplace_back("ACME", price(rng), qty(rng));
+    }
+    const BatchView<Quote> batch(quotes.data(), quotes.size());
+
+    BatchFilter<Quote> filter;
+    filter.greater<1>(100.0).between<2>(10, 20);
+    const std::vector<std::function<bool(const Quote&)>> predicates{
+        [](const Quote& quote) { return std::get<1>(quote) > 100.0; },
+        [](const Quote& quote) { return std::get<2>(quote) >= 10 && std::get<2>(quote) <= 20; },
+    };
+
+    std::vector<std::uint32_t> selection;
+    std::size_t selected = 0;
+    const auto start = Clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        if (declarative) {
+            filter.select(batch, selection);
+        } else {
+            selection.clear();
+            for (std::uint32_t i = 0; i < batch.size(); ++i) {
+                bool pass = true;
+                for (const auto& predicate : predicates) {
+                    pass = pass && predicate(batch[i]);
+                }
+                if (pass) {
+                    selection.push_back(i);
+                }
+            }
+        }
+        selected += selection.size();
+    }
+    const double elapsed = seconds_since(start);
+    if (selected == 0) {
+        std::cout << "(no events selected)" << std::endl;
+    }
+    report("filter batched events", declarative ? "simd" : "lambda", static_cast<double>(rounds * batch_size), elapsed);
+}
+
+// Filter plus one-column sum over 500-event batches of a 48-byte struct, row-wise versus columnar.
+void bench_columnar(bool columnar)
+{
+    constexpr std::size_t batch_size = 500;
+    constexpr std::size_t rounds = 20000;
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> price(90.0, 110.0);
+    std::uniform_int_distribution<int> qty(0, 40);
+    std::vector<BenchFill> rows;
+    ColumnBatch<BenchFill> columns;
+    columns.reserve(batch_size);
+    for (std::size_t i = 0; i < batch_size; ++i) {
+        BenchFill fill{price(rng), qty(rng), i, i % 7, "XNAS"};
+        rows.push_back(fill);
+        columns.emplace_back(fill);
+    }
+
+    BatchFilter<BenchFill> filter;
+    filter.greater<0>(100.0).between<1>(10, 20);
+    std::vector<std::uint32_t> selection;
+    double total = 0;
+    const auto start = Clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        if (columnar) {
+            filter.select(columns, selection);
+            for (double value : columns.column<0>()) {
+                total += value;
+            }
+        } else {
+            filter.select(BatchView<BenchFill>(rows.data(), rows.size()), selection);
+            for (const auto& row : rows) {
+                total += row.price;
+            }
+        }
+    }
+    const double elapsed = seconds_since(start);
+    if (total == 0 || selection.empty()) {
+        std::cout << "(nothing selected)" << std::endl;
+    }
+    report("filter + sum batch", columnar ? "columnar" : "rows", static_cast<double>(rounds * batch_size), elapsed);
+}
+
+// Four cores publishing to their own topics: one shared registry versus thread-per-core shards.
+void bench_sharded(bool sharded)
+{
+    constexpr std::size_t cores = 4;
+    constexpr std::size_t per_core = 500000;
+    std::atomic<std::size_t> delivered{0};
+
+    if (!sharded) {
+        EventBus bus;
+        for (std::size_t c = 0; c < cores; ++c) {
+            bus.subscribe("core." + std::to_string(c), [&delivered](int) { delivered.fetch_add(1, std::memory_order_relaxed); });
+        }
+        const auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (std::size_t c = 0; c < cores; ++c) {
+            threads.emplace_back([&bus, c]() {
+                const std::string topic = "core." + std::to_string(c);
+                for (std::size_t i = 0; i < per_core; ++i) {
+                    bus.publish(topic, static_cast<int>(i));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        report("publish per-core topics", "shared", static_cast<double>(cores * per_core), seconds_since(start));
+        return;
+    }
+
+    ShardedOptions options;
+    options.shards = cores;
+    ShardedEventBus bus(options);
+    // One topic per shard whose kick topic lands on the same shard, so each loop publishes locally.
+    std::vector<std::string> topics(cores);
+    for (std::size_t found = 0, i = 0; found < cores; ++i) {
+        const std::string candidate = "core." + std::to_string(i);
+        const std::size_t owner = bus.shard_of(candidate);
+        if (topics[owner].empty() && bus.shard_of(candidate + ".run") == owner) {
+            topics[owner] = candidate;
+            ++found;
+        }
+    }
+    for (const auto& topic : topics) {
+        bus.subscribe(topic, [&delivered](int) { delivered.fetch_add(1, std::memory_order_relaxed); });
+        bus.subscribe(topic + ".run", [&bus, topic](int) {
+            for (std::size_t i = 0; i < per_core; ++i) {
+                bus.publish(topic, static_cast<int>(i));
+            }
+        });
+    }
+    const auto start = Clock::now();
+    for (const auto& topic : topics) {
+        bus.publish(topic + ".run", 0);
+    }
+    bus.drain();
+    report("publish per-core topics", "sharded", static_cast<double>(cores * per_core), seconds_since(start));
+}
+
+} // namespace
+
+int main()
+{
+    std::cout << "=== EventBus Benchmarks ===" << std::endl;
+
+    std::cout << "\n-- Huge pages --" << std::endl;
+    bench_ring(HugePagePolicy::disabled, "off");
+    bench_ring(HugePagePolicy::transparent, "thp");
+    bench_ring(HugePagePolicy::explicit_preferred, "explicit");
+    bench_arena_random(HugePagePolicy::disabled, "off");
+    bench_arena_random(HugePagePolicy::transparent, "thp");
+    bench_arena_random(HugePagePolicy::explicit_preferred, "explicit");
+
+    std::cout << "\n-- Delta encoding --" << std::endl;
+    bench_delta_codec();
+    bench_delta_journal(false);
+    bench_delta_journal(true);
+
+    std::cout << "\n-- Hot topics --" << std::endl;
+    bench_hot_topics(false);
+    bench_hot_topics(true);
+    bench_fast_path("registry");
+    bench_fast_path("tracked");
+    bench_fast_path("fast path");
+    bench_empty_topics(false);
+    bench_empty_topics(true);
+
+    std::cout << "\n-- Batch filters --" << std::endl;
+    bench_batch_filter(false);
+    bench_batch_filter(true);
+    bench_columnar(false);
+    bench_columnar(true);
+
+    std::cout << "\n-- Sharded runtime --" << std::endl;
+    bench_sharded(false);
+    bench_sharded(true);
+
+    return 0;
+}
@@ -12,6 +12,23 @@
  * - Type safety: Compile-time and runtime type checking
  * - High performance: Minimal lock hold time during event dispatch
  * - Statistics monitoring: Complete event bus status monitoring
+ * - Huge-page buffers: PageBuffer / BufferArena for large rings and arenas
+ * - Event journal: batched background writes via io_uring or a writer thread
+ * - Log-structured topics: segmented logs read through independent cursors
+ * - Compacted state topics: latest value per key with periodic snapshots
+ * - Bus snapshots: topic table, retained state and journal checkpoint in one file
+ * - Shared-memory transport: multi-producer rings with gap and overrun detection
+ * - Interned strings: repeated payload strings stored once, delivered as string_view
+ * - Hot topics: fixed-memory top-K by publish rate and callback time
+ * - Fast path: hot topics promoted to a direct-mapped table of resolved snapshots
+ * - Topic filter: lock-free counting Bloom filter skips the registry for unknown topics
+ * - Rate limiting: per-topic and per-prefix token buckets checked in publish
+ * - Async delivery: worker pool with CoDel-style shedding by topic class and
+ *   deficit-round-robin fairness across tenants
+ * - Sharded runtime: thread-per-core shards linked by per-pair SPSC queues
+ * - Senders: async publish, request/reply and next event as P2300-style senders
+ * - Fibers: optional stackful fibers for async callbacks that block
+ * - Federation: parent/child bus links that forward only advertised topics
  *
  * Performance note:
  * - Callback execution is synchronous and does not take callback-level locks.
@@ -25,10 +42,13 @@
 
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
 #include <vector>
 #include <any>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <type_traits>
 #include <string>
 #include <string_view>
@@ -37,10 +57,92 @@
 #include <typeindex>
 #include <memory>
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <sstream>
 #include <thread>
 #include <tuple>
+#include <variant>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <optional>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <typeinfo>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define EVENTBUS_HAS_POSIX 1
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <unistd.h>
+#else
+#define EVENTBUS_HAS_POSIX 0
+#endif
+
+#if !defined(EVENTBUS_HAS_IO_URING) && defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define EVENTBUS_HAS_IO_URING 1
+#endif
+#endif
+#if !defined(EVENTBUS_HAS_IO_URING)
+#define EVENTBUS_HAS_IO_URING 0
+#endif
+
+// ThreadSanitizer cannot follow ucontext switches, so sanitized builds run callbacks inline.
+#if !defined(EVENTBUS_HAS_FIBERS) && defined(__linux__) && !defined(__SANITIZE_THREAD__) && defined(__has_include)
+#if __has_include(<ucontext.h>)
+#define EVENTBUS_HAS_FIBERS 1
+#include <ucontext.h>
+#endif
+#endif
+#if !defined(EVENTBUS_HAS_FIBERS)
+#define EVENTBUS_HAS_FIBERS 0
+#endif
+
+#if !defined(EVENTBUS_HAS_AVX) && defined(__AVX__)
+#define EVENTBUS_HAS_AVX 1
+#endif
+#if !defined(EVENTBUS_HAS_AVX)
+#define EVENTBUS_HAS_AVX 0
+#endif
+#if !defined(EVENTBUS_HAS_SSE2) && (defined(__SSE2__) || defined(_M_X64))
+#define EVENTBUS_HAS_SSE2 1
+#endif
+#if !defined(EVENTBUS_HAS_SSE2)
+#define EVENTBUS_HAS_SSE2 0
+#endif
+
+#if !defined(EVENTBUS_HAS_SSE42) && defined(__SSE4_2__)
+#define EVENTBUS_HAS_SSE42 1
+#endif
+#if !defined(EVENTBUS_HAS_SSE42)
+#define EVENTBUS_HAS_SSE42 0
+#endif
+
+#if EVENTBUS_HAS_AVX
+#include <immintrin.h>
+#elif EVENTBUS_HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if EVENTBUS_HAS_SSE42
+#include <nmmintrin.h>
+#endif
+
+#if EVENTBUS_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
 
 namespace eventbus {
 
@@ -55,6 +157,8 @@ enum class LogLevel
 
 using LogHandler = std::function<void(LogLevel, const std::string&)>;
 
+class InternedString;
+
 namespace detail {
 
 template <typename T>
@@ -160,6 +264,18 @@ struct map_to_source_type<T&>
     using type = T;
 };
 
+/// Source type when the publisher sent InternedString for string parameters.
+template<typename TargetType>
+struct interned_map_to_source_type
+{
+    using DecayedTarget = std::decay_t<TargetType>;
+    using type = std::conditional_t<
+        std::is_same_v<DecayedTarget, std::string> || std::is_same_v<DecayedTarget, std::string_view>,
+        InternedString,
+        DecayedTarget
+    >;
+};
+
 template<typename...>
 struct always_false : std::false_type {};
 
@@ -169,701 +285,10661 @@ struct is_nonconst_lvalue_reference
           std::is_lvalue_reference_v<T> &&
           !std::is_const_v<std::remove_reference_t<T>>> {};
 
-} // namespace detail
-
-class ICallbackWrapper
+inline void cpu_relax() noexcept
 {
-public:
-    virtual ~ICallbackWrapper() = default;
-    virtual bool try_invoke(const std::any& args_any) = 0;
-    virtual std::type_index get_args_type() const = 0;
-    virtual callback_id get_id() const = 0;
-};
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
 
-template<typename... Args>
-class CallbackWrapper : public ICallbackWrapper
-{
-    static_assert((!detail::is_nonconst_lvalue_reference<Args>::value && ...),
-                  "EventBus callbacks must not use non-const lvalue reference parameters");
+} // namespace detail
 
-private:
-    callback_id id_;
-    std::function<void(Args...)> callback_;
+// ---------------------------------------------------------------------------
+// Interned strings
+// ---------------------------------------------------------------------------
 
+namespace detail {
+
+/**
+ * @brief Process-wide table behind InternedString
+ *
+ * Entries are never freed, so an interned string stays valid for the life of
+ * the process. Lookups take a shared lock on one of a few shards; only the
+ * first sighting of a string takes the shard exclusively.
+ */
+class InternTable
+{
 public:
-    CallbackWrapper(callback_id id, std::function<void(Args...)> callback)
-        : id_(id), callback_(std::move(callback))
+    static InternTable& instance()
     {
+        static InternTable table;
+        return table;
     }
 
-    bool try_invoke(const std::any& args_any) override
+    /// The empty string always maps to empty_string(), the default InternedString.
+    const std::string* intern(std::string_view text)
     {
-        if constexpr (sizeof...(Args) == 0) {
-            if (args_any.has_value()) {
-                return false;
-            }
-            callback_();
-            return true;
-        } else {
-            // 1. Try exact match
-            if (auto args_tuple = std::any_cast<std::tuple<Args...>>(&args_any)) {
-                std::apply(callback_, *args_tuple);
-                return true;
-            }
-
-            // 2. Try loose match
-            using DecayedArgs = std::tuple<std::decay_t<Args>...>;
-            if (auto args_tuple = std::any_cast<DecayedArgs>(&args_any)) {
-                std::apply(callback_, *args_tuple);
-                return true;
+        if (text.empty()) {
+            return empty_string();
+        }
+        auto& shard = shards_[std::hash<std::string_view>{}(text) % shard_count];
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.strings.find(text);
+            if (it != shard.strings.end()) {
+                return it->second.get();
             }
+        }
 
-            // 3. Try smart type conversion
-            return try_universal_conversion(args_any);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.strings.find(text);
+        if (it == shard.strings.end()) {
+            auto owned = std::make_unique<const std::string>(text);
+            const std::string_view key = *owned;
+            it = shard.strings.emplace(key, std::move(owned)).first;
         }
+        return it->second.get();
     }
 
-    std::type_index get_args_type() const override
+    [[nodiscard]] std::size_t size() const
     {
-        return std::type_index(typeid(std::tuple<Args...>));
+        std::size_t total = 0;
+        for (const auto& shard : shards_) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            total += shard.strings.size();
+        }
+        return total;
     }
 
-    callback_id get_id() const override
+    static const std::string* empty_string() noexcept
     {
-        return id_;
+        static const std::string empty;
+        return &empty;
     }
 
 private:
-    bool try_universal_conversion(const std::any& args_any)
+    static constexpr std::size_t shard_count = 16;
+
+    struct Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string_view, std::unique_ptr<const std::string>> strings;
+    };
+
+    Shard shards_[shard_count];
+};
+
+} // namespace detail
+
+/**
+ * @brief Handle to a string stored once per process
+ *
+ * Copying is a pointer copy and equality is a pointer compare. Published
+ * values reach `std::string_view` and `const std::string&` subscribers
+ * without copying the characters; `std::string` subscribers get a copy.
+ * Intern once (e.g. per symbol) and reuse the handle: construction hashes.
+ */
+class InternedString
+{
+public:
+    InternedString() noexcept : value_(detail::InternTable::empty_string()) {}
+
+    explicit InternedString(std::string_view text)
+        : value_(detail::InternTable::instance().intern(text))
     {
-        return try_parameter_conversion(args_any, std::index_sequence_for<Args...>{});
     }
 
-    template<std::size_t... Is>
-    bool try_parameter_conversion(const std::any& args_any, std::index_sequence<Is...>)
+    [[nodiscard]] const std::string& str() const noexcept { return *value_; }
+    [[nodiscard]] std::string_view view() const noexcept { return *value_; }
+    [[nodiscard]] const char* c_str() const noexcept { return value_->c_str(); }
+    [[nodiscard]] std::size_t size() const noexcept { return value_->size(); }
+    [[nodiscard]] bool empty() const noexcept { return value_->empty(); }
+
+    operator std::string_view() const noexcept { return *value_; }
+
+    friend bool operator==(InternedString left, InternedString right) noexcept
     {
-        using SourceTypes = std::tuple<typename detail::map_to_source_type<std::tuple_element_t<Is, std::tuple<Args...>>>::type...>;
+        return left.value_ == right.value_;
+    }
 
-        if (auto source_tuple = std::any_cast<SourceTypes>(&args_any)) {
-            if (!can_convert_tuple(*source_tuple, std::index_sequence_for<Args...>{})) {
-                return false;
+    friend bool operator!=(InternedString left, InternedString right) noexcept
+    {
+        return left.value_ != right.value_;
+    }
+
+    /// Number of distinct strings interned so far.
+    [[nodiscard]] static std::size_t table_size() { return detail::InternTable::instance().size(); }
+
+private:
+    const std::string* value_;
+};
+
+enum class HugePagePolicy
+{
+    disabled,
+    transparent,
+    explicit_preferred
+};
+
+enum class PageBacking
+{
+    heap,
+    normal_pages,
+    transparent_huge_pages,
+    explicit_huge_pages
+};
+
+namespace detail {
+
+/// False when the kernel's transparent huge page mode is "never", so MADV_HUGEPAGE has no effect.
+inline bool transparent_huge_pages_enabled()
+{
+#if defined(__linux__)
+    static const bool enabled = [] {
+        std::FILE* file = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+        if (file == nullptr) {
+            return false;
+        }
+        char mode[128] = {};
+        const std::size_t length = std::fread(mode, 1, sizeof(mode) - 1, file);
+        std::fclose(file);
+        return std::string_view(mode, length).find("[never]") == std::string_view::npos;
+    }();
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+/// AnonHugePages of the mapping that is exactly [@p address, +@p size), from /proc/self/smaps; 0 when unknown.
+inline std::size_t anon_huge_page_bytes(const void* address, std::size_t size)
+{
+#if defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/smaps", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    const auto start = reinterpret_cast<std::uintptr_t>(address);
+    bool in_mapping = false;
+    std::size_t bytes = 0;
+    char line[512];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        unsigned long long low = 0;
+        unsigned long long high = 0;
+        if (std::sscanf(line, "%llx-%llx ", &low, &high) == 2) {     // a mapping header; field names never parse
+            if (in_mapping) {
+                break;
             }
+            in_mapping = low == start && high == start + size;
+            continue;
+        }
+        unsigned long long kilobytes = 0;
+        if (in_mapping && std::sscanf(line, "AnonHugePages: %llu kB", &kilobytes) == 1) {
+            bytes = static_cast<std::size_t>(kilobytes) * 1024;
+            break;
+        }
+    }
+    std::fclose(file);
+    return bytes;
+#else
+    (void)address;
+    (void)size;
+    return 0;
+#endif
+}
 
-            invoke_with_conversion(*source_tuple, std::index_sequence_for<Args...>{});
-            return true;
+} // namespace detail
+
+/**
+ * @brief Page-aligned buffer that can be backed by huge pages
+ *
+ * `explicit_preferred` tries MAP_HUGETLB first, then transparent huge pages,
+ * then normal pages. Platforms without mmap fall back to an aligned heap block.
+ * `backing()` reports what was obtained: `transparent_huge_pages` means the
+ * region was advised and the kernel's THP mode allows it, not that huge pages
+ * are already resident; `huge_page_bytes()` measures that.
+ */
+class PageBuffer
+{
+public:
+    static constexpr std::size_t huge_page_size = std::size_t{2} * 1024 * 1024;
+
+    PageBuffer() = default;
+
+    explicit PageBuffer(std::size_t size, HugePagePolicy policy = HugePagePolicy::transparent)
+    {
+        if (size == 0) {
+            return;
         }
 
-        using AlternateSourceTypes = std::tuple<typename detail::alternate_map_to_source_type<std::tuple_element_t<Is, std::tuple<Args...>>>::type...>;
-        if constexpr (!std::is_same_v<SourceTypes, AlternateSourceTypes>) {
-            if (auto source_tuple = std::any_cast<AlternateSourceTypes>(&args_any)) {
-                if (!can_convert_tuple(*source_tuple, std::index_sequence_for<Args...>{})) {
-                    return false;
-                }
+        if (policy == HugePagePolicy::disabled) {
+            allocate_pages(round_up(size, page_size()), false);
+            return;
+        }
 
-                invoke_with_conversion(*source_tuple, std::index_sequence_for<Args...>{});
-                return true;
-            }
+        const std::size_t huge_size = round_up(size, huge_page_size);
+        if (policy == HugePagePolicy::explicit_preferred && allocate_explicit_huge(huge_size)) {
+            return;
         }
 
-        return false;
+        allocate_pages(huge_size, true);
     }
 
-    template<typename SourceTuple, std::size_t... Is>
-    bool can_convert_tuple(const SourceTuple& source_tuple, std::index_sequence<Is...>) const
+    ~PageBuffer()
     {
-        return (... && can_convert_parameter<std::tuple_element_t<Is, std::tuple<Args...>>>(std::get<Is>(source_tuple)));
+        release();
     }
 
-    template<typename TargetType, typename SourceType>
-    bool can_convert_parameter(const SourceType& source) const
+    PageBuffer(const PageBuffer&) = delete;
+    PageBuffer& operator=(const PageBuffer&) = delete;
+
+    PageBuffer(PageBuffer&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          backing_(std::exchange(other.backing_, PageBacking::heap)),
+          guard_(std::exchange(other.guard_, 0))
     {
-        using DecayedTarget = std::decay_t<TargetType>;
-        using DecayedSource = std::decay_t<SourceType>;
+    }
 
-        if constexpr (std::is_same_v<DecayedTarget, std::string> &&
-                      (std::is_same_v<DecayedSource, const char*> || std::is_same_v<DecayedSource, char*>)) {
-            return source != nullptr;
-        } else if constexpr (std::is_same_v<DecayedTarget, std::string_view> &&
-                             (std::is_same_v<DecayedSource, const char*> || std::is_same_v<DecayedSource, char*>)) {
-            return source != nullptr;
-        } else {
-            return true;
+    PageBuffer& operator=(PageBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            backing_ = std::exchange(other.backing_, PageBacking::heap);
+            guard_ = std::exchange(other.guard_, 0);
         }
+        return *this;
     }
 
-    template<typename SourceTuple, std::size_t... Is>
-    void invoke_with_conversion(const SourceTuple& source_tuple, std::index_sequence<Is...>)
+    [[nodiscard]] std::byte* data() noexcept { return data_; }
+    [[nodiscard]] const std::byte* data() const noexcept { return data_; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] PageBacking backing() const noexcept { return backing_; }
+    [[nodiscard]] bool empty() const noexcept { return data_ == nullptr; }
+
+    [[nodiscard]] bool uses_huge_pages() const noexcept
     {
-        callback_(convert_parameter<std::tuple_element_t<Is, std::tuple<Args...>>>(std::get<Is>(source_tuple))...);
+        return backing_ == PageBacking::transparent_huge_pages ||
+               backing_ == PageBacking::explicit_huge_pages;
     }
 
-    template<typename TargetType, typename SourceType>
-    std::decay_t<TargetType> convert_parameter(const SourceType& source)
+    /// Bytes currently backed by huge pages; reads /proc/self/smaps for transparent ones.
+    [[nodiscard]] std::size_t huge_page_bytes() const
     {
-        using DecayedTarget = std::decay_t<TargetType>;
-
-        if constexpr (std::is_same_v<DecayedTarget, std::decay_t<SourceType>>) {
-            return source;
-        } else if constexpr (std::is_same_v<DecayedTarget, std::string> &&
-                             (std::is_same_v<std::decay_t<SourceType>, const char*> ||
-                              std::is_same_v<std::decay_t<SourceType>, char*>)) {
-            return std::string(source);
-        } else if constexpr (std::is_same_v<DecayedTarget, std::string> &&
-                             std::is_same_v<std::decay_t<SourceType>, std::string_view>) {
-            return std::string(source);
-        } else if constexpr (std::is_same_v<DecayedTarget, std::string_view> &&
-                             (std::is_same_v<std::decay_t<SourceType>, const char*> ||
-                              std::is_same_v<std::decay_t<SourceType>, char*>)) {
-            return std::string_view(source);
-        } else if constexpr (std::is_same_v<DecayedTarget, std::string_view> &&
-                             std::is_same_v<std::decay_t<SourceType>, std::string>) {
-            return std::string_view(source);
-        } else if constexpr (std::is_convertible_v<SourceType, DecayedTarget>) {
-            return static_cast<DecayedTarget>(source);
-        } else {
-            static_assert(detail::always_false<TargetType, SourceType>::value,
-                          "Unsupported event parameter conversion");
+        if (backing_ == PageBacking::explicit_huge_pages) {
+            return size_;
+        }
+        if (backing_ == PageBacking::transparent_huge_pages) {
+            return detail::anon_huge_page_bytes(data_, size_);
         }
+        return 0;
     }
-};
-
-class EventBus
-{
-public:
-    struct EventBusStats
-    {
-        std::size_t total_events;
-        std::size_t total_callbacks;
-        std::size_t max_callbacks_per_event;
-        std::string most_subscribed_event;
-    };
 
-    struct PublishResult
+    static std::size_t page_size() noexcept
     {
-        std::size_t subscribers;
-        std::size_t invoked;
-        std::size_t failed;
-        std::size_t type_mismatches;
-        std::size_t skipped;
-    };
+#if EVENTBUS_HAS_POSIX
+        const long value = ::sysconf(_SC_PAGESIZE);
+        return value > 0 ? static_cast<std::size_t>(value) : std::size_t{4096};
+#else
+        return 4096;
+#endif
+    }
 
 private:
-    using CallbackPtr = std::shared_ptr<ICallbackWrapper>;
+    static std::size_t round_up(std::size_t value, std::size_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
 
-    struct CallbackEntry
+    bool allocate_explicit_huge(std::size_t size)
     {
-        explicit CallbackEntry(CallbackPtr callback_wrapper)
-            : callback(std::move(callback_wrapper))
-        {
+#if EVENTBUS_HAS_POSIX && defined(MAP_HUGETLB)
+        void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            data_ = static_cast<std::byte*>(memory);
+            size_ = size;
+            backing_ = PageBacking::explicit_huge_pages;
+            return true;
         }
+#else
+        (void)size;
+#endif
+        return false;
+    }
 
-        CallbackPtr callback;
-        bool active{true};
-        std::size_t in_flight{0};
-        std::unordered_map<std::thread::id, std::size_t> invoking_threads;
-        mutable std::mutex state_mutex;
-        std::condition_variable idle_cv;
-    };
-
-    using CallbackEntryPtr = std::shared_ptr<CallbackEntry>;
-    using CallbackList = std::vector<CallbackEntryPtr>;
+    void allocate_pages(std::size_t size, bool advise_huge)
+    {
+#if EVENTBUS_HAS_POSIX
+        // An inaccessible page on top keeps the kernel from merging advised
+        // neighbours into one mapping, so smaps can be read per buffer.
+        const std::size_t guard = advise_huge ? page_size() : 0;
+        // THP only backs huge-page-aligned extents, so advised buffers over-map
+        // by one huge page and trim the start to a huge-page boundary.
+        const std::size_t slack = advise_huge ? huge_page_size : 0;
+        void* memory = ::mmap(nullptr, size + guard + slack, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        if (slack != 0) {
+            auto* const raw = static_cast<std::byte*>(memory);
+            const auto address = reinterpret_cast<std::uintptr_t>(raw);
+            const std::size_t head = round_up(address, huge_page_size) - address;
+            if (head != 0) {
+                ::munmap(raw, head);
+            }
+            if (slack - head != 0) {
+                ::munmap(raw + head + size + guard, slack - head);
+            }
+            memory = raw + head;
+        }
+        data_ = static_cast<std::byte*>(memory);
+        size_ = size;
+        guard_ = guard;
+        if (guard != 0) {
+            ::mprotect(data_ + size, guard, PROT_NONE);
+        }
+        backing_ = PageBacking::normal_pages;
+#if defined(MADV_HUGEPAGE)
+        if (advise_huge && ::madvise(memory, size, MADV_HUGEPAGE) == 0 &&
+            detail::transparent_huge_pages_enabled()) {
+            backing_ = PageBacking::transparent_huge_pages;
+        }
+#else
+        (void)advise_huge;
+#endif
+#else
+        (void)advise_huge;
+        data_ = static_cast<std::byte*>(::operator new(size, std::align_val_t{page_size()}));
+        size_ = size;
+        backing_ = PageBacking::heap;
+#endif
+    }
 
-    enum class InvokeStatus
+    void release() noexcept
     {
-        invoked,
-        type_mismatch,
-        skipped
-    };
+        if (data_ == nullptr) {
+            return;
+        }
+#if EVENTBUS_HAS_POSIX
+        ::munmap(data_, size_ + guard_);
+#else
+        ::operator delete(data_, std::align_val_t{page_size()});
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        guard_ = 0;
+    }
 
-    std::atomic<callback_id> next_id_{0};
-    mutable std::shared_mutex mutex_;
-    std::unordered_map<std::string, CallbackList> callbacks_map_;
-    bool closing_{false};
-    std::atomic<bool> verbose_logging_{false};
-    mutable std::mutex log_mutex_;
-    LogHandler log_handler_;
+    std::byte* data_{nullptr};
+    std::size_t size_{0};
+    PageBacking backing_{PageBacking::heap};
+    std::size_t guard_{0};              // PROT_NONE bytes mapped after size_
+};
 
+/**
+ * @brief Bump allocator over a chain of PageBuffer chunks
+ *
+ * Allocations are released together by `reset()`; the first chunk is kept so
+ * steady-state reuse never returns memory to the OS.
+ */
+class BufferArena
+{
 public:
-    explicit EventBus(bool verbose_logging = false) : verbose_logging_(verbose_logging) {}
-
-    EventBus(bool verbose_logging, LogHandler log_handler)
-        : verbose_logging_(verbose_logging), log_handler_(std::move(log_handler))
+    explicit BufferArena(std::size_t chunk_size = PageBuffer::huge_page_size,
+                         HugePagePolicy policy = HugePagePolicy::transparent)
+        : chunk_size_(chunk_size), policy_(policy)
     {
     }
 
-    ~EventBus() noexcept
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
     {
-        try {
-            close();
+        if (!chunks_.empty()) {
+            const std::size_t aligned = (offset_ + alignment - 1) & ~(alignment - 1);
+            if (aligned + bytes <= chunks_.back().size()) {
+                offset_ = aligned + bytes;
+                return chunks_.back().data() + aligned;
+            }
         }
-        catch (...) {
+
+        chunks_.emplace_back(std::max(bytes, chunk_size_), policy_);
+        offset_ = bytes;
+        return chunks_.back().data();
+    }
+
+    void reset()
+    {
+        if (chunks_.size() > 1) {
+            chunks_.erase(chunks_.begin() + 1, chunks_.end());
         }
+        offset_ = 0;
     }
 
-    EventBus(const EventBus&) = delete;
-    EventBus& operator=(const EventBus&) = delete;
-    EventBus(EventBus&&) = delete;
-    EventBus& operator=(EventBus&&) = delete;
+    [[nodiscard]] std::size_t reserved_bytes() const noexcept
+    {
+        std::size_t total = 0;
+        for (const auto& chunk : chunks_) {
+            total += chunk.size();
+        }
+        return total;
+    }
+
+    [[nodiscard]] bool uses_huge_pages() const noexcept
+    {
+        return !chunks_.empty() && chunks_.front().uses_huge_pages();
+    }
+
+private:
+    std::size_t chunk_size_;
+    HugePagePolicy policy_;
+    std::vector<PageBuffer> chunks_;
+    std::size_t offset_{0};
+};
+
+namespace detail {
+
+/**
+ * @brief Single-producer single-consumer byte ring over a PageBuffer
+ *
+ * Capacity is rounded up to a power of two. Records are copied in with
+ * wrap-around; the consumer drains through at most two contiguous spans so
+ * writers can hand them to the kernel without an extra copy.
+ */
+class ByteRing
+{
+public:
+    struct Span
+    {
+        const std::byte* data;
+        std::size_t size;
+    };
+
+    explicit ByteRing(std::size_t capacity, HugePagePolicy policy = HugePagePolicy::transparent)
+        : buffer_(next_power_of_two(capacity), policy), mask_(buffer_.size() - 1)
+    {
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return buffer_.size(); }
+    [[nodiscard]] const PageBuffer& buffer() const noexcept { return buffer_; }
+    [[nodiscard]] PageBuffer& buffer() noexcept { return buffer_; }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool try_write(const void* data, std::size_t size) noexcept
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        if (capacity() - (head - tail) < size) {
+            return false;
+        }
+
+        copy_in(head, data, size);
+        head_.store(head + size, std::memory_order_release);
+        return true;
+    }
+
+    /// Returns the readable region as up to two spans (second one is the wrapped part).
+    [[nodiscard]] std::pair<Span, Span> readable() const noexcept
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t available = head - tail;
+        const std::size_t offset = tail & mask_;
+        const std::size_t first = std::min(available, capacity() - offset);
+        return {Span{buffer_.data() + offset, first}, Span{buffer_.data(), available - first}};
+    }
+
+    void consume(std::size_t size) noexcept
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    /// Copies `size` bytes starting `offset` bytes past the read position without consuming them.
+    bool peek(std::size_t offset, void* out, std::size_t size) const noexcept
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        if (head - tail < offset + size) {
+            return false;
+        }
+
+        const std::size_t start = (tail + offset) & mask_;
+        const std::size_t first = std::min(size, capacity() - start);
+        std::memcpy(out, buffer_.data() + start, first);
+        std::memcpy(static_cast<std::byte*>(out) + first, buffer_.data(), size - first);
+        return true;
+    }
+
+    bool try_read(void* out, std::size_t size) noexcept
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        if (head - tail < size) {
+            return false;
+        }
+
+        const std::size_t offset = tail & mask_;
+        const std::size_t first = std::min(size, capacity() - offset);
+        std::memcpy(out, buffer_.data() + offset, first);
+        std::memcpy(static_cast<std::byte*>(out) + first, buffer_.data(), size - first);
+        tail_.store(tail + size, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static std::size_t next_power_of_two(std::size_t value) noexcept
+    {
+        std::size_t result = 64;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    void copy_in(std::size_t position, const void* data, std::size_t size) noexcept
+    {
+        const std::size_t offset = position & mask_;
+        const std::size_t first = std::min(size, capacity() - offset);
+        std::memcpy(buffer_.data() + offset, data, first);
+        std::memcpy(buffer_.data(), static_cast<const std::byte*>(data) + first, size - first);
+    }
+
+    PageBuffer buffer_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+// Event journal
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+inline std::uint64_t fnv1a(const void* data, std::size_t size,
+                           std::uint64_t hash = 14695981039346656037ull) noexcept
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline std::uint64_t fnv1a(std::string_view text) noexcept
+{
+    return fnv1a(text.data(), text.size());
+}
+
+template<typename T>
+struct is_journal_string
+    : std::bool_constant<std::is_same_v<T, std::string> ||
+                         std::is_same_v<T, std::string_view> ||
+                         std::is_same_v<T, InternedString> ||
+                         std::is_same_v<T, const char*> ||
+                         std::is_same_v<T, char*>> {};
+
+/// Payload value type after a journal round trip: strings come back owned.
+template<typename T>
+using journal_value_t = std::conditional_t<is_journal_string<std::decay_t<T>>::value,
+                                           std::string, std::decay_t<T>>;
+
+template<typename T>
+struct is_journal_serializable
+    : std::bool_constant<is_journal_string<std::decay_t<T>>::value ||
+                         (std::is_trivially_copyable_v<std::decay_t<T>> &&
+                          !std::is_pointer_v<std::decay_t<T>> &&
+                          !std::is_member_pointer_v<std::decay_t<T>>)> {};
+
+template<typename... Args>
+inline constexpr bool is_journal_serializable_v = (is_journal_serializable<Args>::value && ...);
+
+template<typename... Args>
+std::uint64_t journal_type_hash()
+{
+    static const std::uint64_t hash =
+        fnv1a(typeid(std::tuple<journal_value_t<Args>...>).name());
+    return hash;
+}
+
+inline void append_bytes(std::vector<std::byte>& out, const void* data, std::size_t size)
+{
+    const auto* bytes = static_cast<const std::byte*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+template<typename T>
+void encode_value(std::vector<std::byte>& out, const T& value)
+{
+    if constexpr (is_journal_string<T>::value) {
+        std::string_view text;
+        if constexpr (std::is_pointer_v<T>) {
+            if (value != nullptr) {
+                text = value;
+            }
+        } else {
+            text = value;
+        }
+        const auto size = static_cast<std::uint32_t>(text.size());
+        append_bytes(out, &size, sizeof(size));
+        append_bytes(out, text.data(), text.size());
+    } else {
+        static_assert(is_journal_serializable<T>::value,
+                      "Journal payloads must be trivially copyable or strings");
+        append_bytes(out, &value, sizeof(T));
+    }
+}
+
+template<typename T>
+bool decode_value(const std::byte*& cursor, const std::byte* end, T& value)
+{
+    if constexpr (std::is_same_v<T, std::string>) {
+        std::uint32_t size = 0;
+        if (static_cast<std::size_t>(end - cursor) < sizeof(size)) {
+            return false;
+        }
+        std::memcpy(&size, cursor, sizeof(size));
+        cursor += sizeof(size);
+        if (static_cast<std::size_t>(end - cursor) < size) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(cursor), size);
+        cursor += size;
+    } else {
+        if (static_cast<std::size_t>(end - cursor) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+    }
+    return true;
+}
+
+template<typename... Args>
+void encode_payload(std::vector<std::byte>& out, const Args&... args)
+{
+    (encode_value<std::decay_t<const Args&>>(out, args), ...);
+}
+
+/// Key of an event for compaction and delta encoding: the encoded bytes of its first argument.
+template<typename... Args>
+std::string compaction_key(const Args&... args)
+{
+    std::string key;
+    if constexpr (sizeof...(Args) > 0) {
+        const auto& first = std::get<0>(std::forward_as_tuple(args...));
+        using First = std::decay_t<const std::tuple_element_t<0, std::tuple<Args...>>&>;
+        if constexpr (is_journal_string<First>::value) {
+            std::string_view text;
+            if constexpr (std::is_pointer_v<First>) {
+                if (first != nullptr) {
+                    text = first;
+                }
+            } else {
+                text = first;
+            }
+            const auto size = static_cast<std::uint32_t>(text.size());
+            key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+            key.append(text.data(), text.size());
+        } else {
+            static_assert(is_journal_serializable<First>::value,
+                          "Journal payloads must be trivially copyable or strings");
+            key.append(reinterpret_cast<const char*>(&first), sizeof(First));
+        }
+    }
+    return key;
+}
+
+template<typename Tuple, std::size_t... Is>
+bool decode_tuple(const std::byte* data, std::size_t size, Tuple& values, std::index_sequence<Is...>)
+{
+    const std::byte* cursor = data;
+    const std::byte* end = data + size;
+    const bool ok = (... && decode_value(cursor, end, std::get<Is>(values)));
+    return ok && cursor == end;
+}
+
+struct JournalRecordHeader
+{
+    std::uint32_t size;
+    std::uint16_t topic_size;
+    std::uint16_t flags;
+    std::uint64_t sequence;
+    std::uint64_t type_hash;
+    std::uint32_t crc;          // see record_crc()
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(JournalRecordHeader) == 32, "Journal record header must stay packed");
+
+/// CRC-32C (Castagnoli); uses the SSE4.2 instruction when the build enables it.
+inline std::uint32_t crc32c(std::uint32_t crc, const void* data, std::size_t size) noexcept
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+#if EVENTBUS_HAS_SSE42 && (defined(__x86_64__) || defined(_M_X64))
+    for (; size >= 8; size -= 8, bytes += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        crc = static_cast<std::uint32_t>(_mm_crc32_u64(crc, word));
+    }
+    for (; size > 0; --size) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+    }
+#else
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> entries{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) != 0 ? (value >> 1) ^ 0x82F63B78u : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    for (; size > 0; --size) {
+        crc = table[(crc ^ *bytes++) & 0xffu] ^ (crc >> 8);
+    }
+#endif
+    return ~crc;
+}
+
+/**
+ * CRC of a record without its sequence, which is only assigned under the
+ * append lock. seal_record() folds the sequence in cheaply afterwards, so
+ * the stored value still covers every byte.
+ */
+inline std::uint32_t record_crc(const JournalRecordHeader& header, const std::byte* body, std::size_t body_size) noexcept
+{
+    std::uint32_t crc = crc32c(0, &header, offsetof(JournalRecordHeader, sequence));
+    crc = crc32c(crc, &header.type_hash, sizeof(header.type_hash));
+    return crc32c(crc, body, body_size);
+}
+
+inline std::uint32_t sequence_crc(std::uint64_t sequence) noexcept
+{
+    return static_cast<std::uint32_t>((sequence * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+/// Stores @p sequence in a finished record and folds it into the record's CRC.
+inline void seal_record(std::vector<std::byte>& record, std::uint64_t sequence) noexcept
+{
+    std::uint32_t crc;
+    std::memcpy(&crc, record.data() + offsetof(JournalRecordHeader, crc), sizeof(crc));
+    crc ^= sequence_crc(sequence);
+    std::memcpy(record.data() + offsetof(JournalRecordHeader, sequence), &sequence, sizeof(sequence));
+    std::memcpy(record.data() + offsetof(JournalRecordHeader, crc), &crc, sizeof(crc));
+}
+
+/// True when a record read back (header plus @p body) matches its CRC; false for torn or corrupt ones.
+inline bool record_intact(const JournalRecordHeader& header, const std::byte* body) noexcept
+{
+    return header.crc == (record_crc(header, body, header.size - sizeof(header)) ^ sequence_crc(header.sequence));
+}
+
+inline std::vector<std::byte>& journal_scratch()
+{
+    thread_local std::vector<std::byte> scratch;
+    return scratch;
+}
+
+/// Starts a record in `out`: reserves the header and appends the topic.
+inline void begin_record(std::vector<std::byte>& out, std::string_view topic)
+{
+    if (topic.size() > 0xffff) {
+        throw std::length_error("Journal topic name too long");
+    }
+    out.clear();
+    out.resize(sizeof(JournalRecordHeader));
+    append_bytes(out, topic.data(), topic.size());
+}
+
+inline void finish_record(std::vector<std::byte>& out, std::size_t topic_size,
+                          std::uint64_t type_hash, std::uint16_t flags)
+{
+    if (out.size() > 0xffffffffu) {
+        throw std::length_error("Journal record too large");
+    }
+    JournalRecordHeader header{};
+    header.size = static_cast<std::uint32_t>(out.size());
+    header.topic_size = static_cast<std::uint16_t>(topic_size);
+    header.flags = flags;
+    header.type_hash = type_hash;
+    header.crc = record_crc(header, out.data() + sizeof(header), out.size() - sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+}
+
+/// Record flags of delta-encoded journals; both frames start with the u32-prefixed event key.
+inline constexpr std::uint16_t journal_flag_keyframe = 0x1;
+inline constexpr std::uint16_t journal_flag_delta = 0x2;
+
+/// Word-level delta of two equally sized payloads: a bitmap of changed 8-byte words, then those words.
+inline void encode_delta(const std::byte* base, const std::byte* current, std::size_t size,
+                         std::vector<std::byte>& out)
+{
+    const std::size_t words = (size + 7) / 8;
+    const std::size_t bitmap = out.size();
+    out.resize(out.size() + (words + 7) / 8);
+    for (std::size_t word = 0; word < words; ++word) {
+        const std::size_t offset = word * 8;
+        const std::size_t length = std::min<std::size_t>(8, size - offset);
+        bool changed = false;
+        if (length == 8) {
+            std::uint64_t before = 0;
+            std::uint64_t after = 0;
+            std::memcpy(&before, base + offset, 8);
+            std::memcpy(&after, current + offset, 8);
+            changed = before != after;
+        } else {
+            changed = std::memcmp(base + offset, current + offset, length) != 0;
+        }
+        if (changed) {
+            out[bitmap + word / 8] |= std::byte{static_cast<unsigned char>(1u << (word % 8))};
+            append_bytes(out, current + offset, length);
+        }
+    }
+}
+
+/// Applies an encode_delta() body to `target`, which holds the base payload.
+inline bool apply_delta(std::byte* target, std::size_t size, const std::byte* delta, std::size_t delta_size)
+{
+    const std::size_t words = (size + 7) / 8;
+    const std::size_t bitmap_size = (words + 7) / 8;
+    if (delta_size < bitmap_size) {
+        return false;
+    }
+    const std::byte* cursor = delta + bitmap_size;
+    const std::byte* end = delta + delta_size;
+    for (std::size_t word = 0; word < words; ++word) {
+        if ((delta[word / 8] & std::byte{static_cast<unsigned char>(1u << (word % 8))}) == std::byte{0}) {
+            continue;
+        }
+        const std::size_t offset = word * 8;
+        const std::size_t length = std::min<std::size_t>(8, size - offset);
+        if (static_cast<std::size_t>(end - cursor) < length) {
+            return false;
+        }
+        std::memcpy(target + offset, cursor, length);
+        cursor += length;
+    }
+    return cursor == end;
+}
+
+/// Outcome of JournalSink::write(); after `sync_failed` the data is written but not known durable.
+enum class SinkStatus
+{
+    ok,
+    write_failed,
+    sync_failed
+};
+
+class JournalSink
+{
+public:
+    virtual ~JournalSink() = default;
+
+    /// Writes the spans back to back at `offset`; with `sync` the data is also made durable.
+    virtual SinkStatus write(const ByteRing::Span* spans, std::size_t count,
+                             std::uint64_t offset, bool sync) = 0;
+};
+
+#if EVENTBUS_HAS_POSIX
+
+inline bool write_fully(int fd, const std::byte* data, std::size_t size, std::uint64_t offset)
+{
+    while (size > 0) {
+        const ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+        offset += static_cast<std::uint64_t>(written);
+    }
+    return true;
+}
+
+inline bool sync_file(int fd)
+{
+#if defined(__APPLE__)
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+}
+
+class ThreadJournalSink : public JournalSink
+{
+public:
+    explicit ThreadJournalSink(int fd) : fd_(fd) {}
+
+    SinkStatus write(const ByteRing::Span* spans, std::size_t count,
+                     std::uint64_t offset, bool sync) override
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!write_fully(fd_, spans[i].data, spans[i].size, offset)) {
+                return SinkStatus::write_failed;
+            }
+            offset += spans[i].size;
+        }
+        return !sync || sync_file(fd_) ? SinkStatus::ok : SinkStatus::sync_failed;
+    }
+
+private:
+    int fd_;
+};
+
+#endif // EVENTBUS_HAS_POSIX
+
+#if EVENTBUS_HAS_IO_URING
+
+/**
+ * @brief Minimal io_uring submission/completion ring driven by raw syscalls
+ *
+ * Only the journal writer thread touches it, so the submission side needs no
+ * locking; the shared ring indexes use acquire/release as the kernel expects.
+ */
+class IoUring
+{
+public:
+    IoUring() = default;
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring()
+    {
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+            ::munmap(cq_ptr_, cq_size_);
+        }
+        if (sq_ptr_ != nullptr) {
+            ::munmap(sq_ptr_, sq_size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool init(unsigned entries)
+    {
+        io_uring_params params{};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            return false;
+        }
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+
+        sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == nullptr) {
+            return false;
+        }
+        cq_ptr_ = single_mmap ? sq_ptr_ : map(cq_size_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == nullptr) {
+            return false;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (sqes_ == nullptr) {
+            return false;
+        }
+
+        auto* sq = static_cast<std::byte*>(sq_ptr_);
+        auto* cq = static_cast<std::byte*>(cq_ptr_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool register_buffer(void* data, std::size_t size)
+    {
+        iovec vec{data, size};
+        return ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, &vec, 1) == 0;
+    }
+
+    io_uring_sqe* next_sqe()
+    {
+        const unsigned tail = *sq_tail_ + pending_;
+        const unsigned index = tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        ++pending_;
+        return sqe;
+    }
+
+    /// Submits everything queued and waits for that many completions; results go to `results`.
+    bool submit_and_wait(int* results)
+    {
+        const unsigned count = pending_;
+        __atomic_store_n(sq_tail_, *sq_tail_ + count, __ATOMIC_RELEASE);
+        pending_ = 0;
+
+        unsigned reaped = 0;
+        unsigned to_submit = count;
+        while (reaped < count) {
+            const long entered = ::syscall(__NR_io_uring_enter, fd_, to_submit, count - reaped,
+                                           IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (entered < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            to_submit = 0;
+
+            unsigned head = *cq_head_;
+            const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            while (head != tail && reaped < count) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                results[cqe.user_data] = cqe.res;
+                ++head;
+                ++reaped;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    void* map(std::size_t size, off_t offset)
+    {
+        void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return memory == MAP_FAILED ? nullptr : memory;
+    }
+
+    int fd_{-1};
+    void* sq_ptr_{nullptr};
+    void* cq_ptr_{nullptr};
+    io_uring_sqe* sqes_{nullptr};
+    std::size_t sq_size_{0};
+    std::size_t cq_size_{0};
+    std::size_t sqes_size_{0};
+    unsigned* sq_tail_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned* sq_array_{nullptr};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+    unsigned pending_{0};
+};
+
+/**
+ * @brief Journal sink submitting batched writes and a linked fdatasync via io_uring
+ *
+ * The journal ring itself is registered as a fixed buffer, so writes go
+ * straight from the ring to the kernel. If registration is refused (memlock
+ * limits) plain IORING_OP_WRITE is used instead.
+ */
+class IoUringJournalSink : public JournalSink
+{
+public:
+    IoUringJournalSink(int fd, PageBuffer& buffer)
+        : fd_(fd), buffer_(buffer)
+    {
+    }
+
+    bool init()
+    {
+        if (!ring_.init(8)) {
+            return false;
+        }
+        fixed_buffer_ = ring_.register_buffer(buffer_.data(), buffer_.size());
+        return true;
+    }
+
+    SinkStatus write(const ByteRing::Span* spans, std::size_t count,
+                     std::uint64_t offset, bool sync) override
+    {
+        int results[3] = {0, 0, 0};
+        std::uint64_t position = offset;
+        std::size_t submitted = 0;
+        for (std::size_t i = 0; i < count && submitted < 2; ++i) {
+            if (spans[i].size == 0) {
+                continue;
+            }
+            io_uring_sqe* sqe = ring_.next_sqe();
+            sqe->opcode = fixed_buffer_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            sqe->fd = fd_;
+            sqe->addr = reinterpret_cast<std::uint64_t>(spans[i].data);
+            sqe->len = static_cast<std::uint32_t>(spans[i].size);
+            sqe->off = position;
+            sqe->buf_index = 0;
+            sqe->user_data = submitted;
+            if (sync) {
+                sqe->flags = IOSQE_IO_LINK;
+            }
+            position += spans[i].size;
+            ++submitted;
+        }
+
+        if (sync) {
+            io_uring_sqe* sqe = ring_.next_sqe();
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = fd_;
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+            sqe->user_data = submitted;
+        }
+
+        if (!ring_.submit_and_wait(results)) {
+            return SinkStatus::write_failed;
+        }
+
+        // Short writes break the link chain; finish them synchronously.
+        bool needs_sync = false;
+        position = offset;
+        std::size_t slot = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (spans[i].size == 0) {
+                continue;
+            }
+            const int result = results[slot++];
+            if (result < 0 && result != -ECANCELED) {
+                return SinkStatus::write_failed;
+            }
+            const std::size_t done = result > 0 ? static_cast<std::size_t>(result) : 0;
+            if (done < spans[i].size) {
+                if (!write_fully(fd_, spans[i].data + done, spans[i].size - done, position + done)) {
+                    return SinkStatus::write_failed;
+                }
+                needs_sync = sync;
+            }
+            position += spans[i].size;
+        }
+
+        if (sync && results[submitted] < 0) {
+            needs_sync = true;
+        }
+        return !needs_sync || sync_file(fd_) ? SinkStatus::ok : SinkStatus::sync_failed;
+    }
+
+private:
+    int fd_;
+    PageBuffer& buffer_;
+    IoUring ring_;
+    bool fixed_buffer_{false};
+};
+
+#endif // EVENTBUS_HAS_IO_URING
+
+} // namespace detail
+
+/**
+ * @brief Per-key delta encoder for serialized event streams
+ *
+ * Each payload is compared with the last one sent for the same key (the first
+ * event argument). Same-size payloads of the same type are sent as a delta of
+ * the changed 8-byte words; anything else, every `keyframe_interval`-th
+ * event, and deltas that would not be smaller go out as keyframes. Frames
+ * start with the key so the receiving DeltaDecoder needs no type knowledge.
+ * Not thread-safe: frames must be decoded in the order they were encoded.
+ */
+class DeltaEncoder
+{
+public:
+    explicit DeltaEncoder(std::size_t keyframe_interval = 64) : keyframe_interval_(keyframe_interval) {}
+
+    /// Appends the frame for `payload` to `out`; returns true for a delta, false for a keyframe.
+    bool encode(std::string_view key, std::uint64_t type_hash, const std::byte* payload, std::size_t size,
+                std::vector<std::byte>& out)
+    {
+        const bool delta = prepare(key, type_hash, payload, size, out);
+        commit(key, type_hash, payload, size, delta);
+        return delta;
+    }
+
+    /**
+     * First half of encode(): appends the frame but leaves the key's base
+     * alone, so a frame that never reaches the stream does not become the
+     * base of the next delta. Call commit() once the frame is written.
+     */
+    bool prepare(std::string_view key, std::uint64_t type_hash, const std::byte* payload, std::size_t size,
+                 std::vector<std::byte>& out)
+    {
+        const auto key_size = static_cast<std::uint32_t>(key.size());
+        detail::append_bytes(out, &key_size, sizeof(key_size));
+        detail::append_bytes(out, key.data(), key.size());
+        const std::size_t body = out.size();
+
+        lookup_.assign(key.data(), key.size());
+        auto it = states_.find(lookup_);
+        bool delta = it != states_.end() && it->second.type_hash == type_hash && it->second.payload.size() == size &&
+                     it->second.since_keyframe + 1 < keyframe_interval_ && !it->second.payload.empty();
+        if (delta) {
+            detail::encode_delta(it->second.payload.data(), payload, size, out);
+            delta = out.size() - body < size;
+            if (!delta) {
+                out.resize(body);
+            }
+        }
+        if (!delta) {
+            detail::append_bytes(out, payload, size);
+        }
+        return delta;
+    }
+
+    /// Makes `payload` the key's base after its prepare()d frame was written.
+    void commit(std::string_view key, std::uint64_t type_hash, const std::byte* payload, std::size_t size, bool delta)
+    {
+        lookup_.assign(key.data(), key.size());
+        auto& state = states_[lookup_];
+        state.type_hash = type_hash;
+        state.payload.assign(payload, payload + size);
+        state.since_keyframe = delta ? state.since_keyframe + 1 : 0;
+    }
+
+    void reset() { states_.clear(); }
+    [[nodiscard]] std::size_t keys() const noexcept { return states_.size(); }
+
+private:
+    struct KeyState
+    {
+        std::uint64_t type_hash{0};
+        std::vector<std::byte> payload;
+        std::size_t since_keyframe{0};
+    };
+
+    std::size_t keyframe_interval_;
+    std::unordered_map<std::string, KeyState> states_;
+    std::string lookup_;
+};
+
+class DeltaDecoder
+{
+public:
+    /// Rebuilds the payload of a frame into `payload`; false if a delta's base was never seen.
+    bool decode(bool delta, std::uint64_t type_hash, const std::byte* frame, std::size_t size,
+                std::vector<std::byte>& payload)
+    {
+        std::uint32_t key_size = 0;
+        if (size < sizeof(key_size)) {
+            return false;
+        }
+        std::memcpy(&key_size, frame, sizeof(key_size));
+        if (size - sizeof(key_size) < key_size) {
+            return false;
+        }
+        std::string key(reinterpret_cast<const char*>(frame + sizeof(key_size)), key_size);
+        const std::byte* body = frame + sizeof(key_size) + key_size;
+        const std::size_t body_size = size - sizeof(key_size) - key_size;
+
+        if (!delta) {
+            auto& state = states_[std::move(key)];
+            state.type_hash = type_hash;
+            state.payload.assign(body, body + body_size);
+            payload = state.payload;
+            return true;
+        }
+
+        auto it = states_.find(key);
+        if (it == states_.end() || it->second.type_hash != type_hash ||
+            !detail::apply_delta(it->second.payload.data(), it->second.payload.size(), body, body_size)) {
+            return false;
+        }
+        payload = it->second.payload;
+        return true;
+    }
+
+    void reset() { states_.clear(); }
+
+private:
+    struct KeyState
+    {
+        std::uint64_t type_hash{0};
+        std::vector<std::byte> payload;
+    };
+
+    std::unordered_map<std::string, KeyState> states_;
+};
+
+enum class JournalBackend
+{
+    automatic,
+    io_uring,
+    thread
+};
+
+/**
+ * @brief Group commit knobs for durable appends
+ *
+ * When a durable waiter arrives the writer holds the fsync for up to
+ * `max_delay` to collect more durable appends, committing early once
+ * `max_waiters` are blocked. Zero delay syncs as soon as the writer wakes.
+ */
+struct GroupCommitOptions
+{
+    std::chrono::microseconds max_delay{0};
+    std::size_t max_waiters{64};
+};
+
+/// A durable prefix of a journal: `offset` bytes holding records up to `sequence`.
+struct JournalCheckpoint
+{
+    std::uint64_t offset{0};
+    std::uint64_t sequence{0};
+};
+
+struct JournalOptions
+{
+    std::size_t ring_bytes{std::size_t{16} * 1024 * 1024};
+    std::size_t max_batch_bytes{std::size_t{1} * 1024 * 1024};
+    HugePagePolicy huge_pages{HugePagePolicy::transparent};
+    JournalBackend backend{JournalBackend::automatic};
+    GroupCommitOptions group_commit{};
+    bool truncate{false};
+    std::optional<JournalCheckpoint> resume_from;    // skip scanning the prefix on open
+    bool delta_encoding{false};                     // per-key deltas against the topic's previous record
+    std::size_t keyframe_interval{64};
+};
+
+struct JournalStats
+{
+    std::uint64_t records;
+    std::uint64_t bytes;
+    std::uint64_t batches;
+    std::uint64_t syncs;
+    std::uint64_t write_errors;
+    std::uint64_t publisher_waits;
+    std::uint64_t durable_waits;
+    std::uint64_t delta_records;
+    std::uint64_t delta_bytes_saved;
+};
+
+/**
+ * @brief Append-only event journal with a background writer
+ *
+ * Publishers serialize into a thread-local scratch buffer and copy the record
+ * into a ring under a short lock; a single writer thread drains whole records
+ * in batches through io_uring (when available) or pwrite/fdatasync. Opening an
+ * existing journal drops a torn tail record and continues its sequence.
+ */
+class EventJournal
+{
+public:
+    explicit EventJournal(std::string path, JournalOptions options = {})
+        : path_(std::move(path)), options_(options), ring_(options.ring_bytes, options.huge_pages)
+    {
+        open_file();
+        start_sink();
+        writer_ = std::thread([this]() { writer_loop(); });
+    }
+
+    ~EventJournal()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_cv_.notify_one();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        sink_.reset();
+        close_file();
+    }
+
+    EventJournal(const EventJournal&) = delete;
+    EventJournal& operator=(const EventJournal&) = delete;
+
+    template <typename... Args>
+    std::uint64_t append(std::string_view topic, const Args&... args)
+    {
+        static_assert(detail::is_journal_serializable_v<Args...>,
+                      "Journal payloads must be trivially copyable or strings");
+        if (options_.delta_encoding) {
+            thread_local std::vector<std::byte> payload;
+            payload.clear();
+            detail::encode_payload(payload, args...);
+            return append_delta(topic, detail::compaction_key(args...), detail::journal_type_hash<Args...>(),
+                                payload);
+        }
+
+        auto& record = detail::journal_scratch();
+        detail::begin_record(record, topic);
+        detail::encode_payload(record, args...);
+        detail::finish_record(record, topic.size(), detail::journal_type_hash<Args...>(), 0);
+        return commit_record(record);
+    }
+
+    /// Appends an already encoded payload (used by replication and compaction paths).
+    std::uint64_t append_encoded(std::string_view topic, std::uint64_t type_hash,
+                                 const void* payload, std::size_t size, std::uint16_t flags = 0)
+    {
+        auto& record = detail::journal_scratch();
+        detail::begin_record(record, topic);
+        detail::append_bytes(record, payload, size);
+        detail::finish_record(record, topic.size(), type_hash, flags);
+        return commit_record(record);
+    }
+
+    /**
+     * Waits until every record appended so far has been written. Returns
+     * false early if a write covering those records fails during the call;
+     * the records stay queued and the writer keeps retrying them.
+     */
+    bool flush()
+    {
+        const std::uint64_t target = last_sequence();
+        std::unique_lock<std::mutex> lock(progress_mutex_);
+        const std::uint64_t failures = failures_;
+        progress_cv_.wait(lock, [this, target, failures]() {
+            return written_sequence_ >= target || failed_since(failures, target);
+        });
+        return written_sequence_ >= target;
+    }
+
+    /// Waits until every record appended so far is durable on disk.
+    bool sync()
+    {
+        return wait_durable(last_sequence());
+    }
+
+    /**
+     * Waits until the record with `sequence` is durable; concurrent waiters
+     * share one fsync. Returns false if a write or sync covering the record
+     * fails first. Waiters for later records keep waiting, and the writer
+     * keeps retrying.
+     */
+    bool wait_durable(std::uint64_t sequence)
+    {
+        std::uint64_t failures = 0;
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex_);
+            if (synced_sequence_ >= sequence) {
+                return true;
+            }
+            failures = failures_;
+        }
+
+        stats_.durable_waits.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            sync_requested_ = std::max(sync_requested_, sequence);
+            ++durable_waiters_;
+        }
+        wake_cv_.notify_one();
+
+        bool durable = false;
+        {
+            std::unique_lock<std::mutex> lock(progress_mutex_);
+            progress_cv_.wait(lock, [this, sequence, failures]() {
+                return synced_sequence_ >= sequence || failed_since(failures, sequence);
+            });
+            durable = synced_sequence_ >= sequence;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            --durable_waiters_;
+        }
+        return durable;
+    }
+
+    [[nodiscard]] std::uint64_t synced_sequence() const
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        return synced_sequence_;
+    }
+
+    [[nodiscard]] std::uint64_t last_sequence() const
+    {
+        return last_sequence_.load(std::memory_order_acquire);
+    }
+
+    /// The synced prefix; reopening with JournalOptions::resume_from only scans past it.
+    [[nodiscard]] JournalCheckpoint checkpoint() const
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        return JournalCheckpoint{synced_offset_, synced_sequence_};
+    }
+
+    [[nodiscard]] JournalBackend backend() const noexcept { return backend_; }
+    [[nodiscard]] const std::string& path() const noexcept { return path_; }
+    [[nodiscard]] const JournalOptions& options() const noexcept { return options_; }
+
+    [[nodiscard]] JournalStats stats() const
+    {
+        return JournalStats{
+            stats_.records.load(std::memory_order_relaxed),
+            stats_.bytes.load(std::memory_order_relaxed),
+            stats_.batches.load(std::memory_order_relaxed),
+            stats_.syncs.load(std::memory_order_relaxed),
+            stats_.write_errors.load(std::memory_order_relaxed),
+            stats_.publisher_waits.load(std::memory_order_relaxed),
+            stats_.durable_waits.load(std::memory_order_relaxed),
+            stats_.delta_records.load(std::memory_order_relaxed),
+            stats_.delta_bytes_saved.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct AtomicStats
+    {
+        std::atomic<std::uint64_t> records{0};
+        std::atomic<std::uint64_t> bytes{0};
+        std::atomic<std::uint64_t> batches{0};
+        std::atomic<std::uint64_t> syncs{0};
+        std::atomic<std::uint64_t> write_errors{0};
+        std::atomic<std::uint64_t> publisher_waits{0};
+        std::atomic<std::uint64_t> durable_waits{0};
+        std::atomic<std::uint64_t> delta_records{0};
+        std::atomic<std::uint64_t> delta_bytes_saved{0};
+    };
+
+    /// Delta state must advance in journal order, so encoding and commit share one lock.
+    std::uint64_t append_delta(std::string_view topic, std::string_view key, std::uint64_t type_hash,
+                               const std::vector<std::byte>& payload)
+    {
+        auto& record = detail::journal_scratch();
+        detail::begin_record(record, topic);
+
+        std::lock_guard<std::mutex> lock(delta_mutex_);
+        auto it = delta_encoders_.find(topic);
+        if (it == delta_encoders_.end()) {
+            it = delta_encoders_.emplace(std::string(topic), DeltaEncoder(options_.keyframe_interval)).first;
+        }
+        const std::size_t frame_start = record.size();
+        const bool delta = it->second.prepare(key, type_hash, payload.data(), payload.size(), record);
+        const std::size_t frame_size = record.size() - frame_start;
+        detail::finish_record(record, topic.size(), type_hash,
+                              delta ? detail::journal_flag_delta : detail::journal_flag_keyframe);
+        // Throws for an oversize record; the key's base must then stay what the journal last holds.
+        const std::uint64_t sequence = commit_record(record);
+        it->second.commit(key, type_hash, payload.data(), payload.size(), delta);
+        if (delta) {
+            stats_.delta_records.fetch_add(1, std::memory_order_relaxed);
+            stats_.delta_bytes_saved.fetch_add(payload.size() + sizeof(std::uint32_t) + key.size() - frame_size,
+                                               std::memory_order_relaxed);
+        }
+        return sequence;
+    }
+
+    std::uint64_t commit_record(std::vector<std::byte>& record)
+    {
+        if (record.size() > ring_.capacity()) {
+            throw std::length_error("Journal record larger than journal ring");
+        }
+
+        std::uint64_t sequence = 0;
+        {
+            std::unique_lock<std::mutex> lock(append_mutex_);
+            if (ring_.capacity() - ring_.size() < record.size()) {
+                stats_.publisher_waits.fetch_add(1, std::memory_order_relaxed);
+                wake_writer();
+                space_cv_.wait(lock, [this, &record]() {
+                    return ring_.capacity() - ring_.size() >= record.size();
+                });
+            }
+
+            sequence = ++next_sequence_;
+            detail::seal_record(record, sequence);
+            (void)ring_.try_write(record.data(), record.size());
+            last_sequence_.store(sequence, std::memory_order_release);
+        }
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writer_waiting_.load(std::memory_order_relaxed)) {
+            wake_writer();
+        }
+        return sequence;
+    }
+
+    void wake_writer()
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+
+    void writer_loop()
+    {
+        detail::ByteRing::Span spans[2];
+        bool failed = false;
+        for (;;) {
+            bool stopping = false;
+            std::uint64_t sync_target = 0;
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                writer_waiting_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (failed) {
+                    // Back off before retrying what failed; the data is still in the ring.
+                    wake_cv_.wait_for(lock, retry_delay, [this]() { return stopping_; });
+                } else {
+                    wake_cv_.wait_for(lock, std::chrono::milliseconds(10), [this]() {
+                        return stopping_ || ring_.size() > 0 || sync_requested_ > synced_sequence_;
+                    });
+                }
+                writer_waiting_.store(false, std::memory_order_relaxed);
+
+                // Group commit: give other durable publishers a chance to join this fsync.
+                const auto& group = options_.group_commit;
+                if (!stopping_ && sync_requested_ > synced_sequence_ && group.max_delay.count() > 0) {
+                    wake_cv_.wait_for(lock, group.max_delay, [this, &group]() {
+                        return stopping_ || durable_waiters_ >= group.max_waiters;
+                    });
+                }
+                stopping = stopping_;
+                sync_target = sync_requested_;
+            }
+
+            // Drain only what is present now so a sync request cannot starve under load.
+            const std::size_t available = ring_.size();
+            std::size_t drained = 0;
+            failed = false;
+            while (drained < available) {
+                std::uint64_t last_in_batch = 0;
+                std::size_t records = 0;
+                const std::size_t batch_bytes = collect_batch(available - drained, last_in_batch, records);
+                auto readable = ring_.readable();
+                spans[0] = readable.first;
+                spans[0].size = std::min(spans[0].size, batch_bytes);
+                spans[1] = detail::ByteRing::Span{readable.second.data, batch_bytes - spans[0].size};
+
+                const bool sync = drained + batch_bytes >= available && sync_target > synced_sequence_snapshot();
+                const detail::SinkStatus status = write_batch(spans, batch_bytes, last_in_batch, records, sync);
+                if (status == detail::SinkStatus::write_failed) {
+                    report_failure(last_sequence_in(available - drained));
+                    failed = true;
+                    break;
+                }
+                drained += batch_bytes;
+                if (status == detail::SinkStatus::sync_failed) {
+                    // Everything written but unsynced was riding on this fsync; the next pass syncs again.
+                    report_failure(written_sequence_snapshot());
+                    failed = true;
+                }
+            }
+
+            if (available == 0 && sync_target > synced_sequence_snapshot() &&
+                write_batch(spans, 0, 0, 0, true) != detail::SinkStatus::ok) {
+                report_failure(written_sequence_snapshot());
+                failed = true;
+            }
+
+            // A journal being destroyed gives failing records one last attempt, then drops them.
+            if (stopping && (ring_.size() == 0 || failed)) {
+                break;
+            }
+        }
+    }
+
+    /// Last sequence among the first @p limit bytes of the ring.
+    std::uint64_t last_sequence_in(std::size_t limit)
+    {
+        std::uint64_t last = 0;
+        std::size_t total = 0;
+        detail::JournalRecordHeader header{};
+        while (total < limit && ring_.peek(total, &header, sizeof(header))) {
+            total += header.size;
+            last = header.sequence;
+        }
+        return last;
+    }
+
+    /// Wakes callers waiting on records up to @p through; those records stay queued for the retry.
+    void report_failure(std::uint64_t through)
+    {
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex_);
+            ++failures_;
+            failed_through_ = through;
+        }
+        progress_cv_.notify_all();
+    }
+
+    /// Called with progress_mutex_ held: a write or sync covering @p sequence failed after @p failures.
+    bool failed_since(std::uint64_t failures, std::uint64_t sequence) const
+    {
+        return failures_ != failures && failed_through_ >= sequence;
+    }
+
+    std::size_t collect_batch(std::size_t limit, std::uint64_t& last_sequence, std::size_t& records)
+    {
+        std::size_t total = 0;
+        detail::JournalRecordHeader header{};
+        while (total < limit && ring_.peek(total, &header, sizeof(header))) {
+            if (total > 0 && total + header.size > options_.max_batch_bytes) {
+                break;
+            }
+            total += header.size;
+            last_sequence = header.sequence;
+            ++records;
+        }
+        return total;
+    }
+
+    /**
+     * Writes one batch at the file tail. If the write fails nothing advances
+     * and the batch stays in the ring. If only the sync fails the batch
+     * counts as written, but the synced prefix stays where it was.
+     */
+    detail::SinkStatus write_batch(const detail::ByteRing::Span* spans, std::size_t bytes,
+                                   std::uint64_t last_sequence, std::size_t records, bool sync)
+    {
+        const detail::SinkStatus status =
+            bytes > 0 || sync ? write_to_file(spans, bytes, sync) : detail::SinkStatus::ok;
+        if (status != detail::SinkStatus::ok) {
+            stats_.write_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (status == detail::SinkStatus::write_failed) {
+            return status;
+        }
+
+        file_offset_ += bytes;
+        if (bytes > 0) {
+            ring_.consume(bytes);
+            stats_.records.fetch_add(records, std::memory_order_relaxed);
+            stats_.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            stats_.batches.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(append_mutex_);
+            }
+            space_cv_.notify_all();
+        }
+        const bool synced = sync && status == detail::SinkStatus::ok;
+        if (synced) {
+            stats_.syncs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex_);
+            written_sequence_ = std::max(written_sequence_, last_sequence);
+            written_offset_ = file_offset_;
+            if (synced) {
+                synced_sequence_ = written_sequence_;
+                synced_offset_ = written_offset_;
+            }
+        }
+        progress_cv_.notify_all();
+        return status;
+    }
+
+    std::uint64_t synced_sequence_snapshot()
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        return synced_sequence_;
+    }
+
+    std::uint64_t written_sequence_snapshot()
+    {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        return written_sequence_;
+    }
+
+    /**
+     * Scans existing records: continues the sequence and truncates from the
+     * first torn or corrupt record (bad size or CRC). A checkpoint that still
+     * matches the file skips the scan of its prefix.
+     */
+    void recover(std::uint64_t file_size)
+    {
+        std::uint64_t offset = 0;
+        detail::JournalRecordHeader header{};
+        if (options_.resume_from && !options_.truncate && resumable(*options_.resume_from, file_size)) {
+            offset = options_.resume_from->offset;
+            next_sequence_ = options_.resume_from->sequence;
+        }
+        std::vector<std::byte> body;
+        while (offset + sizeof(header) <= file_size && read_at(offset, &header, sizeof(header)) &&
+               header.size >= sizeof(header) && offset + header.size <= file_size) {
+            body.resize(header.size - sizeof(header));
+            if (!read_at(offset + sizeof(header), body.data(), body.size()) ||
+                !detail::record_intact(header, body.data())) {
+                break;
+            }
+            next_sequence_ = header.sequence;
+            offset += header.size;
+        }
+        file_offset_ = offset;
+        if (offset != file_size) {
+            truncate_at(offset);
+        }
+        last_sequence_.store(next_sequence_, std::memory_order_release);
+        written_sequence_ = synced_sequence_ = next_sequence_;
+        written_offset_ = synced_offset_ = offset;
+    }
+
+    /// The checkpoint must end on a record boundary: the next record, if any, continues its sequence.
+    bool resumable(const JournalCheckpoint& checkpoint, std::uint64_t file_size)
+    {
+        if (checkpoint.offset > file_size) {
+            return false;
+        }
+        if (checkpoint.offset == 0) {
+            return checkpoint.sequence == 0;
+        }
+        detail::JournalRecordHeader header{};
+        if (checkpoint.offset + sizeof(header) <= file_size) {
+            return read_at(checkpoint.offset, &header, sizeof(header)) &&
+                   header.sequence == checkpoint.sequence + 1;
+        }
+        return checkpoint.offset == file_size;
+    }
+
+#if EVENTBUS_HAS_POSIX
+    void open_file()
+    {
+        int flags = O_RDWR | O_CREAT;
+        if (options_.truncate) {
+            flags |= O_TRUNC;
+        }
+        fd_ = ::open(path_.c_str(), flags, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open journal " + path_);
+        }
+        struct stat info {};
+        if (::fstat(fd_, &info) != 0) {
+            const int error = errno;
+            close_file();
+            throw std::system_error(error, std::generic_category(), "Failed to stat journal " + path_);
+        }
+        recover(static_cast<std::uint64_t>(info.st_size));
+    }
+
+    bool read_at(std::uint64_t offset, void* out, std::size_t size)
+    {
+        return ::pread(fd_, out, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+    }
+
+    void truncate_at(std::uint64_t offset)
+    {
+        if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+            stats_.write_errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void start_sink()
+    {
+#if EVENTBUS_HAS_IO_URING
+        if (options_.backend != JournalBackend::thread) {
+            auto sink = std::make_unique<detail::IoUringJournalSink>(fd_, ring_.buffer());
+            if (sink->init()) {
+                sink_ = std::move(sink);
+                backend_ = JournalBackend::io_uring;
+                return;
+            }
+        }
+#endif
+        sink_ = std::make_unique<detail::ThreadJournalSink>(fd_);
+        backend_ = JournalBackend::thread;
+    }
+
+    void close_file()
+    {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    detail::SinkStatus write_to_file(const detail::ByteRing::Span* spans, std::size_t bytes, bool sync)
+    {
+        return sink_->write(spans, bytes > 0 ? 2 : 0, file_offset_, sync);
+    }
+#else
+    void open_file()
+    {
+        // Not "a+b": append mode ignores the seek that positions (and retries) each batch.
+        file_ = options_.truncate ? nullptr : std::fopen(path_.c_str(), "r+b");
+        if (file_ == nullptr) {
+            file_ = std::fopen(path_.c_str(), "w+b");
+        }
+        if (file_ == nullptr) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open journal " + path_);
+        }
+        std::fseek(file_, 0, SEEK_END);
+        recover(static_cast<std::uint64_t>(std::ftell(file_)));
+    }
+
+    bool read_at(std::uint64_t offset, void* out, std::size_t size)
+    {
+        return std::fseek(file_, static_cast<long>(offset), SEEK_SET) == 0 &&
+               std::fread(out, 1, size, file_) == size;
+    }
+
+    void truncate_at(std::uint64_t)
+    {
+        // stdio cannot truncate; readers stop at the torn record instead.
+    }
+
+    void start_sink()
+    {
+        backend_ = JournalBackend::thread;
+    }
+
+    void close_file()
+    {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    detail::SinkStatus write_to_file(const detail::ByteRing::Span* spans, std::size_t bytes, bool sync)
+    {
+        // Positioned at the tracked tail so a retried batch overwrites its own partial bytes.
+        if (std::fseek(file_, static_cast<long>(file_offset_), SEEK_SET) != 0) {
+            return detail::SinkStatus::write_failed;
+        }
+        if (bytes > 0) {
+            for (int i = 0; i < 2; ++i) {
+                if (std::fwrite(spans[i].data, 1, spans[i].size, file_) != spans[i].size) {
+                    return detail::SinkStatus::write_failed;
+                }
+            }
+        }
+        return !sync || std::fflush(file_) == 0 ? detail::SinkStatus::ok : detail::SinkStatus::sync_failed;
+    }
+
+    std::FILE* file_{nullptr};
+#endif
+
+    std::string path_;
+    JournalOptions options_;
+    detail::ByteRing ring_;
+    std::unique_ptr<detail::JournalSink> sink_;
+    JournalBackend backend_{JournalBackend::thread};
+    int fd_{-1};
+    std::uint64_t file_offset_{0};
+
+    std::mutex append_mutex_;
+    std::condition_variable space_cv_;
+    std::uint64_t next_sequence_{0};
+    std::atomic<std::uint64_t> last_sequence_{0};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> writer_waiting_{false};
+    bool stopping_{false};
+    std::uint64_t sync_requested_{0};
+    std::size_t durable_waiters_{0};
+
+    static constexpr std::chrono::milliseconds retry_delay{10};
+
+    mutable std::mutex progress_mutex_;
+    std::condition_variable progress_cv_;
+    std::uint64_t written_sequence_{0};
+    std::uint64_t synced_sequence_{0};
+    std::uint64_t written_offset_{0};
+    std::uint64_t synced_offset_{0};
+    std::uint64_t failures_{0};             // failed write or sync attempts
+    std::uint64_t failed_through_{0};       // last sequence the latest failed attempt covered
+
+    std::mutex delta_mutex_;
+    std::map<std::string, DeltaEncoder, std::less<>> delta_encoders_;
+
+    AtomicStats stats_;
+    std::thread writer_;
+};
+
+struct JournalRecord
+{
+    std::uint64_t sequence{0};
+    std::uint64_t type_hash{0};
+    std::uint16_t flags{0};
+    std::string topic;
+    std::vector<std::byte> payload;
+
+    /// Decodes the payload as the given argument types; strings decode to std::string.
+    template <typename... Args>
+    [[nodiscard]] std::optional<std::tuple<detail::journal_value_t<Args>...>> decode() const
+    {
+        if (type_hash != detail::journal_type_hash<Args...>()) {
+            return std::nullopt;
+        }
+        std::tuple<detail::journal_value_t<Args>...> values;
+        if (!detail::decode_tuple(payload.data(), payload.size(), values,
+                                  std::index_sequence_for<Args...>{})) {
+            return std::nullopt;
+        }
+        return values;
+    }
+};
+
+/**
+ * @brief Sequential reader for files written by EventJournal
+ */
+class JournalReader
+{
+public:
+    explicit JournalReader(const std::string& path)
+        : file_(std::fopen(path.c_str(), "rb"))
+    {
+        if (file_ == nullptr) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open journal " + path);
+        }
+    }
+
+    ~JournalReader()
+    {
+        std::fclose(file_);
+    }
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    /// Reads the next complete record; returns false at end of file or at a torn or corrupt record.
+    bool next(JournalRecord& record)
+    {
+        detail::JournalRecordHeader header{};
+        if (std::fread(&header, 1, sizeof(header), file_) != sizeof(header) ||
+            header.size < sizeof(header) + header.topic_size) {
+            return false;
+        }
+
+        body_.resize(header.size - sizeof(header));
+        if (std::fread(body_.data(), 1, body_.size(), file_) != body_.size() ||
+            !detail::record_intact(header, body_.data())) {
+            return false;
+        }
+        record.sequence = header.sequence;
+        record.type_hash = header.type_hash;
+        record.flags = header.flags;
+        record.topic.assign(reinterpret_cast<const char*>(body_.data()), header.topic_size);
+        record.payload.assign(body_.begin() + header.topic_size, body_.end());
+
+        // Delta-encoded journals: rebuild the full payload; an undecodable delta yields an empty one.
+        if ((header.flags & (detail::journal_flag_keyframe | detail::journal_flag_delta)) != 0) {
+            const std::vector<std::byte> frame = std::move(record.payload);
+            record.payload.clear();
+            if (!decoders_[record.topic].decode((header.flags & detail::journal_flag_delta) != 0,
+                                                header.type_hash, frame.data(), frame.size(), record.payload)) {
+                record.payload.clear();
+            }
+        }
+        return true;
+    }
+
+    /// Byte offset of the next record.
+    [[nodiscard]] std::uint64_t offset() const
+    {
+        return static_cast<std::uint64_t>(std::ftell(file_));
+    }
+
+private:
+    std::FILE* file_;
+    std::vector<std::byte> body_;
+    std::unordered_map<std::string, DeltaDecoder> decoders_;
+};
+
+// ---------------------------------------------------------------------------
+// Log-structured topics
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+#if EVENTBUS_HAS_POSIX
+
+/**
+ * @brief Read-write shared mapping of a file, created or extended to `size`
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    MappedFile(const std::string& path, std::size_t size)
+        : path_(path)
+    {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path);
+        }
+
+        struct stat info {};
+        if (::fstat(fd_, &info) != 0 ||
+            (static_cast<std::size_t>(info.st_size) < size &&
+             ::ftruncate(fd_, static_cast<off_t>(size)) != 0)) {
+            const int error = errno;
+            ::close(fd_);
+            throw std::system_error(error, std::generic_category(), "Failed to size " + path);
+        }
+
+        size_ = std::max(size, static_cast<std::size_t>(info.st_size));
+        void* memory = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (memory == MAP_FAILED) {
+            const int error = errno;
+            ::close(fd_);
+            throw std::system_error(error, std::generic_category(), "Failed to map " + path);
+        }
+        data_ = static_cast<std::byte*>(memory);
+    }
+
+    ~MappedFile()
+    {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        if (remove_on_close_) {
+            ::unlink(path_.c_str());
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] std::byte* data() noexcept { return data_; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] const std::string& path() const noexcept { return path_; }
+
+    void remove_on_close() noexcept { remove_on_close_ = true; }
+
+private:
+    std::string path_;
+    int fd_{-1};
+    std::byte* data_{nullptr};
+    std::size_t size_{0};
+    bool remove_on_close_{false};
+};
+
+#endif // EVENTBUS_HAS_POSIX
+
+inline std::string sanitize_file_name(std::string_view name)
+{
+    std::string result(name);
+    for (char& c : result) {
+        const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                          (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '_';
+        if (!safe) {
+            c = '_';
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief One fixed-capacity chunk of an EventLog
+ *
+ * Single writer (the log's append lock holder), many lock-free readers:
+ * `bytes` is published with release after the record is copied, and
+ * `sealed` after the final append, so a reader that observes `sealed`
+ * also observes the final byte count.
+ */
+struct LogSegment
+{
+    LogSegment(std::uint64_t base, std::size_t capacity, HugePagePolicy policy)
+        : base_offset(base), memory(capacity, policy), data(memory.data()), capacity(memory.size())
+    {
+    }
+
+#if EVENTBUS_HAS_POSIX
+    LogSegment(std::uint64_t base, const std::string& path, std::size_t capacity)
+        : base_offset(base), file(std::make_unique<MappedFile>(path, capacity)),
+          data(file->data()), capacity(file->size())
+    {
+    }
+#endif
+
+    ~LogSegment()
+    {
+        if (!spill_path.empty()) {
+            std::remove(spill_path.c_str());
+        }
+    }
+
+    LogSegment(const LogSegment&) = delete;
+    LogSegment& operator=(const LogSegment&) = delete;
+
+    std::uint64_t base_offset;
+    PageBuffer memory;
+#if EVENTBUS_HAS_POSIX
+    std::unique_ptr<MappedFile> file;
+#endif
+    std::byte* data;
+    std::size_t capacity;
+    std::atomic<std::size_t> bytes{0};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<bool> sealed{false};
+
+    // Spilled segments have released `memory`; their records live in `spill_path`.
+    // Only changed while no reader holds the segment.
+    std::atomic<bool> spilled{false};
+    std::string spill_path;
+    std::mutex reload_mutex;
+    std::weak_ptr<std::vector<std::byte>> reloaded;
+
+    /// Byte position of record `offset` in `records`; walks headers, so only used for seeks.
+    std::size_t position_of(const std::byte* records, std::uint64_t offset) const
+    {
+        std::size_t position = 0;
+        const std::size_t committed = bytes.load(std::memory_order_acquire);
+        for (std::uint64_t current = base_offset; current < offset && position < committed; ++current) {
+            JournalRecordHeader header{};
+            std::memcpy(&header, records + position, sizeof(header));
+            position += header.size;
+        }
+        return position;
+    }
+};
+
+struct SpillFileHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t base_offset;
+    std::uint64_t count;
+    std::uint64_t bytes;
+};
+
+inline constexpr std::uint32_t spill_file_magic = 0x50534245; // "EBSP"
+
+/// Writes the committed records of a sealed segment; the records are already in their compact form.
+inline bool write_spill_file(const std::string& path, const LogSegment& segment)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const SpillFileHeader header{spill_file_magic, 1, segment.base_offset,
+                                 segment.count.load(std::memory_order_acquire),
+                                 segment.bytes.load(std::memory_order_acquire)};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(segment.data, 1, header.bytes, file) == header.bytes;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(path.c_str());
+    }
+    return ok;
+}
+
+/// Streams a spilled segment back; readers of the same segment share one copy.
+inline std::shared_ptr<std::vector<std::byte>> reload_spilled(LogSegment& segment)
+{
+    std::lock_guard<std::mutex> lock(segment.reload_mutex);
+    if (auto cached = segment.reloaded.lock()) {
+        return cached;
+    }
+
+    std::FILE* file = std::fopen(segment.spill_path.c_str(), "rb");
+    if (file == nullptr) {
+        return nullptr;
+    }
+    SpillFileHeader header{};
+    std::shared_ptr<std::vector<std::byte>> records;
+    if (std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == spill_file_magic &&
+        header.base_offset == segment.base_offset) {
+        records = std::make_shared<std::vector<std::byte>>(header.bytes);
+        if (std::fread(records->data(), 1, header.bytes, file) != header.bytes) {
+            records.reset();
+        }
+    }
+    std::fclose(file);
+    segment.reloaded = records;
+    return records;
+}
+
+} // namespace detail
+
+enum class LogStart
+{
+    earliest,
+    latest
+};
+
+struct LogTopicOptions
+{
+    std::size_t segment_bytes{std::size_t{4} * 1024 * 1024};
+    std::size_t retain_segments{4};  // consumed sealed segments kept for rewind
+    std::size_t max_segments{0};     // hard cap on segments; 0 means unbounded
+    HugePagePolicy huge_pages{HugePagePolicy::transparent};
+    std::string directory;           // non-empty: segments are mmap-backed files here (POSIX)
+    std::size_t memory_budget_bytes{0}; // resident segment bytes before spilling; 0 means unbounded
+    std::string spill_directory;     // where over-budget segments are spilled; required for spilling
+};
+
+struct LogStats
+{
+    std::size_t segments;
+    std::size_t resident_bytes;
+    std::size_t spilled_segments;
+    std::uint64_t spilled_bytes;
+    std::uint64_t spill_failures;
+};
+
+template <typename... Args>
+class LogCursor;
+
+/**
+ * @brief Segmented append-only log read through independent cursors
+ *
+ * Producers append under a short lock and never wait for consumers. Each
+ * cursor reads at its own pace; sealed segments are released once every
+ * cursor has passed them and more than `retain_segments` are kept, or when
+ * `max_segments` is exceeded, in which case lagging cursors skip ahead and
+ * report the loss.
+ *
+ * With a memory budget, in-memory segments that no cursor is reading are
+ * spilled oldest-first to `spill_directory` by a background thread and
+ * streamed back in order when a cursor reaches them, so a stalled consumer
+ * costs disk rather than memory and appends never wait for the disk.
+ */
+class EventLog : public std::enable_shared_from_this<EventLog>
+{
+public:
+    explicit EventLog(std::string name, LogTopicOptions options = {})
+        : name_(std::move(name)), options_(std::move(options))
+    {
+        recover_segments();
+    }
+
+    ~EventLog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(spill_mutex_);
+            spill_stop_ = true;
+        }
+        spill_cv_.notify_all();
+        if (spill_thread_.joinable()) {
+            spill_thread_.join();
+        }
+    }
+
+    [[nodiscard]] const LogTopicOptions& options() const noexcept { return options_; }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    template <typename... Args>
+    std::uint64_t append(const Args&... args)
+    {
+        auto& record = detail::journal_scratch();
+        detail::begin_record(record, {});
+        detail::encode_payload(record, args...);
+        detail::finish_record(record, 0, detail::journal_type_hash<Args...>(), 0);
+        return commit_record(record);
+    }
+
+    std::uint64_t append_encoded(std::uint64_t type_hash, const void* payload, std::size_t size)
+    {
+        auto& record = detail::journal_scratch();
+        detail::begin_record(record, {});
+        detail::append_bytes(record, payload, size);
+        detail::finish_record(record, 0, type_hash, 0);
+        return commit_record(record);
+    }
+
+    template <typename... Args>
+    [[nodiscard]] LogCursor<Args...> open_cursor(LogStart start = LogStart::latest);
+
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+
+    [[nodiscard]] std::uint64_t begin_offset() const
+    {
+        return begin_offset_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::uint64_t end_offset() const
+    {
+        return end_offset_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::size_t segment_count() const
+    {
+        std::shared_lock<std::shared_mutex> lock(segments_mutex_);
+        return segments_.size();
+    }
+
+    [[nodiscard]] LogStats stats() const
+    {
+        LogStats stats{};
+        std::shared_lock<std::shared_mutex> lock(segments_mutex_);
+        stats.segments = segments_.size();
+        for (const auto& segment : segments_) {
+            if (segment->spilled.load(std::memory_order_relaxed)) {
+                ++stats.spilled_segments;
+            } else {
+                stats.resident_bytes += segment->memory.size();
+            }
+        }
+        stats.spilled_bytes = spilled_bytes_.load(std::memory_order_relaxed);
+        stats.spill_failures = spill_failures_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    template <typename... Args>
+    friend class LogCursor;
+
+    using SegmentPtr = std::shared_ptr<detail::LogSegment>;
+
+    struct CursorState
+    {
+        explicit CursorState(std::uint64_t start) : position(start) {}
+        std::atomic<std::uint64_t> position;
+    };
+
+    std::uint64_t commit_record(std::vector<std::byte>& record)
+    {
+        std::lock_guard<std::mutex> lock(append_mutex_);
+        if (!active_ || active_->bytes.load(std::memory_order_relaxed) + record.size() > active_->capacity) {
+            roll(record.size());
+        }
+
+        const std::uint64_t offset = end_offset_.load(std::memory_order_relaxed);
+        detail::seal_record(record, offset);
+        const std::size_t position = active_->bytes.load(std::memory_order_relaxed);
+        std::memcpy(active_->data + position, record.data(), record.size());
+        active_->count.fetch_add(1, std::memory_order_relaxed);
+        active_->bytes.store(position + record.size(), std::memory_order_release);
+        end_offset_.store(offset + 1, std::memory_order_release);
+        return offset;
+    }
+
+    void roll(std::size_t record_size)
+    {
+        const std::size_t capacity = std::max(options_.segment_bytes, record_size);
+        if (active_) {
+            active_->sealed.store(true, std::memory_order_release);
+        }
+
+        auto segment = make_segment(end_offset_.load(std::memory_order_relaxed), capacity);
+        {
+            std::unique_lock<std::shared_mutex> lock(segments_mutex_);
+            segments_.push_back(segment);
+            enforce_retention();
+        }
+        active_ = std::move(segment);
+
+        if (options_.memory_budget_bytes != 0 && !options_.spill_directory.empty()) {
+            request_spill();
+        }
+    }
+
+    /// Wakes the spill thread (starting it on first use); never blocks on file I/O.
+    void request_spill()
+    {
+        {
+            std::lock_guard<std::mutex> lock(spill_mutex_);
+            spill_pending_ = true;
+            if (!spill_thread_.joinable()) {
+                spill_thread_ = std::thread([this]() { spill_loop(); });
+            }
+        }
+        spill_cv_.notify_one();
+    }
+
+    void spill_loop()
+    {
+        std::unique_lock<std::mutex> lock(spill_mutex_);
+        while (true) {
+            spill_cv_.wait(lock, [this]() { return spill_pending_ || spill_stop_; });
+            if (spill_stop_) {
+                return;
+            }
+            spill_pending_ = false;
+            lock.unlock();
+            enforce_memory_budget();
+            lock.lock();
+        }
+    }
+
+    /// Spills the oldest idle in-memory segments until resident bytes fit the budget.
+    /// Runs on the spill thread; the newest segment is the one being appended to.
+    void enforce_memory_budget()
+    {
+        std::vector<SegmentPtr> candidates;
+        {
+            std::shared_lock<std::shared_mutex> lock(segments_mutex_);
+            std::size_t resident = 0;
+            for (const auto& segment : segments_) {
+                if (!segment->spilled.load(std::memory_order_relaxed)) {
+                    resident += segment->memory.size();
+                }
+            }
+            for (const auto& segment : segments_) {
+                if (resident <= options_.memory_budget_bytes) {
+                    break;
+                }
+                if (segment != segments_.back() && !segment->memory.empty() &&
+                    !segment->spilled.load(std::memory_order_relaxed)) {
+                    candidates.push_back(segment);
+                    resident -= segment->memory.size();
+                }
+            }
+        }
+
+        // File I/O happens without the segment lock; readers keep going meanwhile.
+        for (auto& segment : candidates) {
+            const std::string path = spill_path(segment->base_offset);
+            if (!detail::write_spill_file(path, *segment)) {
+                spill_failures_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            std::unique_lock<std::shared_mutex> lock(segments_mutex_);
+            // The list, `candidates` and nobody else: no cursor is reading the memory.
+            if (segment.use_count() != 2) {
+                lock.unlock();
+                std::remove(path.c_str());
+                continue;
+            }
+            segment->spill_path = path;
+            segment->memory = PageBuffer{};
+            segment->data = nullptr;
+            segment->spilled.store(true, std::memory_order_release);
+            spilled_bytes_.fetch_add(segment->bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    std::string spill_path(std::uint64_t base) const
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%020llu.spill", static_cast<unsigned long long>(base));
+        return options_.spill_directory + "/" + detail::sanitize_file_name(name_) + suffix;
+    }
+
+    SegmentPtr make_segment(std::uint64_t base, std::size_t capacity)
+    {
+#if EVENTBUS_HAS_POSIX
+        if (!options_.directory.empty()) {
+            return std::make_shared<detail::LogSegment>(base, segment_path(base), capacity);
+        }
+#endif
+        return std::make_shared<detail::LogSegment>(base, capacity, options_.huge_pages);
+    }
+
+    std::string segment_path(std::uint64_t base) const
+    {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%020llu.seg", static_cast<unsigned long long>(base));
+        return options_.directory + "/" + detail::sanitize_file_name(name_) + suffix;
+    }
+
+    /// Called with segments_mutex_ held exclusively.
+    void enforce_retention()
+    {
+        const std::uint64_t slowest = slowest_cursor();
+        while (segments_.size() > 1) {
+            const auto& oldest = segments_.front();
+            const std::uint64_t oldest_end = oldest->base_offset + oldest->count.load(std::memory_order_relaxed);
+            const std::size_t sealed = segments_.size() - 1;
+            const bool consumed = oldest_end <= slowest && sealed > options_.retain_segments;
+            const bool over_cap = options_.max_segments != 0 && segments_.size() > options_.max_segments;
+            if (!consumed && !over_cap) {
+                break;
+            }
+            release_segment(oldest);
+            segments_.erase(segments_.begin());
+        }
+        begin_offset_.store(segments_.front()->base_offset, std::memory_order_release);
+    }
+
+    void release_segment(const SegmentPtr& segment)
+    {
+#if EVENTBUS_HAS_POSIX
+        if (segment->file) {
+            segment->file->remove_on_close();
+        }
+#else
+        (void)segment;
+#endif
+    }
+
+    std::uint64_t slowest_cursor()
+    {
+        std::lock_guard<std::mutex> lock(cursors_mutex_);
+        std::uint64_t slowest = end_offset_.load(std::memory_order_relaxed);
+        cursors_.erase(std::remove_if(cursors_.begin(), cursors_.end(),
+                                      [&slowest](const std::weak_ptr<CursorState>& weak) {
+            auto cursor = weak.lock();
+            if (!cursor) {
+                return true;
+            }
+            slowest = std::min(slowest, cursor->position.load(std::memory_order_relaxed));
+            return false;
+        }), cursors_.end());
+        return slowest;
+    }
+
+    std::shared_ptr<CursorState> register_cursor(std::uint64_t start)
+    {
+        auto state = std::make_shared<CursorState>(start);
+        std::lock_guard<std::mutex> lock(cursors_mutex_);
+        cursors_.push_back(state);
+        return state;
+    }
+
+    /// Segment holding `offset` (or the active segment at the end); clamps offsets that fell out of retention.
+    SegmentPtr locate(std::uint64_t& offset) const
+    {
+        std::shared_lock<std::shared_mutex> lock(segments_mutex_);
+        if (segments_.empty()) {
+            return nullptr;
+        }
+        offset = std::max(offset, segments_.front()->base_offset);
+        auto it = std::upper_bound(segments_.begin(), segments_.end(), offset,
+                                   [](std::uint64_t value, const SegmentPtr& segment) {
+            return value < segment->base_offset;
+        });
+        return *std::prev(it);
+    }
+
+    SegmentPtr next_segment(const SegmentPtr& segment) const
+    {
+        std::shared_lock<std::shared_mutex> lock(segments_mutex_);
+        auto it = std::upper_bound(segments_.begin(), segments_.end(), segment->base_offset,
+                                   [](std::uint64_t value, const SegmentPtr& candidate) {
+            return value < candidate->base_offset;
+        });
+        return it != segments_.end() ? *it : nullptr;
+    }
+
+    /// Reopens mmap-backed segments left by a previous run, oldest first.
+    void recover_segments()
+    {
+#if EVENTBUS_HAS_POSIX
+        if (options_.directory.empty()) {
+            return;
+        }
+        ::mkdir(options_.directory.c_str(), 0755);
+
+        const std::string prefix = detail::sanitize_file_name(name_) + ".";
+        std::vector<std::uint64_t> bases;
+        if (DIR* dir = ::opendir(options_.directory.c_str())) {
+            while (dirent* entry = ::readdir(dir)) {
+                const std::string file = entry->d_name;
+                if (file.size() == prefix.size() + 24 && file.compare(0, prefix.size(), prefix) == 0 &&
+                    file.compare(file.size() - 4, 4, ".seg") == 0) {
+                    bases.push_back(std::strtoull(file.c_str() + prefix.size(), nullptr, 10));
+                }
+            }
+            ::closedir(dir);
+        }
+        std::sort(bases.begin(), bases.end());
+
+        for (std::uint64_t base : bases) {
+            auto segment = std::make_shared<detail::LogSegment>(base, segment_path(base), options_.segment_bytes);
+            std::size_t position = 0;
+            std::uint64_t count = 0;
+            detail::JournalRecordHeader header{};
+            while (position + sizeof(header) <= segment->capacity) {
+                std::memcpy(&header, segment->data + position, sizeof(header));
+                if (header.size < sizeof(header) || position + header.size > segment->capacity ||
+                    header.sequence != base + count ||
+                    !detail::record_intact(header, segment->data + position + sizeof(header))) {
+                    break;
+                }
+                position += header.size;
+                ++count;
+            }
+            segment->bytes.store(position, std::memory_order_relaxed);
+            segment->count.store(count, std::memory_order_relaxed);
+            if (active_) {
+                active_->sealed.store(true, std::memory_order_relaxed);
+            }
+            segments_.push_back(segment);
+            active_ = segment;
+            end_offset_.store(base + count, std::memory_order_relaxed);
+        }
+        if (!segments_.empty()) {
+            begin_offset_.store(segments_.front()->base_offset, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    std::string name_;
+    LogTopicOptions options_;
+
+    std::mutex append_mutex_;
+    SegmentPtr active_;
+
+    mutable std::shared_mutex segments_mutex_;
+    std::vector<SegmentPtr> segments_;
+    std::atomic<std::uint64_t> begin_offset_{0};
+    std::atomic<std::uint64_t> end_offset_{0};
+
+    std::mutex cursors_mutex_;
+    std::vector<std::weak_ptr<CursorState>> cursors_;
+
+    std::atomic<std::uint64_t> spilled_bytes_{0};
+    std::atomic<std::uint64_t> spill_failures_{0};
+
+    std::mutex spill_mutex_;
+    std::condition_variable spill_cv_;
+    bool spill_pending_{false};
+    bool spill_stop_{false};
+    std::thread spill_thread_;
+};
+
+/**
+ * @brief Independent reader position in an EventLog
+ *
+ * `poll()` decodes records as `Args...` (strings as std::string) and invokes
+ * the callback on the calling thread. If the callback throws, the exception
+ * propagates and the record is delivered again by the next poll. Records of
+ * another payload type are skipped and counted in `mismatches()`.
+ */
+template <typename... Args>
+class LogCursor
+{
+public:
+    LogCursor(std::shared_ptr<EventLog> log, std::uint64_t start)
+        : log_(std::move(log)), state_(log_->register_cursor(start)), position_(start)
+    {
+    }
+
+    LogCursor(LogCursor&&) noexcept = default;
+    LogCursor& operator=(LogCursor&&) noexcept = default;
+    LogCursor(const LogCursor&) = delete;
+    LogCursor& operator=(const LogCursor&) = delete;
+
+    template <typename Callback>
+    std::size_t poll(Callback&& callback, std::size_t max_events = static_cast<std::size_t>(-1))
+    {
+        std::size_t delivered = 0;
+        while (delivered < max_events) {
+            if (!segment_ && !reposition()) {
+                break;
+            }
+
+            const std::size_t committed = segment_->bytes.load(std::memory_order_acquire);
+            if (byte_position_ < committed) {
+                detail::JournalRecordHeader header{};
+                std::memcpy(&header, records_ + byte_position_, sizeof(header));
+                const std::byte* payload = records_ + byte_position_ + sizeof(header);
+                const std::size_t payload_size = header.size - sizeof(header);
+
+                std::tuple<detail::journal_value_t<Args>...> values;
+                if (header.type_hash == detail::journal_type_hash<Args...>() &&
+                    detail::decode_tuple(payload, payload_size, values, std::index_sequence_for<Args...>{})) {
+                    std::apply(callback, values);
+                    ++delivered;
+                } else {
+                    ++mismatches_;
+                }
+                byte_position_ += header.size;
+                ++position_;
+                continue;
+            }
+
+            if (!segment_->sealed.load(std::memory_order_acquire) ||
+                byte_position_ < segment_->bytes.load(std::memory_order_acquire)) {
+                break;
+            }
+
+            auto next = log_->next_segment(segment_);
+            if (!next) {
+                break;
+            }
+            byte_position_ = 0;
+            if (next->base_offset > position_) {
+                lost_ += next->base_offset - position_;
+                position_ = next->base_offset;
+            }
+            (void)attach(std::move(next));
+        }
+
+        state_->position.store(position_, std::memory_order_relaxed);
+        return delivered;
+    }
+
+    /// Moves the cursor to `offset`; offsets before the retained range clamp to the oldest record.
+    void seek(std::uint64_t offset)
+    {
+        position_ = offset;
+        segment_.reset();
+        reloaded_.reset();
+        state_->position.store(position_, std::memory_order_relaxed);
+    }
+
+    void rewind(std::uint64_t records)
+    {
+        seek(position_ > records ? position_ - records : 0);
+    }
+
+    [[nodiscard]] std::uint64_t position() const noexcept { return position_; }
+    [[nodiscard]] std::uint64_t lag() const { return log_->end_offset() - position_; }
+    [[nodiscard]] std::uint64_t lost() const noexcept { return lost_; }
+    [[nodiscard]] std::uint64_t mismatches() const noexcept { return mismatches_; }
+
+private:
+    bool reposition()
+    {
+        std::uint64_t offset = position_;
+        auto segment = log_->locate(offset);
+        if (!segment) {
+            return false;
+        }
+        if (offset > position_) {
+            lost_ += offset - position_;
+            position_ = offset;
+        }
+        if (attach(std::move(segment))) {
+            byte_position_ = segment_->position_of(records_, position_);
+        }
+        return true;
+    }
+
+    /// Points the cursor at a segment, streaming it back from disk if it was spilled.
+    /// Returns false if the spilled records could not be read and were skipped.
+    bool attach(std::shared_ptr<detail::LogSegment> segment)
+    {
+        segment_ = std::move(segment);
+        reloaded_.reset();
+        records_ = segment_->data;
+        if (!segment_->spilled.load(std::memory_order_acquire)) {
+            return true;
+        }
+
+        reloaded_ = detail::reload_spilled(*segment_);
+        if (reloaded_) {
+            records_ = reloaded_->data();
+            return true;
+        } else {
+            // The spill file is unreadable: account the records as lost and move on.
+            static const std::byte empty{};
+            records_ = &empty;
+            const std::uint64_t end = segment_->base_offset + segment_->count.load(std::memory_order_acquire);
+            lost_ += end - std::min(end, position_);
+            position_ = std::max(position_, end);
+            byte_position_ = segment_->bytes.load(std::memory_order_acquire);
+            return false;
+        }
+    }
+
+    std::shared_ptr<EventLog> log_;
+    std::shared_ptr<EventLog::CursorState> state_;
+    std::shared_ptr<detail::LogSegment> segment_;
+    std::shared_ptr<std::vector<std::byte>> reloaded_;
+    const std::byte* records_{nullptr};
+    std::size_t byte_position_{0};
+    std::uint64_t position_;
+    std::uint64_t lost_{0};
+    std::uint64_t mismatches_{0};
+};
+
+template <typename... Args>
+LogCursor<Args...> EventLog::open_cursor(LogStart start)
+{
+    return LogCursor<Args...>(shared_from_this(), start == LogStart::earliest ? begin_offset() : end_offset());
+}
+
+// ---------------------------------------------------------------------------
+// Shared-memory transport
+// ---------------------------------------------------------------------------
+
+#if EVENTBUS_HAS_POSIX
+
+struct SharedRingOptions
+{
+    std::size_t slot_count{4096};                       // rounded up to a power of two
+    std::size_t slot_bytes{256};                        // payload capacity of one slot
+    std::chrono::microseconds gap_timeout{100000};      // how long a claimed slot may stay unwritten
+};
+
+struct SharedRingStats
+{
+    std::uint64_t published;
+    std::uint64_t abandoned;    // writes lost because a later lap took the slot
+};
+
+struct SharedCursorStats
+{
+    std::uint64_t received;
+    std::uint64_t lost;         // overwritten before this cursor read them (overruns) or torn
+    std::uint64_t gaps;         // claimed but never committed, e.g. the producer died
+    std::uint64_t mismatches;
+    std::uint64_t lag;
+};
+
+namespace detail {
+
+inline constexpr std::uint32_t shared_ring_magic = 0x52484245; // "EBHR"
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+              std::atomic<std::uint32_t>::is_always_lock_free,
+              "Shared-memory rings need address-free atomics");
+
+struct alignas(64) SharedRingHeader
+{
+    std::atomic<std::uint32_t> magic;
+    std::uint32_t version;
+    std::uint64_t slot_count;
+    std::uint64_t slot_stride;
+    std::uint64_t slot_bytes;
+    alignas(64) std::atomic<std::uint64_t> claimed;    // last claimed sequence; sequences start at 1
+    alignas(64) std::atomic<std::uint64_t> published;
+    std::atomic<std::uint64_t> abandoned;
+};
+
+inline constexpr std::uint32_t shared_ring_version = 2;  // 2: per-slot CRC
+
+/// Seqlock stamp: 2*seq-1 while a producer writes sequence `seq`, 2*seq once committed.
+struct SharedSlotHeader
+{
+    std::atomic<std::uint64_t> stamp;
+    std::uint64_t type_hash;
+    std::uint32_t size;
+    std::uint32_t crc;          // see shared_slot_crc()
+};
+
+/**
+ * CRC of a slot's contents for sequence `sequence`. A producer that was
+ * lapped and taken over may still be copying into the slot after the new
+ * owner committed; the stamp cannot tell, so readers check this instead.
+ */
+inline std::uint32_t shared_slot_crc(std::uint64_t sequence, std::uint64_t type_hash,
+                                     const std::byte* payload, std::uint32_t size) noexcept
+{
+    std::uint32_t crc = crc32c(0, &type_hash, sizeof(type_hash));
+    crc = crc32c(crc, &size, sizeof(size));
+    return crc32c(crc, payload, size) ^ sequence_crc(sequence);
+}
+
+} // namespace detail
+
+template <typename... Args>
+class SharedRingCursor;
+
+/**
+ * @brief Broadcast ring in POSIX shared memory for one topic
+ *
+ * Any number of processes publish into the ring: a fetch_add on the shared
+ * counter claims a sequence, the slot is written under a per-slot seqlock
+ * stamp, and producers never wait for consumers. Each consumer keeps its own
+ * position and detects overruns (slots overwritten by a later lap) and gaps
+ * (sequences claimed by a producer that never committed).
+ */
+class SharedRing : public std::enable_shared_from_this<SharedRing>
+{
+public:
+    /// Opens the ring `name`, creating it with `options` if it does not exist; an existing ring keeps its geometry.
+    static std::shared_ptr<SharedRing> open(const std::string& name, SharedRingOptions options = {})
+    {
+        return std::shared_ptr<SharedRing>(new SharedRing(name, options));
+    }
+
+    /// Removes the shared-memory object; open mappings stay valid.
+    static bool remove(const std::string& name)
+    {
+        return ::shm_unlink(object_name(name).c_str()) == 0;
+    }
+
+    ~SharedRing()
+    {
+        if (memory_ != nullptr) {
+            ::munmap(memory_, size_);
+        }
+    }
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    /// Returns false if a faster producer lapped this write; throws if the payload exceeds a slot.
+    template <typename... Args>
+    bool publish(const Args&... args)
+    {
+        static_assert(detail::is_journal_serializable_v<Args...>,
+                      "Shared ring payloads must be trivially copyable or strings");
+        auto& payload = detail::journal_scratch();
+        payload.clear();
+        detail::encode_payload(payload, args...);
+        return publish_encoded(detail::journal_type_hash<Args...>(), payload.data(), payload.size());
+    }
+
+    bool publish_encoded(std::uint64_t type_hash, const std::byte* payload, std::size_t size)
+    {
+        if (size > slot_bytes_) {
+            throw std::length_error("Payload larger than shared ring slot");
+        }
+
+        const std::uint64_t sequence = header_->claimed.fetch_add(1, std::memory_order_acq_rel) + 1;
+        auto& slot = slot_at(sequence);
+        const std::uint64_t writing = 2 * sequence - 1;
+
+        // Wait for a producer of an earlier lap still writing this slot; take over if it seems dead.
+        // If it was only slow, its late writes fail the slot CRC and readers drop the slot.
+        std::uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+        for (std::uint32_t spins = 0;; ++spins) {
+            if (stamp >= writing) {
+                header_->abandoned.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if ((stamp & 1) == 0 || spins >= max_spins) {
+                if (slot.stamp.compare_exchange_weak(stamp, writing, std::memory_order_acq_rel,
+                                                     std::memory_order_acquire)) {
+                    break;
+                }
+                continue;
+            }
+            detail::cpu_relax();
+            stamp = slot.stamp.load(std::memory_order_acquire);
+        }
+
+        slot.type_hash = type_hash;
+        slot.size = static_cast<std::uint32_t>(size);
+        slot.crc = detail::shared_slot_crc(sequence, type_hash, payload, slot.size);
+        std::memcpy(payload_of(slot), payload, size);
+
+        std::uint64_t expected = writing;
+        if (!slot.stamp.compare_exchange_strong(expected, 2 * sequence, std::memory_order_release,
+                                                std::memory_order_relaxed)) {
+            header_->abandoned.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        header_->published.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    template <typename... Args>
+    SharedRingCursor<Args...> open_cursor(LogStart start = LogStart::latest);
+
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+    [[nodiscard]] std::size_t slot_count() const noexcept { return static_cast<std::size_t>(mask_ + 1); }
+    [[nodiscard]] std::size_t slot_bytes() const noexcept { return slot_bytes_; }
+    [[nodiscard]] std::chrono::microseconds gap_timeout() const noexcept { return gap_timeout_; }
+
+    [[nodiscard]] std::uint64_t last_sequence() const noexcept
+    {
+        return header_->claimed.load(std::memory_order_acquire);
+    }
+
+    /// Oldest sequence that can still be in the ring.
+    [[nodiscard]] std::uint64_t oldest_sequence() const noexcept
+    {
+        const std::uint64_t claimed = last_sequence();
+        return claimed > mask_ + 1 ? claimed - mask_ : 1;
+    }
+
+    [[nodiscard]] SharedRingStats stats() const noexcept
+    {
+        return SharedRingStats{header_->published.load(std::memory_order_relaxed),
+                               header_->abandoned.load(std::memory_order_relaxed)};
+    }
+
+private:
+    template <typename... Args>
+    friend class SharedRingCursor;
+
+    static constexpr std::uint32_t max_spins = 1u << 20;
+
+    static std::string object_name(const std::string& name)
+    {
+        return "/" + detail::sanitize_file_name("eventbus." + name);
+    }
+
+    SharedRing(const std::string& name, const SharedRingOptions& options)
+        : name_(name), gap_timeout_(options.gap_timeout)
+    {
+        const std::string object = object_name(name);
+        int fd = ::shm_open(object.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        const bool creator = fd >= 0;
+        if (!creator && errno == EEXIST) {
+            fd = ::shm_open(object.c_str(), O_RDWR, 0600);
+        }
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open shared ring " + name);
+        }
+
+        try {
+            if (creator) {
+                create(fd, options);
+            } else {
+                attach(fd);
+            }
+        }
+        catch (...) {
+            ::close(fd);
+            if (creator) {
+                ::shm_unlink(object.c_str());
+            }
+            throw;
+        }
+        ::close(fd);
+    }
+
+    void create(int fd, const SharedRingOptions& options)
+    {
+        std::size_t slots = 2;
+        while (slots < options.slot_count) {
+            slots <<= 1;
+        }
+        const std::size_t stride = (sizeof(detail::SharedSlotHeader) + options.slot_bytes + 63) & ~std::size_t{63};
+        map(fd, sizeof(detail::SharedRingHeader) + slots * stride, true);
+
+        header_->version = detail::shared_ring_version;
+        header_->slot_count = slots;
+        header_->slot_stride = stride;
+        header_->slot_bytes = options.slot_bytes;
+        header_->magic.store(detail::shared_ring_magic, std::memory_order_release);
+        adopt_geometry();
+    }
+
+    void attach(int fd)
+    {
+        // The creator may still be sizing and initializing the object.
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        struct stat info {};
+        while (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) < sizeof(detail::SharedRingHeader)) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error("Shared ring " + name_ + " was never initialized");
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        map(fd, static_cast<std::size_t>(info.st_size), false);
+
+        while (header_->magic.load(std::memory_order_acquire) != detail::shared_ring_magic) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error("Shared ring " + name_ + " was never initialized");
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        if (header_->version != detail::shared_ring_version) {
+            throw std::runtime_error("Shared ring " + name_ + " has an incompatible version");
+        }
+        adopt_geometry();
+        if (sizeof(detail::SharedRingHeader) + (mask_ + 1) * stride_ > size_) {
+            throw std::runtime_error("Shared ring " + name_ + " is truncated");
+        }
+    }
+
+    void map(int fd, std::size_t size, bool resize)
+    {
+        if (resize && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to size shared ring " + name_);
+        }
+        void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "Failed to map shared ring " + name_);
+        }
+        memory_ = memory;
+        size_ = size;
+        header_ = static_cast<detail::SharedRingHeader*>(memory);
+        slots_ = static_cast<std::byte*>(memory) + sizeof(detail::SharedRingHeader);
+    }
+
+    void adopt_geometry()
+    {
+        mask_ = header_->slot_count - 1;
+        stride_ = static_cast<std::size_t>(header_->slot_stride);
+        slot_bytes_ = static_cast<std::size_t>(header_->slot_bytes);
+    }
+
+    detail::SharedSlotHeader& slot_at(std::uint64_t sequence) const noexcept
+    {
+        return *reinterpret_cast<detail::SharedSlotHeader*>(slots_ + (sequence & mask_) * stride_);
+    }
+
+    static std::byte* payload_of(detail::SharedSlotHeader& slot) noexcept
+    {
+        return reinterpret_cast<std::byte*>(&slot) + sizeof(detail::SharedSlotHeader);
+    }
+
+    std::string name_;
+    std::chrono::microseconds gap_timeout_;
+    void* memory_{nullptr};
+    std::size_t size_{0};
+    detail::SharedRingHeader* header_{nullptr};
+    std::byte* slots_{nullptr};
+    std::uint64_t mask_{0};
+    std::size_t stride_{0};
+    std::size_t slot_bytes_{0};
+};
+
+/**
+ * @brief One consumer's position in a SharedRing
+ *
+ * `poll()` decodes committed slots as `Args...` in sequence order. A slot
+ * already overwritten by a later lap advances the cursor to the oldest
+ * readable sequence and counts the skipped events as lost; a sequence that
+ * stays claimed but unwritten for `gap_timeout` is skipped as a gap.
+ * Exceptions from the callback propagate and the event is delivered again.
+ */
+template <typename... Args>
+class SharedRingCursor
+{
+public:
+    SharedRingCursor(std::shared_ptr<SharedRing> ring, std::uint64_t next)
+        : ring_(std::move(ring)), next_(next)
+    {
+    }
+
+    template <typename Callback>
+    std::size_t poll(Callback&& callback, std::size_t max_events = static_cast<std::size_t>(-1))
+    {
+        std::size_t delivered = 0;
+        while (delivered < max_events) {
+            auto& slot = ring_->slot_at(next_);
+            const std::uint64_t committed = 2 * next_;
+            const std::uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+
+            if (stamp == committed) {
+                const std::uint64_t type_hash = slot.type_hash;
+                const std::uint32_t crc = slot.crc;
+                const auto size = static_cast<std::uint32_t>(std::min<std::size_t>(slot.size, ring_->slot_bytes_));
+                scratch_.assign(SharedRing::payload_of(slot), SharedRing::payload_of(slot) + size);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.stamp.load(std::memory_order_relaxed) != committed) {
+                    skip_overrun();
+                    continue;
+                }
+                if (crc != detail::shared_slot_crc(next_, type_hash, scratch_.data(), size)) {
+                    // Torn by a lapped producer that was still writing: the event is lost.
+                    pending_ = false;
+                    ++lost_;
+                    ++next_;
+                    continue;
+                }
+
+                pending_ = false;
+                std::tuple<detail::journal_value_t<Args>...> values;
+                if (type_hash == detail::journal_type_hash<Args...>() &&
+                    detail::decode_tuple(scratch_.data(), scratch_.size(), values,
+                                         std::index_sequence_for<Args...>{})) {
+                    std::apply(callback, values);
+                    ++delivered;
+                    ++received_;
+                } else {
+                    ++mismatches_;
+                }
+                ++next_;
+                continue;
+            }
+
+            if (stamp > committed) {
+                skip_overrun();
+                continue;
+            }
+
+            if (ring_->last_sequence() < next_) {
+                break;
+            }
+
+            // Claimed but not committed: a producer is mid-write, or died after claiming.
+            const auto now = std::chrono::steady_clock::now();
+            if (!pending_) {
+                pending_ = true;
+                pending_since_ = now;
+                break;
+            }
+            if (now - pending_since_ < ring_->gap_timeout()) {
+                break;
+            }
+            pending_ = false;
+            ++gaps_;
+            ++next_;
+        }
+        return delivered;
+    }
+
+    [[nodiscard]] std::uint64_t position() const noexcept { return next_; }
+
+    [[nodiscard]] std::uint64_t lag() const noexcept
+    {
+        const std::uint64_t last = ring_->last_sequence();
+        return last >= next_ ? last - next_ + 1 : 0;
+    }
+
+    [[nodiscard]] SharedCursorStats stats() const noexcept
+    {
+        return SharedCursorStats{received_, lost_, gaps_, mismatches_, lag()};
+    }
+
+private:
+    void skip_overrun()
+    {
+        const std::uint64_t resume = std::max(next_ + 1, ring_->oldest_sequence());
+        lost_ += resume - next_;
+        next_ = resume;
+        pending_ = false;
+    }
+
+    std::shared_ptr<SharedRing> ring_;
+    std::uint64_t next_;
+    std::vector<std::byte> scratch_;
+    bool pending_{false};
+    std::chrono::steady_clock::time_point pending_since_{};
+    std::uint64_t received_{0};
+    std::uint64_t lost_{0};
+    std::uint64_t gaps_{0};
+    std::uint64_t mismatches_{0};
+};
+
+template <typename... Args>
+SharedRingCursor<Args...> SharedRing::open_cursor(LogStart start)
+{
+    return SharedRingCursor<Args...>(shared_from_this(),
+                                     start == LogStart::earliest ? oldest_sequence() : last_sequence() + 1);
+}
+
+#endif // EVENTBUS_HAS_POSIX
+
+// ---------------------------------------------------------------------------
+// Timers and compacted state
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+/**
+ * @brief Single-thread timer queue shared by the bus's periodic work
+ *
+ * The thread starts with the first scheduled timer. Tasks run on that thread
+ * and must not block for long; exceptions they throw are swallowed.
+ * `cancel()` waits for a running instance of the task unless called from the
+ * timer thread itself.
+ */
+class TimerQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TimerQueue() = default;
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue& operator=(const TimerQueue&) = delete;
+
+    ~TimerQueue()
+    {
+        stop();
+    }
+
+    std::uint64_t schedule(Clock::duration delay, Clock::duration period, std::function<void()> task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return 0;
+        }
+        if (!thread_.joinable()) {
+            thread_ = std::thread([this]() { run(); });
+        }
+
+        const std::uint64_t id = ++next_id_;
+        timers_.push_back(Timer{Clock::now() + delay, id, period, std::move(task)});
+        std::push_heap(timers_.begin(), timers_.end(), later);
+        cv_.notify_one();
+        return id;
+    }
+
+    std::uint64_t schedule_every(Clock::duration period, std::function<void()> task)
+    {
+        return schedule(period, period, std::move(task));
+    }
+
+    void cancel(std::uint64_t id)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = std::find_if(timers_.begin(), timers_.end(),
+                               [id](const Timer& timer) { return timer.id == id; });
+        if (it != timers_.end()) {
+            timers_.erase(it);
+            std::make_heap(timers_.begin(), timers_.end(), later);
+        }
+        if (running_id_ == id) {
+            running_cancelled_ = true;
+            if (std::this_thread::get_id() != thread_.get_id()) {
+                cv_.wait(lock, [this, id]() { return running_id_ != id; });
+            }
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            timers_.clear();
+        }
+        cv_.notify_all();
+        if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) {
+            thread_.join();
+        }
+    }
+
+private:
+    struct Timer
+    {
+        Clock::time_point deadline;
+        std::uint64_t id;
+        Clock::duration period;
+        std::function<void()> task;
+    };
+
+    static bool later(const Timer& left, const Timer& right)
+    {
+        return left.deadline > right.deadline;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (timers_.empty()) {
+                cv_.wait(lock);
+                continue;
+            }
+            // Copied: schedule() may reallocate the heap while we wait.
+            const Clock::time_point deadline = timers_.front().deadline;
+            if (cv_.wait_until(lock, deadline) == std::cv_status::no_timeout &&
+                (timers_.empty() || Clock::now() < timers_.front().deadline)) {
+                continue;
+            }
+            if (stopping_ || timers_.empty() || Clock::now() < timers_.front().deadline) {
+                continue;
+            }
+
+            std::pop_heap(timers_.begin(), timers_.end(), later);
+            Timer timer = std::move(timers_.back());
+            timers_.pop_back();
+            running_id_ = timer.id;
+            running_cancelled_ = false;
+
+            lock.unlock();
+            try {
+                timer.task();
+            }
+            catch (...) {
+            }
+            lock.lock();
+
+            running_id_ = 0;
+            if (timer.period.count() > 0 && !running_cancelled_ && !stopping_) {
+                timer.deadline += timer.period;
+                const auto now = Clock::now();
+                if (timer.deadline < now) {
+                    timer.deadline = now;
+                }
+                timers_.push_back(std::move(timer));
+                std::push_heap(timers_.begin(), timers_.end(), later);
+            }
+            cv_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Timer> timers_;
+    std::uint64_t next_id_{0};
+    std::uint64_t running_id_{0};
+    bool running_cancelled_{false};
+    bool stopping_{false};
+    std::thread thread_;
+};
+
+struct SnapshotFileHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t entries;
+};
+
+struct SnapshotEntryHeader
+{
+    std::uint32_t key_size;
+    std::uint32_t payload_size;
+    std::uint64_t type_hash;
+};
+
+inline constexpr std::uint32_t snapshot_file_magic = 0x564b4245; // "EBKV"
+
+/// Writes to `path.tmp`, syncs and renames, so readers see the old or the new file.
+template <typename WriteBody>
+bool write_file_atomically(const std::string& path, WriteBody&& write_body)
+{
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = write_body(file) && std::fflush(file) == 0;
+#if EVENTBUS_HAS_POSIX
+    ok = ok && ::fsync(::fileno(file)) == 0;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+    if (ok) {
+#if !EVENTBUS_HAS_POSIX
+        std::remove(path.c_str());
+#endif
+        ok = std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        std::remove(temporary.c_str());
+    }
+    return ok;
+}
+
+} // namespace detail
+
+struct CompactionOptions
+{
+    std::string snapshot_path;                          // empty: no snapshots
+    std::chrono::milliseconds snapshot_interval{0};     // 0: snapshot only on close / save()
+    bool restore{true};                                 // load snapshot_path when enabling
+};
+
+/**
+ * @brief Latest encoded value per key for a state topic
+ *
+ * The key is the first event argument. Values keep their encoded form, so
+ * the store can be snapshotted and restored without knowing payload types.
+ */
+class CompactedStore
+{
+public:
+    struct Entry
+    {
+        std::uint64_t type_hash{0};
+        std::vector<std::byte> payload;
+    };
+
+    explicit CompactedStore(std::string name, CompactionOptions options = {})
+        : name_(std::move(name)), options_(std::move(options))
+    {
+    }
+
+    CompactedStore(const CompactedStore&) = delete;
+    CompactedStore& operator=(const CompactedStore&) = delete;
+
+    template <typename... Args>
+    void put(const Args&... args)
+    {
+        static_assert(detail::is_journal_serializable_v<Args...>,
+                      "Compacted payloads must be trivially copyable or strings");
+        Entry entry;
+        entry.type_hash = detail::journal_type_hash<Args...>();
+        detail::encode_payload(entry.payload, args...);
+        put_encoded(detail::compaction_key(args...), std::move(entry));
+    }
+
+    void put_encoded(std::string key, Entry entry)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        entries_[std::move(key)] = std::move(entry);
+        ++version_;
+    }
+
+    /// Replaces the contents, e.g. with entries restored from a bus snapshot.
+    void assign(std::vector<std::pair<std::string, Entry>> entries)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        entries_.clear();
+        entries_.reserve(entries.size());
+        for (auto& entry : entries) {
+            entries_.insert(std::move(entry));
+        }
+        ++version_;
+    }
+
+    /// Removes the entry for an encoded key, as passed to for_each() visitors.
+    bool erase(const std::string& key)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        const bool erased = entries_.erase(key) > 0;
+        version_ += erased ? 1 : 0;
+        return erased;
+    }
+
+    /// Decodes the value stored under `key` as `Key, Rest...`; `key` is the first event argument.
+    template <typename Key, typename... Rest>
+    [[nodiscard]] std::optional<std::tuple<detail::journal_value_t<Key>, detail::journal_value_t<Rest>...>>
+    get(const Key& key) const
+    {
+        const std::string encoded = detail::compaction_key(key);
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto it = entries_.find(encoded);
+        if (it == entries_.end()) {
+            return std::nullopt;
+        }
+        return decode<Key, Rest...>(it->second);
+    }
+
+    template <typename... Args>
+    [[nodiscard]] static std::optional<std::tuple<detail::journal_value_t<Args>...>> decode(const Entry& entry)
+    {
+        if (entry.type_hash != detail::journal_type_hash<Args...>()) {
+            return std::nullopt;
+        }
+        std::tuple<detail::journal_value_t<Args>...> values;
+        if (!detail::decode_tuple(entry.payload.data(), entry.payload.size(), values,
+                                  std::index_sequence_for<Args...>{})) {
+            return std::nullopt;
+        }
+        return values;
+    }
+
+    /// Calls `visitor(key, entry)` for every entry while holding the store lock.
+    template <typename Visitor>
+    void for_each(Visitor&& visitor) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        for (const auto& pair : entries_) {
+            visitor(pair.first, pair.second);
+        }
+    }
+
+    /// Runs `action` with the store locked; puts from other threads wait, puts from `action` do not.
+    template <typename Action>
+    decltype(auto) locked(Action&& action) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return action();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    [[nodiscard]] std::uint64_t version() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return version_;
+    }
+
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+    [[nodiscard]] const std::string& snapshot_path() const noexcept { return options_.snapshot_path; }
+    [[nodiscard]] const CompactionOptions& options() const noexcept { return options_; }
+
+    /// Saves to the snapshot path given at construction.
+    bool save()
+    {
+        return !options_.snapshot_path.empty() && save(options_.snapshot_path);
+    }
+
+    /// Writes a snapshot atomically (temp file + rename). Unchanged stores are skipped.
+    bool save(const std::string& path)
+    {
+        std::vector<std::pair<std::string, Entry>> copy;
+        std::uint64_t version = 0;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            if (version_ == saved_version_ && saved_path_ == path) {
+                return true;
+            }
+            copy.assign(entries_.begin(), entries_.end());
+            version = version_;
+        }
+
+        const bool ok = detail::write_file_atomically(path, [&copy](std::FILE* file) {
+            const detail::SnapshotFileHeader header{detail::snapshot_file_magic, 1, copy.size()};
+            if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+                return false;
+            }
+            for (const auto& [key, entry] : copy) {
+                const detail::SnapshotEntryHeader entry_header{
+                    static_cast<std::uint32_t>(key.size()),
+                    static_cast<std::uint32_t>(entry.payload.size()), entry.type_hash};
+                if (std::fwrite(&entry_header, sizeof(entry_header), 1, file) != 1 ||
+                    std::fwrite(key.data(), 1, key.size(), file) != key.size() ||
+                    std::fwrite(entry.payload.data(), 1, entry.payload.size(), file) != entry.payload.size()) {
+                    return false;
+                }
+            }
+            return true;
+        });
+
+        if (ok) {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            saved_version_ = version;
+            saved_path_ = path;
+        }
+        return ok;
+    }
+
+    /// Replaces the contents with a snapshot file. Returns false (and keeps the contents) if unreadable.
+    bool load(const std::string& path)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        std::unordered_map<std::string, Entry> loaded;
+        detail::SnapshotFileHeader header{};
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                  header.magic == detail::snapshot_file_magic;
+        for (std::uint64_t i = 0; ok && i < header.entries; ++i) {
+            detail::SnapshotEntryHeader entry_header{};
+            std::string key;
+            Entry entry;
+            ok = std::fread(&entry_header, sizeof(entry_header), 1, file) == 1;
+            if (ok) {
+                key.resize(entry_header.key_size);
+                entry.type_hash = entry_header.type_hash;
+                entry.payload.resize(entry_header.payload_size);
+                ok = std::fread(key.data(), 1, key.size(), file) == key.size() &&
+                     std::fread(entry.payload.data(), 1, entry.payload.size(), file) == entry.payload.size();
+                loaded.emplace(std::move(key), std::move(entry));
+            }
+        }
+        std::fclose(file);
+        if (!ok) {
+            return false;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        entries_.swap(loaded);
+        ++version_;
+        saved_version_ = version_;
+        saved_path_ = path;
+        return true;
+    }
+
+private:
+    std::string name_;
+    CompactionOptions options_;
+    mutable std::recursive_mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::uint64_t version_{0};
+    std::uint64_t saved_version_{0};
+    std::string saved_path_;
+};
+
+// ---------------------------------------------------------------------------
+// Bus snapshots
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+/// Read-only view of a whole file: mmapped on POSIX, read into memory elsewhere.
+class FileView
+{
+public:
+    FileView() = default;
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    ~FileView()
+    {
+#if EVENTBUS_HAS_POSIX
+        if (mapped_ != nullptr) {
+            ::munmap(mapped_, size_);
+        }
+#endif
+    }
+
+    bool open(const std::string& path)
+    {
+#if EVENTBUS_HAS_POSIX
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info {};
+        bool ok = ::fstat(fd, &info) == 0 && info.st_size > 0;
+        if (ok) {
+            size_ = static_cast<std::size_t>(info.st_size);
+            void* memory = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = memory != MAP_FAILED;
+            mapped_ = ok ? memory : nullptr;
+            data_ = static_cast<const std::byte*>(mapped_);
+        }
+        ::close(fd);
+        return ok;
+#else
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        bool ok = size > 0;
+        if (ok) {
+            buffer_.resize(static_cast<std::size_t>(size));
+            ok = std::fread(buffer_.data(), 1, buffer_.size(), file) == buffer_.size();
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+        }
+        std::fclose(file);
+        return ok;
+#endif
+    }
+
+    [[nodiscard]] const std::byte* data() const noexcept { return data_; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+private:
+    const std::byte* data_{nullptr};
+    std::size_t size_{0};
+#if EVENTBUS_HAS_POSIX
+    void* mapped_{nullptr};
+#else
+    std::vector<std::byte> buffer_;
+#endif
+};
+
+inline constexpr std::uint32_t bus_snapshot_magic = 0x53424245; // "EBBS"
+inline constexpr std::uint32_t bus_snapshot_version = 2;   // 2: journal delta encoding
+
+struct BusSnapshotTopic
+{
+    std::string name;
+    bool journaled{false};
+    bool durable{false};
+    std::optional<LogTopicOptions> log;
+    std::optional<CompactionOptions> compaction;
+    std::vector<std::pair<std::string, CompactedStore::Entry>> retained;
+};
+
+struct BusSnapshotJournal
+{
+    std::string path;
+    JournalOptions options;     // resume_from holds the synced checkpoint
+};
+
+struct BusSnapshot
+{
+    std::optional<BusSnapshotJournal> journal;
+    std::vector<BusSnapshotTopic> topics;
+};
+
+/// Fixed-width fields and length-prefixed strings, in the journal codec's encoding.
+class SnapshotEncoder
+{
+public:
+    template <typename T>
+    void put(const T& value)
+    {
+        encode_value<T>(bytes_, value);
+    }
+
+    void put_bytes(const std::vector<std::byte>& value)
+    {
+        put(static_cast<std::uint32_t>(value.size()));
+        append_bytes(bytes_, value.data(), value.size());
+    }
+
+    [[nodiscard]] const std::vector<std::byte>& bytes() const noexcept { return bytes_; }
+
+private:
+    std::vector<std::byte> bytes_;
+};
+
+class SnapshotDecoder
+{
+public:
+    SnapshotDecoder(const std::byte* data, std::size_t size) : cursor_(data), end_(data + size) {}
+
+    template <typename T>
+    bool get(T& value)
+    {
+        return decode_value(cursor_, end_, value);
+    }
+
+    bool get_bytes(std::vector<std::byte>& value)
+    {
+        std::uint32_t size = 0;
+        if (!get(size) || static_cast<std::size_t>(end_ - cursor_) < size) {
+            return false;
+        }
+        value.assign(cursor_, cursor_ + size);
+        cursor_ += size;
+        return true;
+    }
+
+    [[nodiscard]] bool done() const noexcept { return cursor_ == end_; }
+
+private:
+    const std::byte* cursor_;
+    const std::byte* end_;
+};
+
+inline bool write_bus_snapshot(const std::string& path, const BusSnapshot& snapshot)
+{
+    SnapshotEncoder out;
+    out.put(bus_snapshot_magic);
+    out.put(bus_snapshot_version);
+
+    out.put(static_cast<std::uint8_t>(snapshot.journal.has_value()));
+    if (snapshot.journal) {
+        const JournalOptions& options = snapshot.journal->options;
+        const JournalCheckpoint checkpoint = options.resume_from.value_or(JournalCheckpoint{});
+        out.put(snapshot.journal->path);
+        out.put(checkpoint.offset);
+        out.put(checkpoint.sequence);
+        out.put(static_cast<std::uint64_t>(options.ring_bytes));
+        out.put(static_cast<std::uint64_t>(options.max_batch_bytes));
+        out.put(static_cast<std::uint8_t>(options.huge_pages));
+        out.put(static_cast<std::uint8_t>(options.backend));
+        out.put(static_cast<std::int64_t>(options.group_commit.max_delay.count()));
+        out.put(static_cast<std::uint64_t>(options.group_commit.max_waiters));
+        out.put(static_cast<std::uint8_t>(options.delta_encoding));
+        out.put(static_cast<std::uint64_t>(options.keyframe_interval));
+    }
+
+    out.put(static_cast<std::uint64_t>(snapshot.topics.size()));
+    for (const auto& topic : snapshot.topics) {
+        out.put(topic.name);
+        out.put(static_cast<std::uint8_t>(topic.journaled));
+        out.put(static_cast<std::uint8_t>(topic.durable));
+
+        out.put(static_cast<std::uint8_t>(topic.log.has_value()));
+        if (topic.log) {
+            out.put(static_cast<std::uint64_t>(topic.log->segment_bytes));
+            out.put(static_cast<std::uint64_t>(topic.log->retain_segments));
+            out.put(static_cast<std::uint64_t>(topic.log->max_segments));
+            out.put(static_cast<std::uint8_t>(topic.log->huge_pages));
+            out.put(topic.log->directory);
+            out.put(static_cast<std::uint64_t>(topic.log->memory_budget_bytes));
+            out.put(topic.log->spill_directory);
+        }
+
+        out.put(static_cast<std::uint8_t>(topic.compaction.has_value()));
+        if (topic.compaction) {
+            out.put(topic.compaction->snapshot_path);
+            out.put(static_cast<std::int64_t>(topic.compaction->snapshot_interval.count()));
+            out.put(static_cast<std::uint64_t>(topic.retained.size()));
+            for (const auto& [key, entry] : topic.retained) {
+                out.put(key);
+                out.put(entry.type_hash);
+                out.put_bytes(entry.payload);
+            }
+        }
+    }
+
+    return write_file_atomically(path, [&out](std::FILE* file) {
+        return std::fwrite(out.bytes().data(), 1, out.bytes().size(), file) == out.bytes().size();
+    });
+}
+
+inline bool read_bus_snapshot(const std::string& path, BusSnapshot& snapshot)
+{
+    FileView view;
+    if (!view.open(path)) {
+        return false;
+    }
+
+    SnapshotDecoder in(view.data(), view.size());
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint8_t flag = 0;
+    if (!in.get(magic) || magic != bus_snapshot_magic || !in.get(version) ||
+        version == 0 || version > bus_snapshot_version || !in.get(flag)) {
+        return false;
+    }
+
+    if (flag != 0) {
+        BusSnapshotJournal journal;
+        JournalCheckpoint checkpoint;
+        std::uint64_t ring_bytes = 0;
+        std::uint64_t max_batch_bytes = 0;
+        std::uint8_t huge_pages = 0;
+        std::uint8_t backend = 0;
+        std::int64_t max_delay = 0;
+        std::uint64_t max_waiters = 0;
+        if (!in.get(journal.path) || !in.get(checkpoint.offset) || !in.get(checkpoint.sequence) ||
+            !in.get(ring_bytes) || !in.get(max_batch_bytes) || !in.get(huge_pages) || !in.get(backend) ||
+            !in.get(max_delay) || !in.get(max_waiters)) {
+            return false;
+        }
+        std::uint8_t delta_encoding = 0;
+        std::uint64_t keyframe_interval = journal.options.keyframe_interval;
+        if (version >= 2 && (!in.get(delta_encoding) || !in.get(keyframe_interval))) {
+            return false;
+        }
+        journal.options.delta_encoding = delta_encoding != 0;
+        journal.options.keyframe_interval = static_cast<std::size_t>(keyframe_interval);
+        journal.options.ring_bytes = static_cast<std::size_t>(ring_bytes);
+        journal.options.max_batch_bytes = static_cast<std::size_t>(max_batch_bytes);
+        journal.options.huge_pages = static_cast<HugePagePolicy>(huge_pages);
+        journal.options.backend = static_cast<JournalBackend>(backend);
+        journal.options.group_commit.max_delay = std::chrono::microseconds(max_delay);
+        journal.options.group_commit.max_waiters = static_cast<std::size_t>(max_waiters);
+        journal.options.resume_from = checkpoint;
+        snapshot.journal = std::move(journal);
+    }
+
+    std::uint64_t topic_count = 0;
+    if (!in.get(topic_count)) {
+        return false;
+    }
+    for (std::uint64_t i = 0; i < topic_count; ++i) {
+        BusSnapshotTopic topic;
+        std::uint8_t journaled = 0;
+        std::uint8_t durable = 0;
+        if (!in.get(topic.name) || !in.get(journaled) || !in.get(durable) || !in.get(flag)) {
+            return false;
+        }
+        topic.journaled = journaled != 0;
+        topic.durable = durable != 0;
+
+        if (flag != 0) {
+            LogTopicOptions log;
+            std::uint64_t segment_bytes = 0;
+            std::uint64_t retain_segments = 0;
+            std::uint64_t max_segments = 0;
+            std::uint8_t huge_pages = 0;
+            std::uint64_t memory_budget = 0;
+            if (!in.get(segment_bytes) || !in.get(retain_segments) || !in.get(max_segments) ||
+                !in.get(huge_pages) || !in.get(log.directory) || !in.get(memory_budget) ||
+                !in.get(log.spill_directory)) {
+                return false;
+            }
+            log.segment_bytes = static_cast<std::size_t>(segment_bytes);
+            log.retain_segments = static_cast<std::size_t>(retain_segments);
+            log.max_segments = static_cast<std::size_t>(max_segments);
+            log.huge_pages = static_cast<HugePagePolicy>(huge_pages);
+            log.memory_budget_bytes = static_cast<std::size_t>(memory_budget);
+            topic.log = std::move(log);
+        }
+
+        if (!in.get(flag)) {
+            return false;
+        }
+        if (flag != 0) {
+            CompactionOptions compaction;
+            std::int64_t interval = 0;
+            std::uint64_t entries = 0;
+            if (!in.get(compaction.snapshot_path) || !in.get(interval) || !in.get(entries)) {
+                return false;
+            }
+            compaction.snapshot_interval = std::chrono::milliseconds(interval);
+            compaction.restore = false;
+            topic.retained.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(entries, view.size())));
+            for (std::uint64_t j = 0; j < entries; ++j) {
+                std::string key;
+                CompactedStore::Entry entry;
+                if (!in.get(key) || !in.get(entry.type_hash) || !in.get_bytes(entry.payload)) {
+                    return false;
+                }
+                topic.retained.emplace_back(std::move(key), std::move(entry));
+            }
+            topic.compaction = std::move(compaction);
+        }
+        snapshot.topics.push_back(std::move(topic));
+    }
+    return in.done();
+}
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+// Heavy-hitter topics
+// ---------------------------------------------------------------------------
+
+struct HeavyHitterOptions
+{
+    std::size_t width{8192};                            // counters per sketch row, rounded up to a power of two
+    std::size_t depth{4};                               // sketch rows
+    std::size_t top_k{64};                              // candidates kept per ranking
+    std::size_t batch{64};                              // publishes buffered per thread before a flush
+    std::chrono::milliseconds decay_interval{10000};    // counts halve every interval; 0: cumulative
+};
+
+enum class HotTopicOrder
+{
+    publishes,
+    callback_time
+};
+
+struct HotTopic
+{
+    std::string name;
+    std::uint64_t publishes;        // estimate; never below the true (decayed) count
+    std::uint64_t callback_ns;      // estimated time spent in synchronous dispatch
+};
+
+/**
+ * @brief Fixed-memory top-K topics by publish count and callback time
+ *
+ * Two count-min sketches estimate per-topic totals and a small candidate
+ * table per ranking keeps the largest estimates seen. Publishers add into a
+ * thread-local buffer and touch the shared counters once per batch, so a
+ * thread's last few publishes become visible with its next flush (or when
+ * it exits). Memory does not grow with the number of topics.
+ */
+class HeavyHitterTracker
+{
+public:
+    explicit HeavyHitterTracker(HeavyHitterOptions options = {})
+        : state_(std::make_shared<State>(options))
+    {
+    }
+
+    HeavyHitterTracker(const HeavyHitterTracker&) = delete;
+    HeavyHitterTracker& operator=(const HeavyHitterTracker&) = delete;
+
+    /// Counts one publish of @p topic that spent @p callback_ns in its callbacks.
+    void record(std::string_view topic, std::uint64_t callback_ns)
+    {
+        LocalBuffer& buffer = local_buffer();
+        if (buffer.owner_raw != state_.get() || buffer.owner.expired()) {
+            buffer.flush();
+            buffer.owner = state_;
+            buffer.owner_raw = state_.get();
+        }
+
+        const std::uint64_t hash = std::hash<std::string_view>{}(topic);
+        LocalEntry* slot = nullptr;
+        for (std::size_t i = 0; i < buffer.used; ++i) {
+            if (buffer.entries[i].hash == hash && buffer.entries[i].name == topic) {
+                slot = &buffer.entries[i];
+                break;
+            }
+        }
+        if (slot == nullptr) {
+            if (buffer.used == local_entries) {
+                buffer.flush();
+            }
+            slot = &buffer.entries[buffer.used++];
+            slot->hash = hash;
+            slot->name.assign(topic.data(), topic.size());
+        }
+        ++slot->count;
+        slot->callback_ns += callback_ns;
+
+        if (++buffer.pending >= state_->options.batch) {
+            buffer.flush();
+        }
+    }
+
+    /// Publishes the calling thread's buffered updates.
+    void flush()
+    {
+        LocalBuffer& buffer = local_buffer();
+        if (buffer.owner_raw == state_.get()) {
+            buffer.flush();
+        }
+    }
+
+    /// Halves every count so the rankings follow recent rates.
+    void decay()
+    {
+        State& state = *state_;
+        for (std::size_t i = 0; i < state.cell_count; ++i) {
+            halve(state.cells[i].count);
+            halve(state.cells[i].time_ns);
+        }
+        std::lock_guard<std::mutex> lock(state.candidates_mutex);
+        for (auto* table : {&state.by_publishes, &state.by_time}) {
+            for (auto& candidate : table->candidates) {
+                candidate.score /= 2;
+            }
+            table->update_floor(state.options.top_k);
+        }
+    }
+
+    /// The @p n topics with the largest estimates, largest first.
+    [[nodiscard]] std::vector<HotTopic> top(std::size_t n, HotTopicOrder order = HotTopicOrder::publishes) const
+    {
+        const State& state = *state_;
+        std::vector<HotTopic> result;
+        {
+            std::lock_guard<std::mutex> lock(state.candidates_mutex);
+            const auto& table = order == HotTopicOrder::publishes ? state.by_publishes : state.by_time;
+            result.reserve(table.candidates.size());
+            for (const auto& candidate : table.candidates) {
+                result.push_back(HotTopic{candidate.name, 0, 0});
+            }
+        }
+
+        for (auto& topic : result) {
+            const std::uint64_t hash = std::hash<std::string_view>{}(topic.name);
+            std::tie(topic.publishes, topic.callback_ns) = state.estimate(hash);
+        }
+        std::sort(result.begin(), result.end(), [order](const HotTopic& a, const HotTopic& b) {
+            return order == HotTopicOrder::publishes ? a.publishes > b.publishes : a.callback_ns > b.callback_ns;
+        });
+        result.erase(std::remove_if(result.begin(), result.end(), [order](const HotTopic& topic) {
+            return (order == HotTopicOrder::publishes ? topic.publishes : topic.callback_ns) == 0;
+        }), result.end());
+        if (result.size() > n) {
+            result.resize(n);
+        }
+        return result;
+    }
+
+    /// Sketch estimate for any topic, tracked in the top-K or not.
+    [[nodiscard]] HotTopic estimate(std::string_view topic) const
+    {
+        const std::uint64_t hash = std::hash<std::string_view>{}(topic);
+        const auto estimates = state_->estimate(hash);
+        return HotTopic{std::string(topic), estimates.first, estimates.second};
+    }
+
+    [[nodiscard]] const HeavyHitterOptions& options() const noexcept { return state_->options; }
+
+    /// Bytes held by the sketches and candidate tables; fixed at construction.
+    [[nodiscard]] std::size_t memory_bytes() const noexcept
+    {
+        return state_->cell_count * sizeof(Cell) +
+               2 * state_->options.top_k * sizeof(Candidate);
+    }
+
+private:
+    static constexpr std::size_t local_entries = 16;
+
+    struct Candidate
+    {
+        std::uint64_t hash{0};
+        std::string name;
+        std::uint64_t score{0};     // estimate when last offered, for eviction only
+    };
+
+    struct CandidateTable
+    {
+        /// Keeps the topic in a full table only if it beats the smallest candidate.
+        void offer(std::uint64_t hash, const std::string& name, std::uint64_t score, std::size_t capacity)
+        {
+            Candidate* smallest = nullptr;
+            for (auto& candidate : candidates) {
+                if (candidate.hash == hash && candidate.name == name) {
+                    candidate.score = score;
+                    return;
+                }
+                if (smallest == nullptr || candidate.score < smallest->score) {
+                    smallest = &candidate;
+                }
+            }
+            if (candidates.size() < capacity) {
+                candidates.push_back(Candidate{hash, name, score});
+            } else if (smallest != nullptr && score > smallest->score) {
+                smallest->hash = hash;
+                smallest->name = name;
+                smallest->score = score;
+            }
+        }
+
+        void update_floor(std::size_t capacity)
+        {
+            std::uint64_t smallest = 0;
+            if (candidates.size() >= capacity) {
+                smallest = std::numeric_limits<std::uint64_t>::max();
+                for (const auto& candidate : candidates) {
+                    smallest = std::min(smallest, candidate.score);
+                }
+            }
+            floor.store(smallest, std::memory_order_relaxed);
+        }
+
+        std::vector<Candidate> candidates;
+        std::atomic<std::uint64_t> floor{0};    // scores at or below it cannot enter; read without the lock
+    };
+
+    struct Cell
+    {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> time_ns{0};
+    };
+
+    struct State
+    {
+        explicit State(HeavyHitterOptions opts)
+            : options(opts)
+        {
+            options.depth = std::max<std::size_t>(options.depth, 1);
+            options.top_k = std::max<std::size_t>(options.top_k, 1);
+            options.batch = std::max<std::size_t>(options.batch, 1);
+            std::size_t width = 1;
+            while (width < std::max<std::size_t>(options.width, 16)) {
+                width <<= 1;
+            }
+            options.width = width;
+            mask = width - 1;
+            cell_count = width * options.depth;
+            cells.reset(new Cell[cell_count]);
+            by_publishes.candidates.reserve(options.top_k);
+            by_time.candidates.reserve(options.top_k);
+        }
+
+        std::size_t cell(std::uint64_t hash, std::size_t row) const noexcept
+        {
+            std::uint64_t x = hash + 0x9E3779B97F4A7C15ULL * (row + 1);
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+            x ^= x >> 31;
+            return row * options.width + static_cast<std::size_t>(x & mask);
+        }
+
+        /// Minimum over the rows: {publishes, callback_ns}.
+        std::pair<std::uint64_t, std::uint64_t> estimate(std::uint64_t hash) const noexcept
+        {
+            std::uint64_t count = std::numeric_limits<std::uint64_t>::max();
+            std::uint64_t time_ns = count;
+            for (std::size_t row = 0; row < options.depth; ++row) {
+                const Cell& target = cells[cell(hash, row)];
+                count = std::min(count, target.count.load(std::memory_order_relaxed));
+                time_ns = std::min(time_ns, target.time_ns.load(std::memory_order_relaxed));
+            }
+            return {count, time_ns};
+        }
+
+        /// Starts loading the rows of @p hash so a batch of updates overlaps its cache misses.
+        void prefetch(std::uint64_t hash) const noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            for (std::size_t row = 0; row < options.depth; ++row) {
+                __builtin_prefetch(&cells[cell(hash, row)], 1);
+            }
+#else
+            (void)hash;
+#endif
+        }
+
+        /// Adds to every row and returns the new estimate.
+        std::pair<std::uint64_t, std::uint64_t> add(std::uint64_t hash, std::uint64_t count_delta,
+                                                     std::uint64_t time_delta) noexcept
+        {
+            std::uint64_t count = std::numeric_limits<std::uint64_t>::max();
+            std::uint64_t time_ns = count;
+            for (std::size_t row = 0; row < options.depth; ++row) {
+                Cell& target = cells[cell(hash, row)];
+                count = std::min(count, target.count.fetch_add(count_delta, std::memory_order_relaxed) + count_delta);
+                time_ns = std::min(time_ns, target.time_ns.fetch_add(time_delta, std::memory_order_relaxed) + time_delta);
+            }
+            return {count, time_ns};
+        }
+
+        HeavyHitterOptions options;
+        std::size_t mask{0};
+        std::size_t cell_count{0};
+        std::unique_ptr<Cell[]> cells;     // both sketches interleaved: one cache miss per row
+        mutable std::mutex candidates_mutex;
+        CandidateTable by_publishes;
+        CandidateTable by_time;
+    };
+
+    struct LocalEntry
+    {
+        std::uint64_t hash{0};
+        std::string name;
+        std::uint64_t count{0};
+        std::uint64_t callback_ns{0};
+    };
+
+    // One per thread; follows the tracker it was last used with.
+    struct LocalBuffer
+    {
+        ~LocalBuffer() { flush(); }
+
+        void flush()
+        {
+            std::shared_ptr<State> state = owner.lock();
+            if (state && used != 0) {
+                std::uint64_t count_estimates[local_entries];
+                std::uint64_t time_estimates[local_entries];
+                const std::uint64_t count_floor = state->by_publishes.floor.load(std::memory_order_relaxed);
+                const std::uint64_t time_floor = state->by_time.floor.load(std::memory_order_relaxed);
+                bool candidates = false;
+                for (std::size_t i = 0; i < used; ++i) {
+                    state->prefetch(entries[i].hash);
+                }
+                for (std::size_t i = 0; i < used; ++i) {
+                    std::tie(count_estimates[i], time_estimates[i]) =
+                        state->add(entries[i].hash, entries[i].count, entries[i].callback_ns);
+                    candidates = candidates || count_estimates[i] > count_floor || time_estimates[i] > time_floor;
+                }
+
+                // Most flushes carry only cold topics and skip the lock entirely.
+                if (candidates) {
+                    const std::size_t capacity = state->options.top_k;
+                    std::lock_guard<std::mutex> lock(state->candidates_mutex);
+                    for (std::size_t i = 0; i < used; ++i) {
+                        if (count_estimates[i] > count_floor) {
+                            state->by_publishes.offer(entries[i].hash, entries[i].name, count_estimates[i], capacity);
+                        }
+                        if (time_estimates[i] > time_floor) {
+                            state->by_time.offer(entries[i].hash, entries[i].name, time_estimates[i], capacity);
+                        }
+                    }
+                    state->by_publishes.update_floor(capacity);
+                    state->by_time.update_floor(capacity);
+                }
+            }
+            for (std::size_t i = 0; i < used; ++i) {
+                entries[i].count = 0;
+                entries[i].callback_ns = 0;
+            }
+            used = 0;
+            pending = 0;
+        }
+
+        std::weak_ptr<State> owner;
+        const State* owner_raw{nullptr};
+        LocalEntry entries[local_entries];
+        std::size_t used{0};
+        std::size_t pending{0};
+    };
+
+    static LocalBuffer& local_buffer()
+    {
+        thread_local LocalBuffer buffer;
+        return buffer;
+    }
+
+    static void halve(std::atomic<std::uint64_t>& counter) noexcept
+    {
+        const std::uint64_t value = counter.load(std::memory_order_relaxed);
+        counter.fetch_sub(value / 2, std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+struct FastPathOptions
+{
+    std::size_t slots{64};                              // direct-mapped, rounded up to a power of two
+    std::size_t promote{32};                            // hottest topics considered per refresh
+    std::chrono::milliseconds refresh_interval{1000};   // 0: only on refreshFastPath()
+};
+
+struct FastPathStats
+{
+    std::size_t slots;
+    std::size_t promoted;       // slots currently holding a topic
+    std::uint64_t hits;         // publishes served from a slot since its topic was promoted
+};
+
+// ---------------------------------------------------------------------------
+// Rate limiting
+// ---------------------------------------------------------------------------
+
+enum class ThrottlePolicy
+{
+    reject,     // drop events over the limit
+    delay,      // sleep on the publishing thread until a token is due, up to max_delay
+    sample      // drop all but one in sample_every events over the limit
+};
+
+struct RateLimit
+{
+    double rate{1000.0};                                // sustained events per second
+    double burst{100.0};                                // events accepted back to back after idling
+    ThrottlePolicy policy{ThrottlePolicy::reject};
+    std::chrono::microseconds max_delay{10000};         // delay: longer waits are rejected instead
+    std::uint32_t sample_every{100};                    // sample: one excess event in this many passes
+    bool per_thread{false};                             // one bucket per publishing thread
+};
+
+struct RateLimitStats
+{
+    std::uint64_t throttled;    // events dropped
+    std::uint64_t delayed;      // publishes that waited for a token
+    std::uint64_t sampled;      // excess events let through by sampling
+    std::size_t thread_buckets; // per_thread: buckets currently kept
+};
+
+/**
+ * @brief Token bucket for one topic or topic prefix
+ *
+ * Implemented as GCRA: the bucket is a single theoretical arrival time, so
+ * admitting an event is one clock read and one compare-and-swap. Per-thread
+ * buckets are found through a one-entry thread-local cache; buckets no
+ * thread caches any more are pruned once they are idle, since an idle
+ * bucket behaves like a new one.
+ */
+class RateLimiter
+{
+public:
+    explicit RateLimiter(RateLimit limit)
+        : limit_(limit), id_(next_id())
+    {
+        const double rate = std::max(limit_.rate, 1e-3);
+        interval_ns_ = std::max<std::int64_t>(1, static_cast<std::int64_t>(1e9 / rate));
+        window_ns_ = static_cast<std::int64_t>(
+            std::min(std::max(limit_.burst, 1.0) * static_cast<double>(interval_ns_), 1e18));
+        limit_.sample_every = std::max<std::uint32_t>(limit_.sample_every, 1);
+    }
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /// Takes a token for one event: how long to wait before publishing it, or nullopt to drop it.
+    std::optional<std::chrono::nanoseconds> acquire()
+    {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::atomic<std::int64_t>& bucket = limit_.per_thread ? thread_bucket() : shared_bucket_;
+
+        std::int64_t tat = bucket.load(std::memory_order_relaxed);
+        while (true) {
+            const std::int64_t next = std::max(tat, now) + interval_ns_;
+            const std::int64_t wait = next - now - window_ns_;
+            if (wait <= 0) {
+                if (bucket.compare_exchange_weak(tat, next, std::memory_order_relaxed)) {
+                    return std::chrono::nanoseconds(0);
+                }
+                continue;
+            }
+
+            switch (limit_.policy) {
+            case ThrottlePolicy::delay:
+                if (wait > std::chrono::duration_cast<std::chrono::nanoseconds>(limit_.max_delay).count()) {
+                    throttled_.fetch_add(1, std::memory_order_relaxed);
+                    return std::nullopt;
+                }
+                if (!bucket.compare_exchange_weak(tat, next, std::memory_order_relaxed)) {
+                    continue;
+                }
+                delayed_.fetch_add(1, std::memory_order_relaxed);
+                return std::chrono::nanoseconds(wait);
+            case ThrottlePolicy::sample:
+                if (excess_.fetch_add(1, std::memory_order_relaxed) % limit_.sample_every == 0) {
+                    sampled_.fetch_add(1, std::memory_order_relaxed);
+                    return std::chrono::nanoseconds(0);
+                }
+                throttled_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            case ThrottlePolicy::reject:
+                break;
+            }
+            throttled_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+    }
+
+    [[nodiscard]] RateLimitStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        return RateLimitStats{throttled_.load(std::memory_order_relaxed),
+                              delayed_.load(std::memory_order_relaxed),
+                              sampled_.load(std::memory_order_relaxed),
+                              thread_buckets_.size()};
+    }
+
+    [[nodiscard]] const RateLimit& limit() const noexcept { return limit_; }
+
+private:
+    using Bucket = std::shared_ptr<std::atomic<std::int64_t>>;
+
+    // Shares the bucket with thread_buckets_, so pruning never frees a cached one.
+    struct ThreadCache
+    {
+        std::uint64_t owner{0};
+        Bucket bucket;
+    };
+
+    static constexpr std::size_t min_prune_size = 64;
+
+    static std::uint64_t next_id() noexcept
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    std::atomic<std::int64_t>& thread_bucket()
+    {
+        thread_local ThreadCache cache;
+        if (cache.owner == id_) {
+            return *cache.bucket;
+        }
+
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        if (thread_buckets_.size() >= prune_at_) {
+            prune_thread_buckets();
+        }
+        auto& bucket = thread_buckets_[std::this_thread::get_id()];
+        if (!bucket) {
+            bucket = std::make_shared<std::atomic<std::int64_t>>(0);
+        }
+        cache.owner = id_;
+        cache.bucket = bucket;
+        return *bucket;
+    }
+
+    /// Drops buckets of exited or moved-on threads that are full again; called with threads_mutex_ held.
+    void prune_thread_buckets()
+    {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        for (auto it = thread_buckets_.begin(); it != thread_buckets_.end();) {
+            // Only copied under threads_mutex_, so a count of one cannot grow concurrently.
+            if (it->second.use_count() == 1 && it->second->load(std::memory_order_relaxed) <= now) {
+                it = thread_buckets_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        prune_at_ = std::max(min_prune_size, 2 * thread_buckets_.size());
+    }
+
+    RateLimit limit_;
+    std::uint64_t id_;
+    std::int64_t interval_ns_{1};
+    std::int64_t window_ns_{1};
+    std::atomic<std::int64_t> shared_bucket_{0};
+    std::atomic<std::uint64_t> excess_{0};
+    std::atomic<std::uint64_t> throttled_{0};
+    std::atomic<std::uint64_t> delayed_{0};
+    std::atomic<std::uint64_t> sampled_{0};
+    mutable std::mutex threads_mutex_;
+    std::unordered_map<std::thread::id, Bucket> thread_buckets_;
+    std::size_t prune_at_{min_prune_size};
+};
+
+namespace detail {
+
+/// Settings keyed by topic pattern: an exact name, or a prefix ending in '*'.
+template <typename Value>
+class PatternTable
+{
+public:
+    void set(const std::string& pattern, Value value)
+    {
+        patterns_[pattern] = std::move(value);
+        rebuild();
+    }
+
+    bool erase(const std::string& pattern)
+    {
+        if (patterns_.erase(pattern) == 0) {
+            return false;
+        }
+        rebuild();
+        return true;
+    }
+
+    /// Exact name first, then the longest matching prefix; a default Value if none.
+    [[nodiscard]] Value match(const std::string& name) const
+    {
+        auto it = patterns_.find(name);
+        if (it != patterns_.end()) {
+            return it->second;
+        }
+        for (const auto& pair : prefixes_) {
+            if (name.compare(0, pair.first.size(), pair.first) == 0) {
+                return pair.second;
+            }
+        }
+        return Value{};
+    }
+
+    [[nodiscard]] const Value* find(const std::string& pattern) const
+    {
+        auto it = patterns_.find(pattern);
+        return it != patterns_.end() ? &it->second : nullptr;
+    }
+
+    template <typename Visitor>
+    void for_each(Visitor&& visitor) const
+    {
+        for (const auto& pair : patterns_) {
+            visitor(pair.first, pair.second);
+        }
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return patterns_.empty(); }
+
+private:
+    void rebuild()
+    {
+        prefixes_.clear();
+        for (const auto& pair : patterns_) {
+            if (!pair.first.empty() && pair.first.back() == '*') {
+                prefixes_.emplace_back(pair.first.substr(0, pair.first.size() - 1), pair.second);
+            }
+        }
+        std::sort(prefixes_.begin(), prefixes_.end(), [](const auto& a, const auto& b) {
+            return a.first.size() > b.first.size();
+        });
+    }
+
+    std::unordered_map<std::string, Value> patterns_;
+    std::vector<std::pair<std::string, Value>> prefixes_;      // longest first
+};
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+// Fibers
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+class Fiber;
+
+/// Scheduler side of a fiber; the async workers implement it.
+class FiberHost
+{
+public:
+    virtual ~FiberHost() = default;
+
+    /// Queues @p fiber to resume on its own thread. Callable from any thread.
+    virtual void ready(Fiber* fiber) = 0;
+    /// Resumes @p fiber at @p deadline. Called on the fiber's thread.
+    virtual void sleep_until(Fiber* fiber, std::chrono::steady_clock::time_point deadline) = 0;
+    /// Runs @p job on a blocking-call thread, then readies @p fiber. Called on the fiber's thread.
+    virtual void run_blocking(std::function<void()> job, Fiber* fiber) = 0;
+};
+
+/**
+ * @brief Stackful coroutine on an mmap'd stack with a guard page
+ *
+ * resume() runs the body until it finishes or calls suspend(); the
+ * continuation passed to suspend() runs on the resuming thread after the
+ * switch, when the fiber is fully parked, so it can safely hand the fiber
+ * to another thread to be readied. A fiber is only resumed on the thread
+ * that started it.
+ */
+class Fiber
+{
+public:
+    Fiber(FiberHost& host, std::size_t stack_size)
+        : host_(&host)
+    {
+#if EVENTBUS_HAS_FIBERS
+        const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        stack_size_ = (std::max<std::size_t>(stack_size, 16 * 1024) + page - 1) / page * page + page;
+        void* memory = ::mmap(nullptr, stack_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "mmap fiber stack");
+        }
+        ::mprotect(memory, page, PROT_NONE);
+        stack_ = memory;
+#else
+        (void)stack_size;
+#endif
+    }
+
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+    ~Fiber()
+    {
+#if EVENTBUS_HAS_FIBERS
+        if (stack_ != nullptr) {
+            ::munmap(stack_, stack_size_);
+        }
+#endif
+    }
+
+    /// Prepares a finished or new fiber to run @p body.
+    void reset(std::function<void()> body)
+    {
+        body_ = std::move(body);
+        finished_ = false;
+#if EVENTBUS_HAS_FIBERS
+        ::getcontext(&context_);
+        context_.uc_stack.ss_sp = stack_;
+        context_.uc_stack.ss_size = stack_size_;
+        context_.uc_link = nullptr;
+        ::makecontext(&context_, &Fiber::entry, 0);
+#endif
+    }
+
+    /// Runs until the body finishes or suspends; true once it has finished.
+    bool resume()
+    {
+        Fiber* const previous = current_slot();
+        current_slot() = this;
+#if EVENTBUS_HAS_FIBERS
+        ::swapcontext(&caller_, &context_);
+#else
+        run_body();
+#endif
+        current_slot() = previous;
+        if (!finished_ && then_) {
+            auto then = std::move(then_);
+            then_ = nullptr;
+            then();
+        }
+        return finished_;
+    }
+
+    /// Called on the fiber: parks it and runs @p then on the resuming thread.
+    void suspend(std::function<void()> then)
+    {
+        then_ = std::move(then);
+#if EVENTBUS_HAS_FIBERS
+        ::swapcontext(&context_, &caller_);
+#endif
+    }
+
+    [[nodiscard]] FiberHost& host() const noexcept { return *host_; }
+
+    /// The fiber running on this thread, if any.
+    static Fiber* current() noexcept { return current_slot(); }
+
+private:
+    static Fiber*& current_slot() noexcept
+    {
+        thread_local Fiber* slot = nullptr;
+        return slot;
+    }
+
+    static void entry()
+    {
+        Fiber* const self = current_slot();
+        self->run_body();
+#if EVENTBUS_HAS_FIBERS
+        ::swapcontext(&self->context_, &self->caller_);
+#endif
+    }
+
+    void run_body() noexcept
+    {
+        try {
+            body_();
+        }
+        catch (...) {
+        }
+        body_ = nullptr;
+        finished_ = true;
+    }
+
+    FiberHost* host_;
+    std::function<void()> body_;
+    std::function<void()> then_;
+    bool finished_{true};
+#if EVENTBUS_HAS_FIBERS
+    void* stack_{nullptr};
+    std::size_t stack_size_{0};
+    ucontext_t context_ {};
+    ucontext_t caller_ {};
+#endif
+};
+
+/// Plain threads for calls that block the OS thread; started on first use.
+class BlockingPool
+{
+public:
+    explicit BlockingPool(std::size_t threads)
+        : size_(std::max<std::size_t>(threads, 1))
+    {
+    }
+
+    BlockingPool(const BlockingPool&) = delete;
+    BlockingPool& operator=(const BlockingPool&) = delete;
+
+    ~BlockingPool()
+    {
+        stop();
+    }
+
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (threads_.empty()) {
+                threads_.reserve(size_);
+                for (std::size_t i = 0; i < size_; ++i) {
+                    threads_.emplace_back([this]() { run(); });
+                }
+            }
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    /// Runs what is queued, then joins the threads.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            auto job = std::move(jobs_.front());
+            jobs_.pop_front();
+            lock.unlock();
+            try {
+                job();
+            }
+            catch (...) {
+            }
+            lock.lock();
+        }
+    }
+
+    const std::size_t size_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    std::vector<std::thread> threads_;
+    bool stopping_{false};
+};
+
+} // namespace detail
+
+/**
+ * @brief Blocking helpers for callbacks running on fibers
+ *
+ * With AsyncOptions::fibers set, publishAsync() callbacks run on fibers and
+ * these calls park the fiber instead of the worker thread, which goes on to
+ * run other callbacks. Outside a fiber they block the calling thread as
+ * usual, so callbacks can use them unconditionally.
+ */
+namespace this_fiber {
+
+/// True when called from a callback running on a fiber.
+inline bool active() noexcept
+{
+    return detail::Fiber::current() != nullptr;
+}
+
+/// Lets other ready fibers on this worker run first.
+inline void yield()
+{
+    detail::Fiber* const fiber = detail::Fiber::current();
+    if (fiber == nullptr) {
+        std::this_thread::yield();
+        return;
+    }
+    fiber->suspend([fiber]() { fiber->host().ready(fiber); });
+}
+
+template <typename Rep, typename Period>
+void sleep_for(std::chrono::duration<Rep, Period> duration)
+{
+    detail::Fiber* const fiber = detail::Fiber::current();
+    if (fiber == nullptr) {
+        std::this_thread::sleep_for(duration);
+        return;
+    }
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration);
+    fiber->suspend([fiber, deadline]() { fiber->host().sleep_until(fiber, deadline); });
+}
+
+/**
+ * Runs @p fn, a call that blocks the OS thread (file I/O, a synchronous
+ * client), on one of AsyncOptions::blocking_threads and parks the fiber
+ * until it returns. Returns its result or rethrows its exception.
+ */
+template <typename Fn>
+std::invoke_result_t<Fn> run_blocking(Fn&& fn)
+{
+    using Result = std::invoke_result_t<Fn>;
+    detail::Fiber* const fiber = detail::Fiber::current();
+    if (fiber == nullptr) {
+        return std::forward<Fn>(fn)();
+    }
+
+    std::exception_ptr error;
+    std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>> result{};
+    std::function<void()> job = [&fn, &error, &result]() {
+        try {
+            if constexpr (std::is_void_v<Result>) {
+                std::forward<Fn>(fn)();
+                result = true;
+            } else {
+                result.emplace(std::forward<Fn>(fn)());
+            }
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+    };
+    fiber->suspend([fiber, &job]() { fiber->host().run_blocking(std::move(job), fiber); });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if constexpr (!std::is_void_v<Result>) {
+        return std::move(*result);
+    }
+}
+
+} // namespace this_fiber
+
+namespace detail {
+
+/**
+ * Who is running: the fiber when on one, otherwise the OS thread. Several
+ * fibers share a worker thread, so "is this caller inside the callback"
+ * checks must compare these rather than thread ids.
+ */
+struct ExecutionId
+{
+    const Fiber* fiber{nullptr};
+    std::thread::id thread;
+
+    [[nodiscard]] static ExecutionId current() noexcept
+    {
+        if (const Fiber* fiber = Fiber::current()) {
+            return ExecutionId{fiber, std::thread::id{}};
+        }
+        return ExecutionId{nullptr, std::this_thread::get_id()};
+    }
+
+    bool operator==(const ExecutionId& other) const noexcept
+    {
+        return fiber == other.fiber && thread == other.thread;
+    }
+    bool operator!=(const ExecutionId& other) const noexcept { return !(*this == other); }
+};
+
+struct ExecutionIdHash
+{
+    std::size_t operator()(const ExecutionId& id) const noexcept
+    {
+        return std::hash<const void*>{}(id.fiber) ^ std::hash<std::thread::id>{}(id.thread);
+    }
+};
+
+/**
+ * cv.wait(lock, ready), except that on a fiber it parks the fiber between
+ * checks instead of blocking the worker, so a fiber it waits for on the
+ * same worker can run.
+ */
+template <typename Ready>
+void wait_for(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, Ready ready)
+{
+    if (Fiber::current() == nullptr) {
+        cv.wait(lock, ready);
+        return;
+    }
+    while (!ready()) {
+        lock.unlock();
+        this_fiber::sleep_for(std::chrono::microseconds(100));
+        lock.lock();
+    }
+}
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+// Async delivery and load shedding
+// ---------------------------------------------------------------------------
+
+struct AsyncOptions
+{
+    std::size_t workers{2};
+    std::size_t max_queued{100000};                     // hard cap; beyond it every class is shed
+    std::chrono::microseconds target_delay{5000};       // acceptable queueing delay (CoDel target)
+    std::chrono::milliseconds interval{100};            // how long delay must stay above target to shed more
+    int default_priority{0};                            // priority of topics without a class
+    std::chrono::microseconds quantum{500};             // worker time granted per queue per round, times weight
+    std::size_t fibers{0};                              // > 0: callbacks run on fibers, at most this many per worker
+    std::size_t fiber_stack{64 * 1024};                 // bytes per fiber stack, plus a guard page
+    std::size_t blocking_threads{4};                    // threads behind this_fiber::run_blocking()
+};
+
+/// Shedding class of a group of topics; lower priorities are shed first.
+struct TopicClass
+{
+    std::string name;
+    int priority{0};
+};
+
+/// Owner of a group of topics for fair scheduling; weight scales its share of worker time.
+struct Tenant
+{
+    std::string name;
+    std::uint32_t weight{1};
+};
+
+struct TopicClassStats
+{
+    std::string name;
+    int priority;
+    std::uint64_t admitted;
+    std::uint64_t executed;
+    std::uint64_t shed;         // rejected at admission or dropped from the queue
+};
+
+struct TenantStats
+{
+    std::string name;
+    std::uint32_t weight;
+    std::size_t queued;
+    std::uint64_t executed;
+    std::chrono::nanoseconds cpu_time;      // CPU time of worker threads running its events
+};
+
+struct AsyncStats
+{
+    std::size_t workers;
+    std::size_t queued;
+    std::uint64_t executed;
+    std::uint64_t shed;
+    std::size_t shed_level;                     // number of priority levels currently shed
+    std::chrono::microseconds queue_delay;      // smallest delay seen in the last interval
+    std::vector<TopicClassStats> classes;
+    std::vector<TenantStats> tenants;
+};
+
+namespace detail {
+
+struct TopicClassState
+{
+    TopicClassState(std::string class_name, int class_priority)
+        : name(std::move(class_name)), priority(class_priority)
+    {
+    }
+
+    const std::string name;
+    std::atomic<int> priority;
+    std::atomic<std::uint64_t> admitted{0};
+    std::atomic<std::uint64_t> executed{0};
+    std::atomic<std::uint64_t> shed{0};
+};
+
+struct TenantState
+{
+    TenantState(std::string tenant_name, std::uint32_t tenant_weight)
+        : name(std::move(tenant_name)), weight(std::max<std::uint32_t>(tenant_weight, 1))
+    {
+    }
+
+    const std::string name;
+    std::atomic<std::uint32_t> weight;
+    std::atomic<std::uint64_t> queued{0};
+    std::atomic<std::uint64_t> executed{0};
+    std::atomic<std::uint64_t> cpu_ns{0};
+};
+
+/// CPU time consumed by the calling thread; wall time where unavailable.
+inline std::uint64_t thread_cpu_ns() noexcept
+{
+#if EVENTBUS_HAS_POSIX && defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec now {};
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0) {
+        return static_cast<std::uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(now.tv_nsec);
+    }
+#endif
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Worker threads behind publishAsync()
+ *
+ * Events wait in one FIFO per flow: per tenant, or per topic for topics
+ * without a tenant. Workers serve the flows by deficit round robin with
+ * measured CPU time as the cost, so a noisy topic gets its weighted share
+ * of the workers rather than all of them.
+ *
+ * Every event is stamped when queued. Workers track the smallest queueing
+ * delay seen per interval: when even that minimum stays above the target
+ * the queue is standing, not bursting, and the controller sheds one more
+ * priority level (lowest first), both at admission and for events already
+ * queued. Each interval whose minimum drops below half the target (or that
+ * finds the queue idle) re-admits one level.
+ *
+ * With AsyncOptions::fibers set, each event runs on a fiber pinned to the
+ * worker that started it. A fiber parked in this_fiber::sleep_for() or
+ * run_blocking() frees the worker for other events; readied fibers resume
+ * before new events start, and every slice of CPU they use is charged to
+ * their flow.
+ */
+class WorkerPool
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit WorkerPool(AsyncOptions options)
+        : options_(options)
+    {
+        options_.workers = std::max<std::size_t>(options_.workers, 1);
+        options_.interval = std::max(options_.interval, std::chrono::milliseconds(1));
+        options_.quantum = std::max(options_.quantum, std::chrono::microseconds(1));
+#if !EVENTBUS_HAS_FIBERS
+        options_.fibers = 0;
+#endif
+        window_start_ = Clock::now();
+        priorities_.push_back(options_.default_priority);
+        if (options_.fibers > 0) {
+            blocking_ = std::make_unique<BlockingPool>(options_.blocking_threads);
+        }
+        hosts_.reserve(options_.workers);
+        for (std::size_t i = 0; i < options_.workers; ++i) {
+            hosts_.push_back(std::make_unique<Host>(*this));
+        }
+        workers_.reserve(options_.workers);
+        for (std::size_t i = 0; i < options_.workers; ++i) {
+            workers_.emplace_back([this, i]() { run(*hosts_[i]); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool()
+    {
+        stop();
+    }
+
+    /**
+     * Queues @p task on the flow @p flow_key unless its class is being shed;
+     * false means shed. @p on_shed runs instead of the task when it is shed
+     * after being queued.
+     */
+    bool submit(const std::shared_ptr<TopicClassState>& topic_class, const std::shared_ptr<TenantState>& tenant,
+                const std::string& flow_key, std::function<void()> task, std::function<void()> on_shed = {})
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return false;
+            }
+            if (is_shed(*topic_class) || queued_ >= options_.max_queued) {
+                topic_class->shed.fetch_add(1, std::memory_order_relaxed);
+                ++shed_;
+                return false;
+            }
+
+            auto& flow = flows_[flow_key];
+            if (!flow) {
+                flow = std::make_unique<Flow>();
+                flow->key = flow_key;
+                flow->tenant = tenant;
+                flow->estimate = std::chrono::duration_cast<std::chrono::nanoseconds>(options_.quantum).count();
+            }
+            flow->tasks.push_back(Task{std::move(task), std::move(on_shed), topic_class, Clock::now()});
+            if (!flow->active) {
+                flow->active = true;
+                flow->deficit = 0;
+                active_.push_back(flow.get());
+            }
+            ++queued_;
+        }
+        topic_class->admitted.fetch_add(1, std::memory_order_relaxed);
+        tenant->queued.fetch_add(1, std::memory_order_relaxed);
+        if (options_.fibers > 0) {
+            cv_.notify_all();       // a worker at its fiber limit ignores the wakeup
+        } else {
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    /// The distinct priorities in use; the controller sheds them lowest first.
+    void set_priorities(std::vector<int> priorities)
+    {
+        priorities.push_back(options_.default_priority);
+        std::sort(priorities.begin(), priorities.end());
+        priorities.erase(std::unique(priorities.begin(), priorities.end()), priorities.end());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        priorities_ = std::move(priorities);
+        level_ = std::min(level_, priorities_.size() - 1);
+    }
+
+    /**
+     * Runs what is already queued, including parked fibers, then joins the
+     * workers. Concurrent callers wait for the one doing the joins; a call
+     * from a worker itself (close() inside a subscriber) only signals, and
+     * the owner's call or the destructor joins.
+     */
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        const auto self = std::this_thread::get_id();
+        if (std::any_of(workers_.begin(), workers_.end(), [self](const std::thread& worker) {
+                return worker.get_id() == self;
+            })) {
+            return;
+        }
+        std::call_once(joined_, [this]() {
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+            if (blocking_) {
+                blocking_->stop();
+            }
+        });
+    }
+
+    void fill_stats(AsyncStats& stats) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.workers = workers_.size();
+        stats.queued = queued_;
+        stats.executed = executed_;
+        stats.shed = shed_;
+        stats.shed_level = level_;
+        stats.queue_delay = std::chrono::duration_cast<std::chrono::microseconds>(last_delay_);
+    }
+
+    [[nodiscard]] const AsyncOptions& options() const noexcept { return options_; }
+
+private:
+    struct Task
+    {
+        std::function<void()> run;
+        std::function<void()> on_shed;
+        std::shared_ptr<TopicClassState> topic_class;
+        Clock::time_point enqueued;
+        std::int64_t charged{0};    // estimate taken from the flow's deficit at dispatch, refunded at finish
+    };
+
+    struct Flow
+    {
+        std::string key;
+        std::shared_ptr<TenantState> tenant;
+        std::deque<Task> tasks;
+        std::int64_t deficit{0};    // ns of CPU time it may still use this round; negative is debt
+        std::int64_t estimate{0};   // moving average of CPU ns per event, charged up front at dispatch
+        std::size_t running{0};
+        bool active{false};
+    };
+
+    /// An event running on a fiber, with the CPU time it has used so far.
+    struct FiberJob
+    {
+        std::unique_ptr<Fiber> fiber;
+        Task task;
+        Flow* flow;
+        std::uint64_t cpu_ns{0};
+    };
+
+    /// Per-worker fiber state. Only ready is shared (under the pool mutex); the rest belongs to the worker thread.
+    class Host : public FiberHost
+    {
+    public:
+        explicit Host(WorkerPool& pool)
+            : pool_(pool)
+        {
+        }
+
+        void ready(Fiber* fiber) override
+        {
+            {
+                std::lock_guard<std::mutex> lock(pool_.mutex_);
+                ready_.push_back(fiber);
+            }
+            pool_.cv_.notify_all();
+        }
+
+        void sleep_until(Fiber* fiber, Clock::time_point deadline) override
+        {
+            sleepers_.emplace(deadline, fiber);
+        }
+
+        void run_blocking(std::function<void()> job, Fiber* fiber) override
+        {
+            pool_.blocking_->submit([this, job = std::move(job), fiber]() {
+                job();
+                ready(fiber);
+            });
+        }
+
+        std::deque<Fiber*> ready_;
+        std::multimap<Clock::time_point, Fiber*> sleepers_;
+        std::unordered_map<Fiber*, FiberJob> live_;
+        std::vector<std::unique_ptr<Fiber>> idle_;
+
+    private:
+        WorkerPool& pool_;
+    };
+
+    bool is_shed(const TopicClassState& topic_class) const
+    {
+        return level_ > 0 && topic_class.priority.load(std::memory_order_relaxed) < priorities_[level_];
+    }
+
+    /// Called with the mutex held after every dequeue and on idle wakeups.
+    void control(Clock::time_point now)
+    {
+        if (now - window_start_ < options_.interval) {
+            return;
+        }
+        const bool idle = window_min_ == Clock::duration::max();
+        const auto target = std::chrono::duration_cast<Clock::duration>(options_.target_delay);
+        if (!idle && window_min_ > target) {
+            level_ = std::min(level_ + 1, priorities_.size() - 1);
+        } else if (level_ > 0 && (idle || window_min_ < target / 2)) {
+            --level_;
+        }
+        last_delay_ = idle ? Clock::duration::zero() : window_min_;
+        window_start_ = now;
+        window_min_ = Clock::duration::max();
+    }
+
+    /**
+     * Deficit round robin: the head flow runs while it has credit, then goes
+     * to the back with a new quantum. Dispatch charges the flow's per-event
+     * estimate right away, so idle workers stop picking a flow once its
+     * running events would use up its credit, not only after they finish.
+     */
+    Flow* next_flow()
+    {
+        while (!active_.empty()) {
+            Flow* flow = active_.front();
+            if (flow->tasks.empty()) {
+                active_.pop_front();
+                flow->active = false;
+                flow->deficit = 0;
+                release_if_idle(*flow);
+                continue;
+            }
+            if (flow->deficit > 0) {
+                return flow;
+            }
+            const auto quantum = std::chrono::duration_cast<std::chrono::nanoseconds>(options_.quantum).count();
+            flow->deficit += quantum * flow->tenant->weight.load(std::memory_order_relaxed);
+            active_.pop_front();
+            active_.push_back(flow);
+        }
+        return nullptr;
+    }
+
+    void release_if_idle(Flow& flow)
+    {
+        if (!flow.active && flow.running == 0 && flow.tasks.empty()) {
+            flows_.erase(flow.key);
+        }
+    }
+
+    void run(Host& host)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            if (!host.ready_.empty()) {
+                Fiber* const fiber = host.ready_.front();
+                host.ready_.pop_front();
+                lock.unlock();
+                resume(host, fiber);
+                lock.lock();
+                continue;
+            }
+            const auto now = Clock::now();
+            if (!host.sleepers_.empty() && host.sleepers_.begin()->first <= now) {
+                for (auto it = host.sleepers_.begin(); it != host.sleepers_.end() && it->first <= now;) {
+                    host.ready_.push_back(it->second);
+                    it = host.sleepers_.erase(it);
+                }
+                continue;
+            }
+
+            Flow* flow = options_.fibers == 0 || host.live_.size() < options_.fibers ? next_flow() : nullptr;
+            if (flow == nullptr) {
+                if (stopping_ && host.live_.empty()) {
+                    return;
+                }
+                auto wait = std::chrono::duration_cast<Clock::duration>(options_.interval);
+                if (!host.sleepers_.empty()) {
+                    wait = std::min(wait, host.sleepers_.begin()->first - now);
+                }
+                cv_.wait_for(lock, wait);
+                control(Clock::now());
+                continue;
+            }
+
+            Task task = std::move(flow->tasks.front());
+            flow->tasks.pop_front();
+            --queued_;
+            flow->tenant->queued.fetch_sub(1, std::memory_order_relaxed);
+            window_min_ = std::min(window_min_, now - task.enqueued);
+            control(now);
+            if (is_shed(*task.topic_class)) {
+                task.topic_class->shed.fetch_add(1, std::memory_order_relaxed);
+                ++shed_;
+                if (task.on_shed) {
+                    lock.unlock();
+                    try {
+                        task.on_shed();
+                    }
+                    catch (...) {
+                    }
+                    lock.lock();
+                }
+                continue;
+            }
+
+            task.charged = flow->estimate;
+            flow->deficit -= task.charged;
+            ++flow->running;
+            lock.unlock();
+            if (options_.fibers > 0 && start_fiber(host, task, flow)) {
+                lock.lock();
+                continue;
+            }
+
+            const std::uint64_t cpu_start = thread_cpu_ns();
+            try {
+                task.run();
+            }
+            catch (...) {
+            }
+            const std::uint64_t cpu_ns = thread_cpu_ns() - cpu_start;
+            lock.lock();
+            charge(*flow, cpu_ns);
+            finish(task, *flow, cpu_ns);
+        }
+    }
+
+    /// False when no stack could be allocated; the caller then runs the event inline.
+    bool start_fiber(Host& host, Task& task, Flow* flow)
+    {
+        std::unique_ptr<Fiber> fiber;
+        if (!host.idle_.empty()) {
+            fiber = std::move(host.idle_.back());
+            host.idle_.pop_back();
+        } else {
+            try {
+                fiber = std::make_unique<Fiber>(host, options_.fiber_stack);
+            }
+            catch (...) {
+                return false;
+            }
+        }
+        Fiber* const raw = fiber.get();
+        FiberJob& job = host.live_[raw];
+        job.fiber = std::move(fiber);
+        job.task = std::move(task);
+        job.flow = flow;
+        raw->reset([&job]() { job.task.run(); });
+        resume(host, raw);
+        return true;
+    }
+
+    /// Runs one slice of a fiber and charges its CPU time; called without the mutex.
+    void resume(Host& host, Fiber* fiber)
+    {
+        const std::uint64_t cpu_start = thread_cpu_ns();
+        const bool finished = fiber->resume();
+        const std::uint64_t cpu_ns = thread_cpu_ns() - cpu_start;
+
+        auto it = host.live_.find(fiber);
+        FiberJob& job = it->second;
+        job.cpu_ns += cpu_ns;
+        std::lock_guard<std::mutex> lock(mutex_);
+        charge(*job.flow, cpu_ns);
+        if (finished) {
+            finish(job.task, *job.flow, job.cpu_ns);
+            if (host.idle_.size() < 64) {
+                host.idle_.push_back(std::move(job.fiber));
+            }
+            host.live_.erase(it);
+        }
+    }
+
+    void charge(Flow& flow, std::uint64_t cpu_ns)
+    {
+        flow.deficit -= static_cast<std::int64_t>(std::max<std::uint64_t>(cpu_ns, 1));
+    }
+
+    /// Called with the mutex held once an event has run to completion; its actual CPU time was already charged.
+    void finish(const Task& task, Flow& flow, std::uint64_t cpu_ns)
+    {
+        flow.deficit += task.charged;
+        flow.estimate = std::max<std::int64_t>(1, flow.estimate + (static_cast<std::int64_t>(cpu_ns) - flow.estimate) / 8);
+        task.topic_class->executed.fetch_add(1, std::memory_order_relaxed);
+        flow.tenant->executed.fetch_add(1, std::memory_order_relaxed);
+        flow.tenant->cpu_ns.fetch_add(cpu_ns, std::memory_order_relaxed);
+        ++executed_;
+        --flow.running;
+        release_if_idle(flow);
+    }
+
+    AsyncOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, std::unique_ptr<Flow>> flows_;
+    std::deque<Flow*> active_;                  // flows with queued events, in round-robin order
+    std::size_t queued_{0};
+    std::vector<std::unique_ptr<Host>> hosts_;
+    std::vector<std::thread> workers_;
+    std::once_flag joined_;
+    std::unique_ptr<BlockingPool> blocking_;
+    bool stopping_{false};
+    std::vector<int> priorities_;               // ascending; level_ sheds all below priorities_[level_]
+    std::size_t level_{0};
+    Clock::time_point window_start_;
+    Clock::duration window_min_{Clock::duration::max()};
+    Clock::duration last_delay_{Clock::duration::zero()};
+    std::uint64_t executed_{0};
+    std::uint64_t shed_{0};
+};
+
+/// Async payloads outlive the caller, so character pointers are copied into strings.
+template <typename T>
+using async_value_t = std::conditional_t<std::is_same_v<std::decay_t<T>, const char*> ||
+                                             std::is_same_v<std::decay_t<T>, char*>,
+                                         std::string, std::decay_t<T>>;
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+// Micro-batching
+// ---------------------------------------------------------------------------
+
+struct BatchOptions
+{
+    std::size_t max_events{500};                    // deliver once this many events are buffered
+    std::chrono::microseconds max_delay{2000};      // ...or once the oldest has waited this long
+};
+
+/// Read-only run of buffered events; valid only for the duration of the callback.
+template <typename T>
+class BatchView
+{
+public:
+    using value_type = T;
+
+    BatchView(const T* data, std::size_t size) noexcept
+        : data_(data), size_(size)
+    {
+    }
+
+    [[nodiscard]] const T* begin() const noexcept { return data_; }
+    [[nodiscard]] const T* end() const noexcept { return data_ + size_; }
+    [[nodiscard]] const T* data() const noexcept { return data_; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    const T& operator[](std::size_t index) const noexcept { return data_[index]; }
+
+private:
+    const T* data_;
+    std::size_t size_;
+};
+
+/**
+ * @brief Field layout of a struct for columnar batches
+ *
+ * Specialize with a `fields` tuple of member pointers, most conveniently
+ * through EVENTBUS_BATCH_FIELDS:
+ *
+ *     struct Trade { double price; std::int32_t qty; };
+ *     EVENTBUS_BATCH_FIELDS(Trade, &Trade::price, &Trade::qty);
+ *
+ * Field indices in ColumnBatch and BatchFilter follow the tuple order.
+ */
+template <typename T>
+struct BatchFields;
+
+#define EVENTBUS_BATCH_FIELDS(Type, ...)                                \
+    template <>                                                         \
+    struct eventbus::BatchFields<Type>                                  \
+    {                                                                   \
+        static constexpr auto fields = std::make_tuple(__VA_ARGS__);    \
+    }
+
+namespace detail {
+
+template <typename T, typename = void>
+struct has_batch_fields : std::false_type {};
+
+template <typename T>
+struct has_batch_fields<T, std::void_t<decltype(BatchFields<T>::fields)>> : std::true_type {};
+
+template <typename T>
+inline constexpr bool has_batch_fields_v = has_batch_fields<T>::value;
+
+template <typename MemberPointer>
+struct member_pointer_traits;
+
+template <typename Class, typename Member>
+struct member_pointer_traits<Member Class::*>
+{
+    using type = Member;
+};
+
+template <typename T, std::size_t Field>
+using batch_member_t = typename member_pointer_traits<
+    std::decay_t<std::tuple_element_t<Field, std::decay_t<decltype(BatchFields<T>::fields)>>>>::type;
+
+template <typename T, typename Indices>
+struct batch_columns;
+
+template <typename T, std::size_t... Fields>
+struct batch_columns<T, std::index_sequence<Fields...>>
+{
+    using type = std::tuple<std::vector<batch_member_t<T, Fields>>...>;
+};
+
+} // namespace detail
+
+/**
+ * @brief Structure-of-arrays batch of a trivially copyable struct
+ *
+ * Each registered field is stored in its own contiguous column, so
+ * subscribers and filters stream through only the fields they read.
+ * Unregistered fields are not stored.
+ */
+template <typename T>
+class ColumnBatch
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Columnar batches hold trivially copyable structs");
+    static_assert(detail::has_batch_fields_v<T>, "Register the fields of T with EVENTBUS_BATCH_FIELDS");
+
+    static constexpr std::size_t fields_ = std::tuple_size_v<std::decay_t<decltype(BatchFields<T>::fields)>>;
+    using Indices = std::make_index_sequence<fields_>;
+
+public:
+    using value_type = T;
+
+    template <std::size_t Field>
+    using field_type = detail::batch_member_t<T, Field>;
+
+    static constexpr std::size_t field_count() noexcept { return fields_; }
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+    template <std::size_t Field>
+    [[nodiscard]] BatchView<field_type<Field>> column() const noexcept
+    {
+        const auto& values = std::get<Field>(columns_);
+        return BatchView<field_type<Field>>(values.data(), size_);
+    }
+
+    /// Reassembles one event; fields that were not registered are value-initialized.
+    [[nodiscard]] T row(std::size_t index) const
+    {
+        T value{};
+        gather(value, index, Indices{});
+        return value;
+    }
+
+    void reserve(std::size_t capacity) { reserve(capacity, Indices{}); }
+
+    void emplace_back(const T& value)
+    {
+        scatter(value, Indices{});
+        ++size_;
+    }
+
+    void clear() noexcept
+    {
+        std::apply([](auto&... values) { (values.clear(), ...); }, columns_);
+        size_ = 0;
+    }
+
+    void swap(ColumnBatch& other) noexcept
+    {
+        columns_.swap(other.columns_);
+        std::swap(size_, other.size_);
+    }
+
+private:
+    template <std::size_t... Fields>
+    void reserve(std::size_t capacity, std::index_sequence<Fields...>)
+    {
+        (std::get<Fields>(columns_).reserve(capacity), ...);
+    }
+
+    template <std::size_t... Fields>
+    void scatter(const T& value, std::index_sequence<Fields...>)
+    {
+        (std::get<Fields>(columns_).push_back(value.*std::get<Fields>(BatchFields<T>::fields)), ...);
+    }
+
+    template <std::size_t... Fields>
+    void gather(T& value, std::size_t index, std::index_sequence<Fields...>) const
+    {
+        ((value.*std::get<Fields>(BatchFields<T>::fields) = std::get<Fields>(columns_)[index]), ...);
+    }
+
+    typename detail::batch_columns<T, Indices>::type columns_;
+    std::size_t size_{0};
+};
+
+namespace detail {
+
+template <typename T>
+struct batch_view_traits : std::false_type {};
+
+template <typename T>
+struct batch_view_traits<BatchView<T>> : std::true_type
+{
+    using element_type = T;
+};
+
+template <typename T>
+struct is_column_batch : std::false_type {};
+
+template <typename T>
+struct is_column_batch<ColumnBatch<T>> : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_column_batch_v = is_column_batch<T>::value;
+
+class BatchSink
+{
+public:
+    virtual ~BatchSink() = default;
+    /// Called once the subscription is removed or the bus closes: delivers whatever is buffered, or completes a pending one-shot.
+    virtual void close() = 0;
+};
+
+/**
+ * @brief Per-subscriber buffer behind subscribeBatched()
+ *
+ * Publishers append under a short lock into a buffer reserved for a full
+ * batch. The publish that fills it seals the batch; otherwise the first
+ * event of a batch arms a one-shot timer on the bus timer queue that seals
+ * it when max_delay expires. Sealed batches queue in order and one thread at
+ * a time delivers them: whoever seals a batch while another thread is
+ * delivering leaves it to that thread instead of waiting, so a publisher is
+ * never blocked behind a callback (which may itself be unsubscribing and
+ * waiting for that publisher). Delivered buffers are recycled, and batches
+ * reach the callback in publish order. @p Buffer is std::vector for row
+ * batches or ColumnBatch for columnar ones.
+ */
+template <typename Buffer>
+class MicroBatcher : public BatchSink
+{
+public:
+    using value_type = typename Buffer::value_type;
+    using Deliver = std::function<void(const Buffer&)>;
+    using Arm = std::function<void(std::uint64_t generation)>;
+
+    MicroBatcher(BatchOptions options, Deliver deliver)
+        : options_(options), deliver_(std::move(deliver))
+    {
+        options_.max_events = std::max<std::size_t>(options_.max_events, 1);
+        buffer_.reserve(options_.max_events);
+    }
+
+    /// Set once by the bus before the first add().
+    void set_arm(Arm arm) { arm_ = std::move(arm); }
+
+    template <typename... Values>
+    void add(Values&&... values)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffer_.emplace_back(std::forward<Values>(values)...);
+        if (closed_ || buffer_.size() >= options_.max_events) {
+            seal_locked();
+            drain(lock);
+            return;
+        }
+        if (buffer_.size() == 1) {
+            const std::uint64_t generation = ++generation_;
+            lock.unlock();
+            if (arm_) {
+                arm_(generation);
+            }
+        }
+    }
+
+    /// Timer callback: delivers the batch @p generation if it is still buffered.
+    void expire(std::uint64_t generation)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (generation == generation_ && !buffer_.empty()) {
+            seal_locked();
+            drain(lock);
+        }
+    }
+
+    /// Delivers what is buffered now; from inside the callback, right after it returns.
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!buffer_.empty()) {
+            seal_locked();
+        }
+        drain_all(lock);
+    }
+
+    void close() override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        closed_ = true;
+        if (!buffer_.empty()) {
+            seal_locked();
+        }
+        // Also waits out a delivery still running on another thread, e.g. the timer thread.
+        drain_all(lock);
+    }
+
+    [[nodiscard]] const BatchOptions& options() const noexcept { return options_; }
+
+private:
+    /// Queues the buffer for delivery and starts a new one; called with mutex_ held.
+    void seal_locked()
+    {
+        pending_.push_back(std::move(buffer_));
+        ++generation_;
+        if (!spare_.empty()) {
+            buffer_ = std::move(spare_.back());
+            spare_.pop_back();
+        } else {
+            buffer_ = Buffer{};
+            buffer_.reserve(options_.max_events);
+        }
+    }
+
+    /// Delivers queued batches in order unless another thread already is; never waits for it.
+    void drain(std::unique_lock<std::mutex>& lock)
+    {
+        if (delivering_) {
+            return;
+        }
+        delivering_ = true;
+        deliverer_ = ExecutionId::current();
+        while (!pending_.empty()) {
+            Buffer batch = std::move(pending_.front());
+            pending_.pop_front();
+            lock.unlock();
+            try {
+                deliver_(batch);
+            }
+            catch (...) {
+                // The remaining batches go out with the next add(), expire(), flush() or close().
+                lock.lock();
+                recycle_locked(std::move(batch));
+                stop_delivering();
+                throw;
+            }
+            lock.lock();
+            recycle_locked(std::move(batch));
+        }
+        stop_delivering();
+    }
+
+    /// drain(), then waits for a delivery on another thread and whatever it leaves behind.
+    void drain_all(std::unique_lock<std::mutex>& lock)
+    {
+        if (delivering_ && deliverer_ == ExecutionId::current()) {
+            return;     // called from the callback; the loop below us delivers the rest
+        }
+        while (true) {
+            drain(lock);
+            if (pending_.empty() && !delivering_) {
+                return;
+            }
+            wait_for(drained_cv_, lock, [this]() { return !delivering_; });
+        }
+    }
+
+    void stop_delivering()
+    {
+        delivering_ = false;
+        deliverer_ = ExecutionId{};
+        drained_cv_.notify_all();
+    }
+
+    void recycle_locked(Buffer batch)
+    {
+        batch.clear();
+        spare_.push_back(std::move(batch));
+    }
+
+    BatchOptions options_;
+    Deliver deliver_;
+    Arm arm_;
+    std::mutex mutex_;
+    std::condition_variable drained_cv_;
+    Buffer buffer_;
+    std::deque<Buffer> pending_;            // sealed, in publish order
+    std::vector<Buffer> spare_;
+    std::uint64_t generation_{0};
+    bool delivering_{false};
+    ExecutionId deliverer_;
+    bool closed_{false};
+};
+
+} // namespace detail
+
+namespace detail {
+
+/// Index of the lowest set bit of a non-zero word.
+inline unsigned lowest_bit(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned index = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+template <bool LowInclusive, bool HighInclusive>
+inline bool in_range(double value, double low, double high) noexcept
+{
+    const bool above = LowInclusive ? value >= low : value > low;
+    const bool below = HighInclusive ? value <= high : value < high;
+    return above && below;
+}
+
+/**
+ * ANDs into @p mask one bit per value: set when the value lies between
+ * @p low and @p high. Full 64-value words use AVX or SSE2 compares when the
+ * build enables them; NaN never matches.
+ */
+template <bool LowInclusive, bool HighInclusive>
+void mask_range(const double* values, std::size_t count, double low, double high, std::uint64_t* mask) noexcept
+{
+    const std::size_t words = count / 64;
+#if EVENTBUS_HAS_AVX
+    constexpr int low_op = LowInclusive ? _CMP_GE_OQ : _CMP_GT_OQ;
+    constexpr int high_op = HighInclusive ? _CMP_LE_OQ : _CMP_LT_OQ;
+    const __m256d low_v = _mm256_set1_pd(low);
+    const __m256d high_v = _mm256_set1_pd(high);
+    for (std::size_t w = 0; w < words; ++w) {
+        const double* block = values + w * 64;
+        std::uint64_t bits = 0;
+        for (unsigned i = 0; i < 64; i += 4) {
+            const __m256d v = _mm256_loadu_pd(block + i);
+            const __m256d hit = _mm256_and_pd(_mm256_cmp_pd(v, low_v, low_op), _mm256_cmp_pd(v, high_v, high_op));
+            bits |= static_cast<std::uint64_t>(_mm256_movemask_pd(hit)) << i;
+        }
+        mask[w] &= bits;
+    }
+#elif EVENTBUS_HAS_SSE2
+    const __m128d low_v = _mm_set1_pd(low);
+    const __m128d high_v = _mm_set1_pd(high);
+    for (std::size_t w = 0; w < words; ++w) {
+        const double* block = values + w * 64;
+        std::uint64_t bits = 0;
+        for (unsigned i = 0; i < 64; i += 2) {
+            const __m128d v = _mm_loadu_pd(block + i);
+            const __m128d above = LowInclusive ? _mm_cmpge_pd(v, low_v) : _mm_cmpgt_pd(v, low_v);
+            const __m128d below = HighInclusive ? _mm_cmple_pd(v, high_v) : _mm_cmplt_pd(v, high_v);
+            bits |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_and_pd(above, below))) << i;
+        }
+        mask[w] &= bits;
+    }
+#else
+    for (std::size_t w = 0; w < words; ++w) {
+        std::uint64_t bits = 0;
+        for (unsigned i = 0; i < 64; ++i) {
+            bits |= static_cast<std::uint64_t>(in_range<LowInclusive, HighInclusive>(values[w * 64 + i], low, high)) << i;
+        }
+        mask[w] &= bits;
+    }
+#endif
+    if (count % 64 != 0) {
+        std::uint64_t bits = 0;
+        for (std::size_t i = words * 64; i < count; ++i) {
+            bits |= static_cast<std::uint64_t>(in_range<LowInclusive, HighInclusive>(values[i], low, high)) << (i % 64);
+        }
+        mask[words] &= bits;
+    }
+}
+
+template <typename T, std::size_t Field>
+struct batch_field
+{
+    using type = std::tuple_element_t<Field, T>;
+
+    static double get(const T& event) noexcept { return static_cast<double>(std::get<Field>(event)); }
+};
+
+template <typename T>
+struct batch_field_scalar
+{
+    using type = T;
+
+    static double get(const T& event) noexcept { return static_cast<double>(event); }
+};
+
+template <typename T, std::size_t Field>
+struct batch_field_member
+{
+    using type = batch_member_t<T, Field>;
+
+    static double get(const T& event) noexcept
+    {
+        return static_cast<double>(event.*std::get<Field>(BatchFields<T>::fields));
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Declarative numeric filter for batched subscriptions
+ *
+ * Each predicate bounds one field: a tuple index of T, a field registered
+ * with EVENTBUS_BATCH_FIELDS, or 0 when T itself is arithmetic. Events pass
+ * when every predicate holds. On delivery the bus compares each filtered
+ * column with SIMD (row batches first copy the field out), then hands the
+ * subscriber a selection vector of the passing indices. Fields compare as
+ * double, so integers beyond 2^53 round.
+ */
+template <typename T>
+class BatchFilter
+{
+public:
+    template <std::size_t Field>
+    BatchFilter& greater(double value) { return add<Field, false, true>(value, infinity()); }
+
+    template <std::size_t Field>
+    BatchFilter& greater_equal(double value) { return add<Field, true, true>(value, infinity()); }
+
+    template <std::size_t Field>
+    BatchFilter& less(double value) { return add<Field, true, false>(-infinity(), value); }
+
+    template <std::size_t Field>
+    BatchFilter& less_equal(double value) { return add<Field, true, true>(-infinity(), value); }
+
+    /// Inclusive on both ends.
+    template <std::size_t Field>
+    BatchFilter& between(double low, double high) { return add<Field, true, true>(low, high); }
+
+    template <std::size_t Field>
+    BatchFilter& equal(double value) { return add<Field, true, true>(value, value); }
+
+    [[nodiscard]] bool empty() const noexcept { return predicates_.empty(); }
+
+    /**
+     * Writes the indices of the events of @p batch that pass into
+     * @p selection, in order. Reuses internal scratch buffers, so one filter
+     * must not select on several threads at once.
+     */
+    void select(BatchView<T> batch, std::vector<std::uint32_t>& selection) const
+    {
+        const std::size_t count = batch.size();
+        reset_mask(count);
+        column_.resize(count);
+        for (const auto& predicate : predicates_) {
+            predicate.extract(batch.data(), count, column_.data());
+            predicate.evaluate(column_.data(), count, predicate.low, predicate.high, mask_.data());
+        }
+        collect(selection);
+    }
+
+    /// Columnar form of select(): double columns are compared in place, others converted in one pass.
+    template <typename Event = T>
+    void select(const ColumnBatch<Event>& batch, std::vector<std::uint32_t>& selection) const
+    {
+        const std::size_t count = batch.size();
+        reset_mask(count);
+        column_.resize(count);
+        for (const auto& predicate : predicates_) {
+            const double* values = predicate.column(batch, column_.data());
+            predicate.evaluate(values, count, predicate.low, predicate.high, mask_.data());
+        }
+        collect(selection);
+    }
+
+private:
+    struct Predicate
+    {
+        void (*extract)(const T* events, std::size_t count, double* column);
+        const double* (*column)(const ColumnBatch<T>& batch, double* scratch);     // null unless T has fields
+        void (*evaluate)(const double* values, std::size_t count, double low, double high, std::uint64_t* mask);
+        double low;
+        double high;
+    };
+
+    void reset_mask(std::size_t count) const
+    {
+        mask_.assign((count + 63) / 64, ~std::uint64_t{0});
+        if (count % 64 != 0) {
+            mask_.back() = (std::uint64_t{1} << (count % 64)) - 1;
+        }
+    }
+
+    void collect(std::vector<std::uint32_t>& selection) const
+    {
+        selection.clear();
+        for (std::size_t w = 0; w < mask_.size(); ++w) {
+            for (std::uint64_t bits = mask_[w]; bits != 0; bits &= bits - 1) {
+                selection.push_back(static_cast<std::uint32_t>(w * 64 + detail::lowest_bit(bits)));
+            }
+        }
+    }
+
+    static constexpr double infinity() noexcept { return std::numeric_limits<double>::infinity(); }
+
+    template <std::size_t Field>
+    static auto field_access()
+    {
+        if constexpr (std::is_arithmetic_v<T>) {
+            return detail::batch_field_scalar<T>{};
+        } else if constexpr (detail::has_batch_fields_v<T>) {
+            return detail::batch_field_member<T, Field>{};
+        } else {
+            return detail::batch_field<T, Field>{};
+        }
+    }
+
+    template <std::size_t Field>
+    using field_t = decltype(field_access<Field>());
+
+    template <std::size_t Field>
+    static void extract(const T* events, std::size_t count, double* column) noexcept
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            column[i] = field_t<Field>::get(events[i]);
+        }
+    }
+
+    template <std::size_t Field>
+    static const double* column(const ColumnBatch<T>& batch, double* scratch) noexcept
+    {
+        const auto values = batch.template column<Field>();
+        if constexpr (std::is_same_v<typename decltype(values)::value_type, double>) {
+            return values.data();
+        } else {
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                scratch[i] = static_cast<double>(values[i]);
+            }
+            return scratch;
+        }
+    }
+
+    template <std::size_t Field, bool LowInclusive, bool HighInclusive>
+    BatchFilter& add(double low, double high)
+    {
+        static_assert(!std::is_arithmetic_v<T> || Field == 0, "An arithmetic event has only field 0");
+        static_assert(std::is_arithmetic_v<std::decay_t<typename field_t<Field>::type>>,
+                      "Batch filters apply to arithmetic fields");
+        Predicate predicate{&extract<Field>, nullptr, &detail::mask_range<LowInclusive, HighInclusive>, low, high};
+        if constexpr (detail::has_batch_fields_v<T> && std::is_trivially_copyable_v<T>) {
+            predicate.column = &column<Field>;
+        }
+        predicates_.push_back(predicate);
+        return *this;
+    }
+
+    std::vector<Predicate> predicates_;
+    mutable std::vector<double> column_;
+    mutable std::vector<std::uint64_t> mask_;
+};
+
+// ---------------------------------------------------------------------------
+// Time-ordered merge
+// ---------------------------------------------------------------------------
+
+struct MergeOptions
+{
+    std::int64_t lateness{0};               // how far behind the newest timestamp an event may arrive, in timestamp units
+    std::size_t max_buffered{100000};       // beyond it the oldest event is emitted without waiting
+};
+
+struct MergeStats
+{
+    std::size_t buffered;
+    std::uint64_t emitted;
+    std::uint64_t late;         // dropped: older than an event already emitted
+    std::uint64_t forced;       // emitted early because max_buffered was reached
+};
+
+/**
+ * @brief k-way merge of several topics in timestamp order
+ *
+ * Topic i publishes a single Events...[i]; the consumer receives a
+ * std::variant of them. Each input keeps a high-water mark, the newest
+ * timestamp it has delivered; the watermark is the lowest of them minus
+ * MergeOptions::lateness, so one fast input cannot push events past a
+ * slower one. Events wait in a min-heap until they are no newer than the
+ * watermark, then reach the consumer in timestamp order (ties in input
+ * order, then arrival order). Until every input has published, nothing is
+ * emitted except by max_buffered. Events older than one already emitted are
+ * dropped and counted as late. flush() emits everything buffered, as do
+ * removing any input subscription and closing the bus.
+ *
+ * Ready events are queued and handed to the consumer by one thread at a
+ * time; a publisher that finds another thread delivering leaves its events
+ * to it instead of waiting, so the consumer may publish to the inputs or
+ * unsubscribe them.
+ */
+template <typename... Events>
+class TopicMerge : public detail::BatchSink
+{
+public:
+    using Event = std::variant<Events...>;
+    using TimeOf = std::function<std::int64_t(const Event&)>;
+    using Consumer = std::function<void(const Event&)>;
+
+    TopicMerge(MergeOptions options, TimeOf time_of, Consumer consumer)
+        : options_(options), time_of_(std::move(time_of)), consumer_(std::move(consumer))
+    {
+        options_.lateness = std::max<std::int64_t>(options_.lateness, 0);
+        options_.max_buffered = std::max<std::size_t>(options_.max_buffered, 1);
+        high_water_.fill(std::numeric_limits<std::int64_t>::min());
+    }
+
+    /// Subscription ids of the inputs, in topic order.
+    [[nodiscard]] const std::vector<callback_id>& subscriptions() const noexcept { return subscriptions_; }
+
+    void push(std::size_t input, Event event)
+    {
+        const std::int64_t timestamp = time_of_(event);
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (emitted_any_ && timestamp < last_emitted_) {
+            ++late_;
+            return;
+        }
+        pending_.push_back(Pending{timestamp, input, next_sequence_++, std::move(event)});
+        std::push_heap(pending_.begin(), pending_.end(), later);
+        high_water_[input] = std::max(high_water_[input], timestamp);
+
+        const std::int64_t mark = watermark();
+        while (!pending_.empty() && (pending_.front().timestamp <= mark || pending_.size() > options_.max_buffered)) {
+            if (pending_.front().timestamp > mark) {
+                ++forced_;
+            }
+            ready_.push_back(pop());
+        }
+        drain(lock);
+    }
+
+    /// Emits what is buffered now; from inside the consumer, right after it returns.
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!pending_.empty()) {
+            ready_.push_back(pop());
+        }
+        drain_all(lock);
+    }
+
+    void close() override { flush(); }
+
+    [[nodiscard]] MergeStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return MergeStats{pending_.size(), emitted_, late_, forced_};
+    }
+
+private:
+    friend class EventBus;
+
+    struct Pending
+    {
+        std::int64_t timestamp;
+        std::size_t input;
+        std::uint64_t sequence;
+        Event event;
+    };
+
+    static bool later(const Pending& left, const Pending& right)
+    {
+        if (left.timestamp != right.timestamp) {
+            return left.timestamp > right.timestamp;
+        }
+        if (left.input != right.input) {
+            return left.input > right.input;
+        }
+        return left.sequence > right.sequence;
+    }
+
+    /// Lowest input high-water mark minus lateness, saturating; called with mutex_ held.
+    std::int64_t watermark() const noexcept
+    {
+        const std::int64_t low = *std::min_element(high_water_.begin(), high_water_.end());
+        if (low < std::numeric_limits<std::int64_t>::min() + options_.lateness) {
+            return std::numeric_limits<std::int64_t>::min();
+        }
+        return low - options_.lateness;
+    }
+
+    /// Called with mutex_ held.
+    Event pop()
+    {
+        std::pop_heap(pending_.begin(), pending_.end(), later);
+        Pending next = std::move(pending_.back());
+        pending_.pop_back();
+        last_emitted_ = next.timestamp;
+        emitted_any_ = true;
+        ++emitted_;
+        return std::move(next.event);
+    }
+
+    /// Delivers ready events in order unless another thread already is; never waits for it.
+    void drain(std::unique_lock<std::mutex>& lock)
+    {
+        if (delivering_ || ready_.empty()) {
+            return;
+        }
+        delivering_ = true;
+        deliverer_ = detail::ExecutionId::current();
+        std::exception_ptr failure;
+        while (!ready_.empty()) {
+            Event event = std::move(ready_.front());
+            ready_.pop_front();
+            lock.unlock();
+            try {
+                consumer_(event);
+            }
+            catch (...) {
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+            lock.lock();
+        }
+        delivering_ = false;
+        deliverer_ = detail::ExecutionId{};
+        drained_cv_.notify_all();
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    /// drain(), then waits for a delivery on another thread to finish.
+    void drain_all(std::unique_lock<std::mutex>& lock)
+    {
+        if (delivering_ && deliverer_ == detail::ExecutionId::current()) {
+            return;     // called from the consumer; the loop below us delivers the rest
+        }
+        detail::wait_for(drained_cv_, lock, [this]() { return !delivering_; });
+        drain(lock);
+    }
+
+    MergeOptions options_;
+    TimeOf time_of_;
+    Consumer consumer_;
+    std::vector<callback_id> subscriptions_;    // written once by the bus before the merge is returned
+    mutable std::mutex mutex_;
+    std::condition_variable drained_cv_;
+    std::vector<Pending> pending_;              // min-heap by (timestamp, input, sequence)
+    std::deque<Event> ready_;                   // popped, waiting for the consumer
+    std::array<std::int64_t, sizeof...(Events)> high_water_;   // newest timestamp per input
+    std::int64_t last_emitted_{std::numeric_limits<std::int64_t>::min()};
+    bool emitted_any_{false};
+    bool delivering_{false};
+    detail::ExecutionId deliverer_;
+    std::uint64_t next_sequence_{0};
+    std::uint64_t emitted_{0};
+    std::uint64_t late_{0};
+    std::uint64_t forced_{0};
+};
+
+/**
+ * @brief Optional callback result that stops the rest of a publish
+ *
+ * Callbacks may return void, bool (true means consumed) or Dispatch. Once a
+ * callback consumes the event, subscribers after it in priority order are
+ * not invoked.
+ */
+enum class Dispatch
+{
+    proceed,
+    consume
+};
+
+namespace detail {
+
+template<typename Ret>
+inline constexpr bool is_callback_result_v =
+    std::is_void_v<Ret> || std::is_same_v<Ret, bool> || std::is_same_v<Ret, Dispatch>;
+
+} // namespace detail
+
+class ICallbackWrapper
+{
+public:
+    virtual ~ICallbackWrapper() = default;
+    /// False on a type mismatch; @p consumed reports whether the callback stopped the publish.
+    virtual bool try_invoke(const std::any& args_any, bool& consumed) = 0;
+    virtual std::type_index get_args_type() const = 0;
+    virtual callback_id get_id() const = 0;
+};
+
+template<typename Ret, typename... Args>
+class CallbackWrapper : public ICallbackWrapper
+{
+    static_assert((!detail::is_nonconst_lvalue_reference<Args>::value && ...),
+                  "EventBus callbacks must not use non-const lvalue reference parameters");
+    static_assert(detail::is_callback_result_v<Ret>, "EventBus callbacks must return void, bool or Dispatch");
+
+private:
+    callback_id id_;
+    std::function<Ret(Args...)> callback_;
+
+public:
+    CallbackWrapper(callback_id id, std::function<Ret(Args...)> callback)
+        : id_(id), callback_(std::move(callback))
+    {
+    }
+
+    bool try_invoke(const std::any& args_any, bool& consumed) override
+    {
+        if constexpr (sizeof...(Args) == 0) {
+            if (args_any.has_value()) {
+                return false;
+            }
+            consumed = call();
+            return true;
+        } else {
+            // 1. Try exact match
+            if (auto args_tuple = std::any_cast<std::tuple<Args...>>(&args_any)) {
+                consumed = std::apply([this](auto&... values) { return call(values...); }, *args_tuple);
+                return true;
+            }
+
+            // 2. Try loose match
+            using DecayedArgs = std::tuple<std::decay_t<Args>...>;
+            if (auto args_tuple = std::any_cast<DecayedArgs>(&args_any)) {
+                consumed = std::apply([this](auto&... values) { return call(values...); }, *args_tuple);
+                return true;
+            }
+
+            // 3. Try smart type conversion
+            return try_universal_conversion(args_any, consumed);
+        }
+    }
+
+    std::type_index get_args_type() const override
+    {
+        return std::type_index(typeid(std::tuple<Args...>));
+    }
+
+    callback_id get_id() const override
+    {
+        return id_;
+    }
+
+private:
+    /// Invokes the callback and maps its result to "consumed".
+    template<typename... Params>
+    bool call(Params&&... params)
+    {
+        if constexpr (std::is_void_v<Ret>) {
+            callback_(std::forward<Params>(params)...);
+            return false;
+        } else if constexpr (std::is_same_v<Ret, bool>) {
+            return callback_(std::forward<Params>(params)...);
+        } else {
+            return callback_(std::forward<Params>(params)...) == Dispatch::consume;
+        }
+    }
+
+    bool try_universal_conversion(const std::any& args_any, bool& consumed)
+    {
+        return try_parameter_conversion(args_any, consumed, std::index_sequence_for<Args...>{});
+    }
+
+    template<std::size_t... Is>
+    bool try_parameter_conversion(const std::any& args_any, bool& consumed, std::index_sequence<Is...>)
+    {
+        using SourceTypes = std::tuple<typename detail::map_to_source_type<std::tuple_element_t<Is, std::tuple<Args...>>>::type...>;
+
+        if (auto source_tuple = std::any_cast<SourceTypes>(&args_any)) {
+            if (!can_convert_tuple(*source_tuple, std::index_sequence_for<Args...>{})) {
+                return false;
+            }
+
+            consumed = invoke_with_conversion(*source_tuple, std::index_sequence_for<Args...>{});
+            return true;
+        }
+
+        using AlternateSourceTypes = std::tuple<typename detail::alternate_map_to_source_type<std::tuple_element_t<Is, std::tuple<Args...>>>::type...>;
+        if constexpr (!std::is_same_v<SourceTypes, AlternateSourceTypes>) {
+            if (auto source_tuple = std::any_cast<AlternateSourceTypes>(&args_any)) {
+                if (!can_convert_tuple(*source_tuple, std::index_sequence_for<Args...>{})) {
+                    return false;
+                }
+
+                consumed = invoke_with_conversion(*source_tuple, std::index_sequence_for<Args...>{});
+                return true;
+            }
+        }
+
+        using InternedSourceTypes = std::tuple<typename detail::interned_map_to_source_type<std::tuple_element_t<Is, std::tuple<Args...>>>::type...>;
+        if constexpr (!std::is_same_v<InternedSourceTypes, std::tuple<std::decay_t<Args>...>>) {
+            if (auto source_tuple = std::any_cast<InternedSourceTypes>(&args_any)) {
+                consumed = call(pass_interned<std::tuple_element_t<Is, std::tuple<Args...>>>(std::get<Is>(*source_tuple))...);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Interned strings reach string_view and const std::string& parameters without a copy.
+    template<typename TargetType, typename SourceType>
+    static decltype(auto) pass_interned(const SourceType& source)
+    {
+        using DecayedTarget = std::decay_t<TargetType>;
+        if constexpr (!std::is_same_v<SourceType, InternedString>) {
+            return (source);
+        } else if constexpr (std::is_same_v<DecayedTarget, std::string_view>) {
+            return source.view();
+        } else if constexpr (std::is_reference_v<TargetType>) {
+            return (source.str());
+        } else {
+            return std::string(source.str());
+        }
+    }
+
+    template<typename SourceTuple, std::size_t... Is>
+    bool can_convert_tuple(const SourceTuple& source_tuple, std::index_sequence<Is...>) const
+    {
+        return (... && can_convert_parameter<std::tuple_element_t<Is, std::tuple<Args...>>>(std::get<Is>(source_tuple)));
+    }
+
+    template<typename TargetType, typename SourceType>
+    bool can_convert_parameter(const SourceType& source) const
+    {
+        using DecayedTarget = std::decay_t<TargetType>;
+        using DecayedSource = std::decay_t<SourceType>;
+
+        if constexpr (std::is_same_v<DecayedTarget, std::string> &&
+                      (std::is_same_v<DecayedSource, const char*> || std::is_same_v<DecayedSource, char*>)) {
+            return source != nullptr;
+        } else if constexpr (std::is_same_v<DecayedTarget, std::string_view> &&
+                             (std::is_same_v<DecayedSource, const char*> || std::is_same_v<DecayedSource, char*>)) {
+            return source != nullptr;
+        } else {
+            return true;
+        }
+    }
+
+    template<typename SourceTuple, std::size_t... Is>
+    bool invoke_with_conversion(const SourceTuple& source_tuple, std::index_sequence<Is...>)
+    {
+        return call(convert_parameter<std::tuple_element_t<Is, std::tuple<Args...>>>(std::get<Is>(source_tuple))...);
+    }
+
+    template<typename TargetType, typename SourceType>
+    std::decay_t<TargetType> convert_parameter(const SourceType& source)
+    {
+        using DecayedTarget = std::decay_t<TargetType>;
+
+        if constexpr (std::is_same_v<DecayedTarget, std::decay_t<SourceType>>) {
+            return source;
+        } else if constexpr (std::is_same_v<DecayedTarget, std::string> &&
+                             (std::is_same_v<std::decay_t<SourceType>, const char*> ||
+                              std::is_same_v<std::decay_t<SourceType>, char*>)) {
+            return std::string(source);
+        } else if constexpr (std::is_same_v<DecayedTarget, std::string> &&
+                             std::is_same_v<std::decay_t<SourceType>, std::string_view>) {
+            return std::string(source);
+        } else if constexpr (std::is_same_v<DecayedTarget, std::string_view> &&
+                             (std::is_same_v<std::decay_t<SourceType>, const char*> ||
+                              std::is_same_v<std::decay_t<SourceType>, char*>)) {
+            return std::string_view(source);
+        } else if constexpr (std::is_same_v<DecayedTarget, std::string_view> &&
+                             std::is_same_v<std::decay_t<SourceType>, std::string>) {
+            return std::string_view(source);
+        } else if constexpr (std::is_convertible_v<SourceType, DecayedTarget>) {
+            return static_cast<DecayedTarget>(source);
+        } else {
+            static_assert(detail::always_false<TargetType, SourceType>::value,
+                          "Unsupported event parameter conversion");
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Topic filter
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+/**
+ * @brief Counting Bloom filter over the topic names a registry holds
+ *
+ * Writers add and remove names while holding the registry's unique lock;
+ * readers test without locking. A miss is exact for every add that happened
+ * before the test, so a publish that misses can skip the registry. Hits may
+ * be false positives. A counter that saturates stays saturated, which only
+ * costs precision. While the filter is not exact, every test hits.
+ */
+class TopicFilter
+{
+public:
+    static constexpr std::size_t counters = 8192;   // power of two; 16 KiB
+    static constexpr std::size_t probes = 2;
+
+    /// @p hash is std::hash of the name.
+    void add(std::size_t hash) noexcept { update(hash, true); }
+    void remove(std::size_t hash) noexcept { update(hash, false); }
+
+    /// Name sets that the filter cannot represent, such as prefix patterns, turn it off.
+    void set_exact(bool exact) noexcept { exact_.store(exact, std::memory_order_release); }
+
+    [[nodiscard]] bool may_contain(std::size_t hash) const noexcept
+    {
+        if (!exact_.load(std::memory_order_acquire)) {
+            return true;
+        }
+        for (std::size_t i = 0; i < probes; ++i) {
+            if (counters_[index(hash, i)].load(std::memory_order_acquire) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::uint16_t saturated = std::numeric_limits<std::uint16_t>::max();
+
+    // Double hashing: an odd stride never revisits a counter within the probes.
+    static std::size_t index(std::size_t hash, std::size_t i) noexcept
+    {
+        const std::uint64_t stride = (static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL >> 32) | 1;
+        return static_cast<std::size_t>(hash + i * stride) & (counters - 1);
+    }
+
+    // Writers are serialized by the registry lock, so a load and a store suffice.
+    void update(std::size_t hash, bool add) noexcept
+    {
+        for (std::size_t i = 0; i < probes; ++i) {
+            std::atomic<std::uint16_t>& counter = counters_[index(hash, i)];
+            const std::uint16_t value = counter.load(std::memory_order_relaxed);
+            if (value == saturated || (!add && value == 0)) {
+                continue;
+            }
+            counter.store(static_cast<std::uint16_t>(add ? value + 1 : value - 1), std::memory_order_release);
+        }
+    }
+
+    std::array<std::atomic<std::uint16_t>, counters> counters_{};
+    std::atomic<bool> exact_{true};
+};
+
+} // namespace detail
+
+// ---------------------------------------------------------------------------
+// Federation
+// ---------------------------------------------------------------------------
+
+class EventBus;
+class BusLink;
+
+struct LinkOptions
+{
+    std::size_t max_events{64};                     // forward once this many events are buffered; 1 forwards inline
+    std::chrono::microseconds max_delay{1000};      // or once the oldest buffered event is this old
+};
+
+struct LinkStats
+{
+    std::size_t interest;           // topics the far bus currently wants over this direction
+    std::uint64_t interest_updates; // topics added or removed by the far bus's advertisements
+    std::uint64_t forwarded;        // events handed to the far bus
+    std::uint64_t batches;          // deliveries to the far bus; one per event when unbatched
+};
+
+namespace detail {
+
+/// One direction of a bus link: events published on the near bus that the far bus wants.
+/// Topics an advertisement adds to or removes from what the sender wants.
+struct InterestDelta
+{
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+};
+
+struct LinkEnd
+{
+    using Batcher = MicroBatcher<std::vector<std::function<void()>>>;
+
+    EventBus* from{nullptr};
+    EventBus* to{nullptr};
+    LinkEnd* reverse{nullptr};
+    std::shared_ptr<BusLink> link;                  // keeps the link alive while attached; accessed atomically
+    std::unique_ptr<Batcher> batcher;               // null when events are forwarded inline
+
+    // Guarded by the near bus's registry mutex.
+    bool attached{false};
+    std::unordered_set<std::string> interest;
+    std::uint64_t interest_updates{0};
+    std::uint64_t applied_seq{0};                   // last delta applied from the far bus
+    std::map<std::uint64_t, InterestDelta> early;   // deltas that overtook an earlier one, by sequence
+
+    // What the near bus last advertised over this direction.
+    std::mutex advert_mutex;
+    std::unordered_set<std::string> advertised;     // guarded by advert_mutex
+    std::uint64_t advert_seq{0};                    // guarded by advert_mutex
+    std::atomic<bool> advertising{false};           // set once both directions are attached
+
+    std::atomic<std::uint64_t> forwarded{0};
+    std::atomic<std::uint64_t> batches{0};
+
+    /// Pins the far bus for one forward; false once the link is shutting down.
+    bool enter() noexcept
+    {
+        in_flight_.fetch_add(1);
+        if (!open_.load()) {
+            leave();
+            return false;
+        }
+        return true;
+    }
+
+    void leave() noexcept
+    {
+        if (in_flight_.fetch_sub(1) == 1 && !open_.load()) {
+            std::lock_guard<std::mutex> lock(gate_mutex_);
+            gate_cv_.notify_all();
+        }
+    }
+
+    /// Refuses new forwards and waits out the ones running.
+    void shut()
+    {
+        open_.store(false);
+        std::unique_lock<std::mutex> lock(gate_mutex_);
+        gate_cv_.wait(lock, [this]() { return in_flight_.load() == 0; });
+    }
+
+private:
+    // Sequentially consistent: enter() loads open_ after its increment, shut() reads in_flight_ after its store.
+    std::atomic<bool> open_{true};
+    std::atomic<std::size_t> in_flight_{0};
+    std::mutex gate_mutex_;
+    std::condition_variable gate_cv_;
+};
+
+/// Set while a forwarded event is published on the far bus, so it is not sent back over the reverse direction.
+inline const LinkEnd*& link_skip() noexcept
+{
+    thread_local const LinkEnd* skip = nullptr;
+    return skip;
+}
+
+class LinkSkipGuard
+{
+public:
+    explicit LinkSkipGuard(const LinkEnd* skip) noexcept
+    {
+        link_skip() = skip;
+    }
+
+    LinkSkipGuard(const LinkSkipGuard&) = delete;
+    LinkSkipGuard& operator=(const LinkSkipGuard&) = delete;
+
+    ~LinkSkipGuard() { link_skip() = nullptr; }
+};
+
+} // namespace detail
+
+class AsyncScheduler;
+template <typename... Payload>
+class PublishSender;
+template <typename... Args>
+class NextEventSender;
+template <typename Replies, typename Payload>
+class RequestSender;
+
+namespace detail {
+struct SenderAccess;
+} // namespace detail
+
+class EventBus
+{
+public:
+    struct EventBusStats
+    {
+        std::size_t total_events;
+        std::size_t total_callbacks;
+        std::size_t max_callbacks_per_event;
+        std::string most_subscribed_event;
+    };
+
+    struct PublishResult
+    {
+        std::size_t subscribers;
+        std::size_t invoked;
+        std::size_t failed;
+        std::size_t type_mismatches;
+        std::size_t skipped;
+        std::size_t journaled;
+        std::size_t durable;
+        std::size_t logged;
+        std::size_t compacted;
+        std::size_t shared;
+        std::size_t throttled;
+        std::size_t delayed;
+        std::size_t forwarded;      // bus links the event was handed to
+        bool consumed;              // a callback stopped dispatch to lower-priority subscribers
+    };
+
+private:
+    using CallbackPtr = std::shared_ptr<ICallbackWrapper>;
+
+    struct CallbackEntry
+    {
+        explicit CallbackEntry(CallbackPtr callback_wrapper)
+            : callback(std::move(callback_wrapper))
+        {
+        }
+
+        CallbackPtr callback;
+        std::shared_ptr<detail::BatchSink> batch;       // set for subscribeBatched()
+        int priority{0};
+        bool active{true};
+        std::size_t in_flight{0};
+        std::unordered_map<detail::ExecutionId, std::size_t, detail::ExecutionIdHash> invoking;    // per fiber or thread
+        mutable std::mutex state_mutex;
+        std::condition_variable idle_cv;
+    };
+
+    using CallbackEntryPtr = std::shared_ptr<CallbackEntry>;
+    using CallbackList = std::vector<CallbackEntryPtr>;
+
+    // Per-topic settings; replaced wholesale on change so publishers can share them.
+    struct TopicFeatures
+    {
+        bool journaled{false};
+        bool durable{false};
+        std::shared_ptr<EventLog> log;
+        std::shared_ptr<CompactedStore> compacted;
+#if EVENTBUS_HAS_POSIX
+        std::shared_ptr<SharedRing> shared_ring;
+#endif
+    };
+
+    using TopicFeaturesPtr = std::shared_ptr<const TopicFeatures>;
+    using LinkEnds = std::vector<std::shared_ptr<detail::LinkEnd>>;
+
+    struct TopicSnapshot
+    {
+        std::shared_ptr<const CallbackList> callbacks;  // null when the topic has no subscribers
+        TopicFeaturesPtr features;
+        std::shared_ptr<EventJournal> journal;
+        std::shared_ptr<RateLimiter> limiter;
+        std::shared_ptr<detail::TopicClassState> topic_class;
+        std::shared_ptr<detail::TenantState> tenant;
+        std::shared_ptr<const LinkEnds> links;          // links whose far bus wants the topic
+        std::uint64_t version{0};                       // registry version it was taken at
+        std::uint64_t topic_version{0};                 // fast-path slot version it was taken at
+        std::uint32_t time_weight{1};                   // hot-topic timing: 0 skips, N charges N times
+
+        [[nodiscard]] std::size_t subscriber_count() const noexcept { return callbacks ? callbacks->size() : 0; }
+    };
+
+    // Resolved settings of one promoted topic; never changed once a slot publishes it.
+    struct PromotedTopic
+    {
+        std::size_t hash;
+        std::string name;
+        TopicSnapshot snapshot;
+    };
+
+    /**
+     * One fast-path slot. Publishers read `current` inside a FastPathReader
+     * and never wait; writers serialize on `update_mutex`, swap in a new
+     * PromotedTopic and free the old one once both reader counters drained.
+     * `version` is bumped whenever a topic hashing to the slot changes, so a
+     * change to one topic only invalidates its own slot.
+     */
+    struct alignas(64) FastPathSlot
+    {
+        FastPathSlot() = default;
+        FastPathSlot(const FastPathSlot&) = delete;
+        FastPathSlot& operator=(const FastPathSlot&) = delete;
+        ~FastPathSlot() { delete current.load(std::memory_order_relaxed); }
+
+        std::atomic<const PromotedTopic*> current{nullptr};
+        std::atomic<std::uint64_t> version{0};
+        std::atomic<std::uint32_t> epoch{0};
+        std::atomic<std::uint32_t> readers[2] = {};
+        std::atomic<std::uint64_t> hits{0};
+        std::mutex update_mutex;
+    };
+
+    /// Keeps the slot's current topic alive while a publisher copies its snapshot.
+    class FastPathReader
+    {
+    public:
+        explicit FastPathReader(FastPathSlot& slot)
+            : slot_(slot), side_(slot.epoch.load(std::memory_order_seq_cst) & 1)
+        {
+            slot_.readers[side_].fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        FastPathReader(const FastPathReader&) = delete;
+        FastPathReader& operator=(const FastPathReader&) = delete;
+
+        ~FastPathReader() { slot_.readers[side_].fetch_sub(1, std::memory_order_release); }
+
+        [[nodiscard]] const PromotedTopic* topic() const noexcept
+        {
+            return slot_.current.load(std::memory_order_seq_cst);
+        }
+
+    private:
+        FastPathSlot& slot_;
+        std::uint32_t side_;
+    };
+
+    static constexpr std::uint32_t fast_path_time_sample = 8;
+
+    struct FastPathTable
+    {
+        explicit FastPathTable(FastPathOptions opts)
+            : options(opts)
+        {
+            std::size_t count = 1;
+            while (count < std::max<std::size_t>(options.slots, 1)) {
+                count <<= 1;
+            }
+            options.slots = count;
+            slots.reset(new FastPathSlot[count]);
+        }
+
+        FastPathSlot& slot(std::size_t hash) noexcept { return slots[hash & (options.slots - 1)]; }
+
+        FastPathOptions options;
+        std::unique_ptr<FastPathSlot[]> slots;
+    };
+
+    enum class InvokeStatus
+    {
+        invoked,
+        consumed,
+        type_mismatch,
+        skipped
+    };
+
+    std::atomic<callback_id> next_id_{0};
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const CallbackList>> callbacks_map_;    // copied on write, shared by snapshots
+    std::unordered_map<std::string, TopicFeaturesPtr> topic_features_;
+    std::shared_ptr<EventJournal> journal_;
+    std::unique_ptr<detail::TimerQueue> timers_;
+    std::unique_ptr<HeavyHitterTracker> hot_topics_owner_;
+    std::atomic<HeavyHitterTracker*> hot_topics_{nullptr};
+    std::unique_ptr<FastPathTable> fast_path_owner_;
+    std::atomic<FastPathTable*> fast_path_{nullptr};
+    std::atomic<std::uint64_t> registry_version_{1};    // bumped under the unique lock on every change
+    detail::TopicFilter topic_filter_;                  // names in callbacks_map_, topic_features_ and link_interest_
+    detail::PatternTable<std::shared_ptr<RateLimiter>> rate_limits_;
+    detail::PatternTable<std::shared_ptr<detail::TopicClassState>> topic_classes_;
+    std::unordered_map<std::string, std::shared_ptr<detail::TopicClassState>> class_states_;   // by class name
+    std::unique_ptr<detail::WorkerPool> async_owner_;
+    std::atomic<detail::WorkerPool*> async_{nullptr};
+    std::shared_ptr<detail::TopicClassState> default_class_;  // set before async_ is published
+    detail::PatternTable<std::shared_ptr<detail::TenantState>> topic_tenants_;
+    std::unordered_map<std::string, std::shared_ptr<detail::TenantState>> tenant_states_;     // by tenant name
+    std::shared_ptr<detail::TenantState> default_tenant_;     // set before async_ is published
+    LinkEnds links_;                                            // outbound directions of attached links
+    std::unordered_map<std::string, std::shared_ptr<const LinkEnds>> link_interest_;  // topic -> links wanting it
+    bool closing_{false};
+    std::atomic<bool> verbose_logging_{false};
+    mutable std::mutex log_mutex_;
+    LogHandler log_handler_;
+
+public:
+    explicit EventBus(bool verbose_logging = false) : verbose_logging_(verbose_logging) {}
+
+    EventBus(bool verbose_logging, LogHandler log_handler)
+        : verbose_logging_(verbose_logging), log_handler_(std::move(log_handler))
+    {
+    }
+
+    ~EventBus() noexcept
+    {
+        try {
+            close();
+        }
+        catch (...) {
+        }
+    }
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+    EventBus(EventBus&&) = delete;
+    EventBus& operator=(EventBus&&) = delete;
 
     void setVerboseLogging(bool verbose) { verbose_logging_.store(verbose, std::memory_order_relaxed); }
 
-    void setLogHandler(LogHandler handler)
+    void setLogHandler(LogHandler handler)
+    {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        log_handler_ = std::move(handler);
+    }
+
+    /// Sets the journal that records events of journaled topics; nullptr detaches it.
+    void setJournal(std::shared_ptr<EventJournal> journal)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        journal_ = std::move(journal);
+        registry_changed();
+    }
+
+    [[nodiscard]] std::shared_ptr<EventJournal> getJournal() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return journal_;
+    }
+
+    void setTopicJournaled(const std::string& eventName, bool journaled = true)
+    {
+        update_topic_features(eventName, [journaled](TopicFeatures& features) {
+            features.journaled = journaled;
+        });
+    }
+
+    /**
+     * Durable topics are journaled and `publish()` returns only after the event
+     * is fsynced. Concurrent durable publishes share one fsync (group commit);
+     * tune the tradeoff with JournalOptions::group_commit.
+     */
+    void setTopicDurable(const std::string& eventName, bool durable = true)
+    {
+        update_topic_features(eventName, [durable](TopicFeatures& features) {
+            features.durable = durable;
+            if (durable) {
+                features.journaled = true;
+            }
+        });
+    }
+
+    /**
+     * Turns the topic into a log topic: every publish is appended to a
+     * segmented log that consumers read at their own pace through cursors.
+     * Regular subscribers of the topic are still invoked. Returns the existing
+     * log if the topic already has one.
+     */
+    std::shared_ptr<EventLog> createLogTopic(const std::string& eventName, LogTopicOptions options = {})
+    {
+        if (auto existing = getLogTopic(eventName)) {
+            return existing;
+        }
+
+        auto log = std::make_shared<EventLog>(eventName, std::move(options));
+        std::shared_ptr<EventLog> installed;
+        update_topic_features(eventName, [&log, &installed](TopicFeatures& features) {
+            if (!features.log) {
+                features.log = log;
+            }
+            installed = features.log;
+        });
+        return installed;
+    }
+
+    [[nodiscard]] std::shared_ptr<EventLog> getLogTopic(const std::string& eventName) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = topic_features_.find(eventName);
+        return it != topic_features_.end() ? it->second->log : nullptr;
+    }
+
+    template <typename... Args>
+    [[nodiscard]] std::optional<LogCursor<Args...>> openCursor(const std::string& eventName,
+                                                               LogStart start = LogStart::latest)
+    {
+        auto log = getLogTopic(eventName);
+        if (!log) {
+            return std::nullopt;
+        }
+        return log->open_cursor<Args...>(start);
+    }
+
+    /**
+     * Makes the topic a state topic: the latest event per key (its first
+     * argument) is retained in a compacted store. With a snapshot path the
+     * store is restored from it here, saved every `snapshot_interval` and on
+     * close(). Returns the existing store if the topic already has one.
+     */
+    std::shared_ptr<CompactedStore> enableCompaction(const std::string& eventName, CompactionOptions options = {})
+    {
+        if (auto existing = getCompactedStore(eventName)) {
+            return existing;
+        }
+
+        auto store = std::make_shared<CompactedStore>(eventName, options);
+        if (options.restore && !options.snapshot_path.empty() && store->load(options.snapshot_path)) {
+            std::ostringstream message;
+            message << "Restored " << store->size() << " retained values of '" << eventName
+                    << "' from " << options.snapshot_path;
+            log(LogLevel::Debug, message.str());
+        }
+
+        std::shared_ptr<CompactedStore> installed;
+        update_topic_features(eventName, [&store, &installed](TopicFeatures& features) {
+            if (!features.compacted) {
+                features.compacted = store;
+            }
+            installed = features.compacted;
+        });
+
+        if (installed == store && !options.snapshot_path.empty() && options.snapshot_interval.count() > 0) {
+            std::weak_ptr<CompactedStore> weak_store = store;
+            schedule_every(options.snapshot_interval, [this, weak_store]() {
+                if (auto locked_store = weak_store.lock()) {
+                    save_snapshot(*locked_store);
+                }
+            });
+        }
+        return installed;
+    }
+
+#if EVENTBUS_HAS_POSIX
+    /**
+     * Forwards every publish of the topic into a shared-memory ring so other
+     * processes on the host can consume it through SharedRingCursor; nullptr
+     * stops forwarding.
+     */
+    void setTopicSharedRing(const std::string& eventName, std::shared_ptr<SharedRing> ring)
+    {
+        update_topic_features(eventName, [&ring](TopicFeatures& features) {
+            features.shared_ring = std::move(ring);
+        });
+    }
+#endif
+
+    /**
+     * Limits how fast events are published to @p pattern: an exact topic name,
+     * or a prefix ending in '*' ("telemetry.*") whose matching topics share
+     * one bucket. An exact limit takes precedence over prefixes, and the
+     * longest matching prefix over shorter ones. Events over the limit are
+     * handled by RateLimit::policy and counted in PublishResult::throttled or
+     * PublishResult::delayed. Replaces any previous limit for the pattern.
+     */
+    void setRateLimit(const std::string& pattern, RateLimit limit)
+    {
+        auto limiter = std::make_shared<RateLimiter>(limit);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        rate_limits_.set(pattern, std::move(limiter));
+        registry_changed();
+    }
+
+    bool clearRateLimit(const std::string& pattern)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (!rate_limits_.erase(pattern)) {
+            return false;
+        }
+        registry_changed();
+        return true;
+    }
+
+    [[nodiscard]] std::optional<RateLimitStats> getRateLimitStats(const std::string& pattern) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const auto* limiter = rate_limits_.find(pattern);
+        if (limiter == nullptr) {
+            return std::nullopt;
+        }
+        return (*limiter)->stats();
+    }
+
+    [[nodiscard]] std::shared_ptr<CompactedStore> getCompactedStore(const std::string& eventName) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = topic_features_.find(eventName);
+        return it != topic_features_.end() ? it->second->compacted : nullptr;
+    }
+
+    /**
+     * Subscribes and first delivers the retained value of every key, so the
+     * subscriber starts from current state instead of the event history.
+     * Publishes racing with the replay are delivered after it. Behaves like
+     * subscribe() on topics without compaction.
+     */
+    template <typename Callback>
+    callback_id subscribeWithState(const std::string& eventName, Callback&& callback)
+    {
+        using Signature = typename detail::function_traits<std::decay_t<Callback>>::signature;
+        std::function<Signature> func(std::forward<Callback>(callback));
+
+        auto store = getCompactedStore(eventName);
+        if (!store) {
+            return subscribe(eventName, std::move(func));
+        }
+
+        return store->locked([&]() {
+            const callback_id id = subscribe(eventName, func);
+            if (id != 0) {
+                replay_state(eventName, *store, func);
+            }
+            return id;
+        });
+    }
+
+    /**
+     * Writes the topic table (journal, durable, log and compaction settings),
+     * retained values and the journal's synced checkpoint to one file,
+     * atomically. Subscriptions are code and are not part of the snapshot.
+     */
+    bool saveSnapshot(const std::string& path)
+    {
+        std::shared_ptr<EventJournal> journal;
+        std::unordered_map<std::string, TopicFeaturesPtr> features;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            journal = journal_;
+            features = topic_features_;
+        }
+
+        detail::BusSnapshot snapshot;
+        if (journal) {
+            (void)journal->sync();
+            detail::BusSnapshotJournal entry{journal->path(), journal->options()};
+            entry.options.resume_from = journal->checkpoint();
+            snapshot.journal = std::move(entry);
+        }
+
+        snapshot.topics.reserve(features.size());
+        for (const auto& [name, topic_features] : features) {
+            detail::BusSnapshotTopic topic;
+            topic.name = name;
+            topic.journaled = topic_features->journaled;
+            topic.durable = topic_features->durable;
+            if (topic_features->log) {
+                topic.log = topic_features->log->options();
+            }
+            if (const auto& store = topic_features->compacted) {
+                topic.compaction = store->options();
+                store->for_each([&topic](const std::string& key, const CompactedStore::Entry& entry) {
+                    topic.retained.emplace_back(key, entry);
+                });
+            }
+            snapshot.topics.push_back(std::move(topic));
+        }
+
+        if (detail::write_bus_snapshot(path, snapshot)) {
+            return true;
+        }
+        std::ostringstream message;
+        message << "Failed to write bus snapshot " << path;
+        log(LogLevel::Error, message.str());
+        return false;
+    }
+
+    /**
+     * Restores a snapshot written by saveSnapshot(): the file is mmapped and
+     * decoded in one pass, the journal reopens from its checkpoint without
+     * rescanning, and state topics get their retained values back. Returns
+     * false, changing nothing, if the file is missing or malformed.
+     */
+    bool loadSnapshot(const std::string& path)
+    {
+        detail::BusSnapshot snapshot;
+        if (!detail::read_bus_snapshot(path, snapshot)) {
+            std::ostringstream message;
+            message << "Bus snapshot " << path << " is missing or malformed";
+            log(LogLevel::Warning, message.str());
+            return false;
+        }
+
+        if (snapshot.journal && !getJournal()) {
+            setJournal(std::make_shared<EventJournal>(snapshot.journal->path, snapshot.journal->options));
+        }
+
+        for (auto& topic : snapshot.topics) {
+            update_topic_features(topic.name, [&topic](TopicFeatures& features) {
+                features.journaled = topic.journaled;
+                features.durable = topic.durable;
+            });
+            if (topic.log) {
+                (void)createLogTopic(topic.name, std::move(*topic.log));
+            }
+            if (topic.compaction) {
+                auto store = enableCompaction(topic.name, std::move(*topic.compaction));
+                store->assign(std::move(topic.retained));
+            }
+        }
+        return true;
+    }
+
+    template <typename Callback>
+    callback_id subscribe(const std::string& eventName,
+                          Callback&& callback)
+    {
+        return subscribe(eventName, std::forward<Callback>(callback), 0);
+    }
+
+    /**
+     * @brief Subscribes with a dispatch priority
+     *
+     * Higher priorities are invoked first; equal priorities keep subscription
+     * order. A callback returning true or Dispatch::consume stops the publish
+     * before the remaining subscribers, so command-style topics can let the
+     * first capable handler win.
+     */
+    template <typename Callback>
+    callback_id subscribe(const std::string& eventName,
+                          Callback&& callback,
+                          int priority)
+    {
+        return subscribe_entry(eventName, std::forward<Callback>(callback), priority, nullptr);
+    }
+
+    /**
+     * @brief Subscribes a callback that receives events in batches
+     *
+     * The callback takes a BatchView<T>, where T is the event's argument type
+     * or a std::tuple of its argument types, or a const ColumnBatch<T>& to
+     * have a registered struct stored column by column. Publishes are
+     * buffered per subscriber and delivered when @p options.max_events are
+     * buffered (on the publishing thread) or @p options.max_delay after the
+     * first of them (on the bus timer thread), whichever comes first.
+     * Unsubscribing or closing the bus delivers what is still buffered.
+     */
+    template <typename Callback>
+    callback_id subscribeBatched(const std::string& eventName, Callback&& callback, BatchOptions options = {})
+    {
+        using Traits = detail::function_traits<std::decay_t<Callback>>;
+        static_assert(Traits::arity == 1, "Batched callbacks take a single BatchView<T> or ColumnBatch<T> parameter");
+        using View = std::decay_t<std::tuple_element_t<0, typename Traits::args_tuple>>;
+        if constexpr (detail::is_column_batch_v<View>) {
+            return subscribe_batches<View>(eventName, std::forward<Callback>(callback), options);
+        } else {
+            static_assert(detail::batch_view_traits<View>::value,
+                          "Batched callbacks take a single BatchView<T> or ColumnBatch<T> parameter");
+            using Element = typename detail::batch_view_traits<View>::element_type;
+            return subscribe_batches<std::vector<Element>>(eventName, row_delivery<Element>(std::forward<Callback>(callback)),
+                                                           options);
+        }
+    }
+
+    /**
+     * @brief Batched subscription that only sees events passing @p filter
+     *
+     * The callback takes (BatchView<T> batch, BatchView<std::uint32_t>
+     * selected), or (const ColumnBatch<T>& batch, BatchView<std::uint32_t>
+     * selected) for a columnar batch, where @p selected lists the indices of
+     * the passing events in @p batch. Batches in which nothing passes are not
+     * delivered.
+     */
+    template <typename T, typename Callback>
+    callback_id subscribeBatched(const std::string& eventName, BatchFilter<T> filter, Callback&& callback,
+                                 BatchOptions options = {})
+    {
+        using Traits = detail::function_traits<std::decay_t<Callback>>;
+        static_assert(Traits::arity == 2, "Filtered batch callbacks take a batch and a selection");
+        using Batch = std::decay_t<std::tuple_element_t<0, typename Traits::args_tuple>>;
+        using Buffer = std::conditional_t<detail::is_column_batch_v<Batch>, Batch, std::vector<T>>;
+
+        auto deliver = [filter = std::move(filter), callback = std::forward<Callback>(callback),
+                        scratch = std::vector<std::uint32_t>()](const Buffer& buffer) mutable {
+            // Moved out so a nested delivery (the callback unsubscribing itself) cannot clobber it.
+            std::vector<std::uint32_t> selected = std::move(scratch);
+            if constexpr (detail::is_column_batch_v<Buffer>) {
+                filter.select(buffer, selected);
+                if (!selected.empty()) {
+                    callback(buffer, BatchView<std::uint32_t>(selected.data(), selected.size()));
+                }
+            } else {
+                const BatchView<T> batch(buffer.data(), buffer.size());
+                filter.select(batch, selected);
+                if (!selected.empty()) {
+                    callback(batch, BatchView<std::uint32_t>(selected.data(), selected.size()));
+                }
+            }
+            scratch = std::move(selected);
+        };
+        return subscribe_batches<Buffer>(eventName, std::move(deliver), options);
+    }
+
+    /**
+     * @brief Merges several topics into one consumer in timestamp order
+     *
+     * Topic i must publish a single Events...[i]. @p time_of is called with
+     * each event type and returns its timestamp; @p consumer receives a
+     * std::variant<Events...>. See TopicMerge for the lateness rules.
+     */
+    template <typename... Events, typename TimeOf, typename Consumer>
+    std::shared_ptr<TopicMerge<Events...>> mergeTopics(const std::array<std::string, sizeof...(Events)>& topics,
+                                                       TimeOf&& time_of, Consumer&& consumer,
+                                                       MergeOptions options = {})
+    {
+        using Merge = TopicMerge<Events...>;
+        auto timestamp = [time_of = std::forward<TimeOf>(time_of)](const typename Merge::Event& event) {
+            return std::visit([&time_of](const auto& value) { return static_cast<std::int64_t>(time_of(value)); },
+                              event);
+        };
+        auto merge = std::make_shared<Merge>(options, std::move(timestamp), std::forward<Consumer>(consumer));
+        subscribe_merge_inputs(merge, topics, std::index_sequence_for<Events...>{});
+        return merge;
+    }
+
+    /**
+     * @brief Links @p child below this bus
+     *
+     * Each side advertises the topics it wants: its own subscriptions plus
+     * what its other links want. An event published on either bus crosses
+     * the link only when the far side wants its topic, and is then published
+     * there (and onward, but never back). Links must form a tree. Events are
+     * batched per direction as set by @p options. Returns null when either
+     * bus is closed; throws std::invalid_argument for a self or duplicate
+     * link, or one that would close a cycle through existing links.
+     */
+    std::shared_ptr<BusLink> linkChild(EventBus& child, LinkOptions options = {});
+
+private:
+    template <typename... Events, std::size_t... Inputs>
+    void subscribe_merge_inputs(const std::shared_ptr<TopicMerge<Events...>>& merge,
+                                const std::array<std::string, sizeof...(Events)>& topics,
+                                std::index_sequence<Inputs...>)
+    {
+        using Event = typename TopicMerge<Events...>::Event;
+        (merge->subscriptions_.push_back(subscribe_entry(topics[Inputs], [merge](const Events& value) {
+            merge->push(Inputs, Event(std::in_place_index<Inputs>, value));
+        }, 0, merge)), ...);
+    }
+
+    template <typename Element, typename Callback>
+    static auto row_delivery(Callback&& callback)
+    {
+        return [callback = std::forward<Callback>(callback)](const std::vector<Element>& rows) mutable {
+            callback(BatchView<Element>(rows.data(), rows.size()));
+        };
+    }
+
+    template <typename Buffer, typename Deliver>
+    callback_id subscribe_batches(const std::string& eventName, Deliver&& deliver, const BatchOptions& options)
+    {
+        using Element = typename Buffer::value_type;
+        auto batcher = std::make_shared<detail::MicroBatcher<Buffer>>(
+            options, std::function<void(const Buffer&)>(std::forward<Deliver>(deliver)));
+        std::weak_ptr<detail::MicroBatcher<Buffer>> weak_batcher = batcher;
+        batcher->set_arm([this, weak_batcher, delay = batcher->options().max_delay](std::uint64_t generation) {
+            schedule_once(delay, [weak_batcher, generation]() {
+                if (auto locked_batcher = weak_batcher.lock()) {
+                    locked_batcher->expire(generation);
+                }
+            });
+        });
+        return subscribe_entry(eventName, batch_callback(batcher, static_cast<Element*>(nullptr)), 0, batcher);
+    }
+
+    template <typename Batcher, typename Element>
+    static auto batch_callback(const std::shared_ptr<Batcher>& batcher, Element*)
+    {
+        return [batcher](const Element& value) { batcher->add(value); };
+    }
+
+    template <typename Batcher, typename... Elements>
+    static auto batch_callback(const std::shared_ptr<Batcher>& batcher, std::tuple<Elements...>*)
+    {
+        return [batcher](const Elements&... values) { batcher->add(values...); };
+    }
+
+    template <typename Callback>
+    callback_id subscribe_entry(const std::string& eventName, Callback&& callback, int priority,
+                                std::shared_ptr<detail::BatchSink> batch)
+    {
+        using CallbackType = std::decay_t<Callback>;
+        using Traits = detail::function_traits<CallbackType>;
+        using Signature = typename Traits::signature;
+        static_assert(detail::is_callback_result_v<typename Traits::return_type>,
+                      "EventBus callbacks must return void, bool or Dispatch");
+
+        callback_id id = 0;
+        const bool verbose = verbose_logging_.load(std::memory_order_relaxed);
+        bool new_topic = false;
+
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            if (closing_) {
+                return 0;
+            }
+
+            id = next_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+            std::function<Signature> func(std::forward<Callback>(callback));
+            auto entry = std::make_shared<CallbackEntry>(create_wrapper_from_function(id, std::move(func)));
+            entry->priority = priority;
+            entry->batch = std::move(batch);
+            if (entry->batch && !timers_) {
+                timers_ = std::make_unique<detail::TimerQueue>();
+            }
+
+            auto& current = callbacks_map_[eventName];
+            if (!current) {
+                topic_filter_.add(std::hash<std::string>{}(eventName));
+                new_topic = !links_.empty();
+            }
+            auto callbacks = current ? std::make_shared<CallbackList>(*current) : std::make_shared<CallbackList>();
+            auto position = std::find_if(callbacks->begin(), callbacks->end(), [priority](const CallbackEntryPtr& other) {
+                return other->priority < priority;
+            });
+            callbacks->insert(position, std::move(entry));
+            current = std::move(callbacks);
+            topic_changed(eventName);
+        }
+        if (new_topic) {
+            advertise_interest();
+        }
+
+        if (verbose) {
+            std::ostringstream message;
+            message
+                << "Subscribe event: " << eventName
+                << "\n             ID: " << id
+                << "\n          Types: " << typeid(CallbackType).name()
+                << "\n      Signature: " << typeid(Signature).name()
+                << "\n";
+            log(LogLevel::Debug, message.str());
+        }
+
+        return id;
+    }
+
+public:
+    [[nodiscard]] bool unsubscribe(const std::string& eventName, callback_id id)
+    {
+        CallbackEntryPtr removed_entry;
+        bool topic_gone = false;
+
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+
+            auto it = callbacks_map_.find(eventName);
+            if (it == callbacks_map_.end()) {
+                return false;
+            }
+
+            const CallbackList& current = *it->second;
+            auto callback_it = std::find_if(current.begin(), current.end(),
+                                            [id](const CallbackEntryPtr& entry) {
+                return entry->callback->get_id() == id;
+            });
+
+            if (callback_it == current.end()) {
+                return false;
+            }
+
+            removed_entry = *callback_it;
+            deactivate_entry(*removed_entry);
+            if (current.size() == 1) {
+                callbacks_map_.erase(it);
+                topic_filter_.remove(std::hash<std::string>{}(eventName));
+                topic_gone = !links_.empty();
+            } else {
+                auto callbacks = std::make_shared<CallbackList>(current);
+                callbacks->erase(callbacks->begin() + (callback_it - current.begin()));
+                it->second = std::move(callbacks);
+            }
+            topic_changed(eventName);
+        }
+
+        wait_for_idle(*removed_entry);
+        close_batch(*removed_entry);
+        if (topic_gone) {
+            advertise_interest();
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool isEventRegistered(const std::string& eventName) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = callbacks_map_.find(eventName);
+        return it != callbacks_map_.end() && !it->second->empty();
+    }
+
+    template <typename... Args>
+    PublishResult publish(const std::string& eventName, Args&&... args)
+    {
+        TopicSnapshot snapshot = resolve_topic(eventName);
+
+        PublishResult result{};
+        if (snapshot.limiter && !admit(*snapshot.limiter, result)) {
+            return result;
+        }
+
+        deliver(eventName, snapshot, result, std::forward<Args>(args)...);
+        return result;
+    }
+
+    /**
+     * @brief Starts the worker pool behind publishAsync()
+     *
+     * Calling it again keeps the running pool and ignores @p options.
+     */
+    void enableAsync(AsyncOptions options = {})
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (async_owner_ || closing_) {
+            return;
+        }
+        default_class_ = std::make_shared<detail::TopicClassState>("default", options.default_priority);
+        default_tenant_ = std::make_shared<detail::TenantState>("default", 1);
+        async_owner_ = std::make_unique<detail::WorkerPool>(options);
+        async_owner_->set_priorities(class_priorities());
+        async_.store(async_owner_.get(), std::memory_order_release);
+    }
+
+    /**
+     * Assigns topics matching @p pattern (exact name, or prefix ending in '*')
+     * to a shedding class. Under overload publishAsync() sheds the classes
+     * with the lowest priority first. Classes are identified by name; setting
+     * an existing class again updates its priority for every pattern.
+     */
+    void setTopicClass(const std::string& pattern, const TopicClass& topic_class)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto& state = class_states_[topic_class.name];
+        if (!state) {
+            state = std::make_shared<detail::TopicClassState>(topic_class.name, topic_class.priority);
+        }
+        state->priority.store(topic_class.priority, std::memory_order_relaxed);
+        topic_classes_.set(pattern, state);
+        if (async_owner_) {
+            async_owner_->set_priorities(class_priorities());
+        }
+        registry_changed();
+    }
+
+    bool clearTopicClass(const std::string& pattern)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (!topic_classes_.erase(pattern)) {
+            return false;
+        }
+        if (async_owner_) {
+            async_owner_->set_priorities(class_priorities());
+        }
+        registry_changed();
+        return true;
+    }
+
+    /**
+     * Assigns topics matching @p pattern to a tenant for fair scheduling.
+     * Each tenant's events share one queue, and the workers split their time
+     * between queues in proportion to the weights. Topics without a tenant
+     * get a queue each at weight 1 and are reported as tenant "default".
+     */
+    void setTopicTenant(const std::string& pattern, const Tenant& tenant)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto& state = tenant_states_[tenant.name];
+        if (!state) {
+            state = std::make_shared<detail::TenantState>(tenant.name, tenant.weight);
+        }
+        state->weight.store(std::max<std::uint32_t>(tenant.weight, 1), std::memory_order_relaxed);
+        topic_tenants_.set(pattern, state);
+        registry_changed();
+    }
+
+    bool clearTopicTenant(const std::string& pattern)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (!topic_tenants_.erase(pattern)) {
+            return false;
+        }
+        registry_changed();
+        return true;
+    }
+
+    /**
+     * @brief Queues the event for delivery on the worker pool
+     *
+     * Arguments are copied (character pointers into std::string). Returns
+     * false when the event is shed by overload control, throttled by a rate
+     * limit, or enableAsync() was not called. Subscribers run on worker
+     * threads exactly as publish() would run them.
+     */
+    template <typename... Args>
+    bool publishAsync(const std::string& eventName, Args&&... args)
+    {
+        return enqueue_async(eventName, std::make_tuple(detail::async_value_t<Args>(std::forward<Args>(args))...),
+                             [](const PublishResult&) {});
+    }
+
+    /**
+     * @brief Scheduler whose work runs on the publishAsync() workers
+     *
+     * schedule() completes on a worker thread, or with set_stopped() when the
+     * work is shed or enableAsync() was not called.
+     */
+    [[nodiscard]] AsyncScheduler scheduler() noexcept;
+
+    /**
+     * @brief publishAsync() as a sender
+     *
+     * Starting it queues the event; it completes on the worker thread with the
+     * PublishResult once subscribers have run, or with set_stopped() when the
+     * event is shed, throttled, or enableAsync() was not called.
+     */
+    template <typename... Args>
+    [[nodiscard]] PublishSender<detail::async_value_t<Args>...> publishSender(const std::string& eventName,
+                                                                              Args&&... args);
+
+    /**
+     * @brief Sender of the next event on @p eventName
+     *
+     * Starting it subscribes a one-shot callback; it completes with copies of
+     * the arguments on the publishing thread, or with set_stopped() when the
+     * bus is closed, before or while it waits, or the topic's subscriptions
+     * are removed (unsubscribe_all(), clear()).
+     */
+    template <typename... Args>
+    [[nodiscard]] NextEventSender<Args...> nextEvent(const std::string& eventName);
+
+    /**
+     * @brief Request/reply as a sender
+     *
+     * Starting it subscribes to @p replyTopic, then publishes @p args on
+     * @p requestTopic; it completes with the first reply. Completes with
+     * set_stopped() when no subscriber took the request, or when the bus is
+     * closed or the reply subscription removed before a reply arrives.
+     */
+    template <typename... Replies, typename... Args>
+    [[nodiscard]] RequestSender<std::tuple<Replies...>, std::tuple<detail::async_value_t<Args>...>> request(
+        const std::string& requestTopic, const std::string& replyTopic, Args&&... args);
+
+    [[nodiscard]] AsyncStats getAsyncStats() const
+    {
+        AsyncStats stats{};
+        detail::WorkerPool* const pool = async_.load(std::memory_order_acquire);
+        if (pool != nullptr) {
+            pool->fill_stats(stats);
+        }
+
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto add_class = [&stats](const detail::TopicClassState& state) {
+            stats.classes.push_back(TopicClassStats{state.name, state.priority.load(std::memory_order_relaxed),
+                                                    state.admitted.load(std::memory_order_relaxed),
+                                                    state.executed.load(std::memory_order_relaxed),
+                                                    state.shed.load(std::memory_order_relaxed)});
+        };
+        if (default_class_) {
+            add_class(*default_class_);
+        }
+        for (const auto& pair : class_states_) {
+            add_class(*pair.second);
+        }
+
+        auto add_tenant = [&stats](const detail::TenantState& state) {
+            stats.tenants.push_back(TenantStats{state.name, state.weight.load(std::memory_order_relaxed),
+                                                static_cast<std::size_t>(state.queued.load(std::memory_order_relaxed)),
+                                                state.executed.load(std::memory_order_relaxed),
+                                                std::chrono::nanoseconds(state.cpu_ns.load(std::memory_order_relaxed))});
+        };
+        if (default_tenant_) {
+            add_tenant(*default_tenant_);
+        }
+        for (const auto& pair : tenant_states_) {
+            add_tenant(*pair.second);
+        }
+        return stats;
+    }
+
+private:
+    friend struct detail::SenderAccess;
+    friend class BusLink;
+
+    /// Hands a copy of the event to every link that wants it, except the one it arrived over.
+    template <typename... Args>
+    void forward_event(const std::string& eventName, const LinkEnds& ends, const detail::LinkEnd* skip,
+                       PublishResult& result, const Args&... args)
+    {
+        for (const auto& end : ends) {
+            if (end.get() == skip || !end->enter()) {
+                continue;
+            }
+            try {
+                std::function<void()> event = [to = end->to, back = end->reverse, name = eventName,
+                                               payload = std::make_tuple(detail::async_value_t<Args>(args)...)]() {
+                    std::apply([to, back, &name](const auto&... values) {
+                        detail::LinkSkipGuard guard(back);
+                        (void)to->publish(name, values...);
+                    }, payload);
+                };
+                end->forwarded.fetch_add(1, std::memory_order_relaxed);
+                ++result.forwarded;
+                if (end->batcher) {
+                    end->batcher->add(std::move(event));
+                } else {
+                    end->batches.fetch_add(1, std::memory_order_relaxed);
+                    event();
+                }
+            }
+            catch (const std::exception& e) {
+                std::ostringstream message;
+                message << "Forwarding '" << eventName << "' failed: " << e.what();
+                log(LogLevel::Error, message.str());
+            }
+            end->leave();
+        }
+    }
+
+    /// Registers the outbound direction of a new link; false once the bus is closing.
+    bool attach_link(const std::shared_ptr<detail::LinkEnd>& end)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (closing_) {
+            return false;
+        }
+        if (end->batcher) {
+            if (!timers_) {
+                timers_ = std::make_unique<detail::TimerQueue>();
+            }
+            std::weak_ptr<detail::LinkEnd> weak_end = end;
+            end->batcher->set_arm([this, weak_end, delay = end->batcher->options().max_delay](std::uint64_t generation) {
+                schedule_once(delay, [weak_end, generation]() {
+                    auto locked_end = weak_end.lock();
+                    if (locked_end && locked_end->enter()) {
+                        locked_end->batcher->expire(generation);
+                        locked_end->leave();
+                    }
+                });
+            });
+        }
+        end->attached = true;
+        links_.push_back(end);
+        return true;
+    }
+
+    void detach_link(const std::shared_ptr<detail::LinkEnd>& end)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (!end->attached) {
+            return;
+        }
+        end->attached = false;
+        links_.erase(std::remove(links_.begin(), links_.end(), end), links_.end());
+        detail::InterestDelta delta;
+        delta.removed.assign(end->interest.begin(), end->interest.end());
+        update_link_interest(*end, delta);
+        registry_changed();
+    }
+
+    /// Called with the unique lock held; updates the topic -> links index.
+    void update_link_interest(detail::LinkEnd& end, const detail::InterestDelta& delta)
+    {
+        for (const auto& topic : delta.removed) {
+            if (end.interest.erase(topic) == 0) {
+                continue;
+            }
+            ++end.interest_updates;
+            auto it = link_interest_.find(topic);
+            if (it == link_interest_.end()) {
+                continue;
+            }
+            auto ends = std::make_shared<LinkEnds>();
+            for (const auto& other : *it->second) {
+                if (other.get() != &end) {
+                    ends->push_back(other);
+                }
+            }
+            if (ends->empty()) {
+                link_interest_.erase(it);
+                topic_filter_.remove(std::hash<std::string>{}(topic));
+            } else {
+                it->second = std::move(ends);
+            }
+        }
+        for (const auto& topic : delta.added) {
+            if (!end.interest.insert(topic).second) {
+                continue;
+            }
+            ++end.interest_updates;
+            auto& slot = link_interest_[topic];
+            if (!slot) {
+                topic_filter_.add(std::hash<std::string>{}(topic));
+            }
+            auto ends = slot ? std::make_shared<LinkEnds>(*slot) : std::make_shared<LinkEnds>();
+            for (const auto& candidate : links_) {
+                if (candidate.get() == &end) {
+                    ends->push_back(candidate);
+                    break;
+                }
+            }
+            slot = std::move(ends);
+        }
+    }
+
+    /**
+     * Applies advertisement @p sequence from the far bus of @p end. Senders
+     * do not hold a lock while delivering, so a delta can overtake the one
+     * before it; it is then held back until the gap is filled.
+     */
+    void receive_interest(detail::LinkEnd& end, std::uint64_t sequence, detail::InterestDelta delta)
+    {
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            if (!end.attached) {
+                return;
+            }
+            if (sequence != end.applied_seq + 1) {
+                end.early.emplace(sequence, std::move(delta));
+                return;
+            }
+            update_link_interest(end, delta);
+            end.applied_seq = sequence;
+            for (auto it = end.early.begin(); it != end.early.end() && it->first == end.applied_seq + 1;
+                 it = end.early.erase(it)) {
+                update_link_interest(end, it->second);
+                end.applied_seq = it->first;
+            }
+            registry_changed();
+        }
+        advertise_interest();
+    }
+
+    /**
+     * Tells every linked bus what this bus wants from it: topics with local
+     * subscribers plus what its other links want. Only the topics added or
+     * removed since the last advertisement over a direction are sent. Called
+     * after the topic set or a link's interest changes, never with the
+     * registry lock held.
+     */
+    void advertise_interest()
+    {
+        LinkEnds ends;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            ends = links_;
+        }
+        for (const auto& out : ends) {
+            if (!out->advertising.load(std::memory_order_acquire)) {
+                continue;
+            }
+            detail::InterestDelta delta;
+            std::uint64_t sequence = 0;
+            {
+                std::lock_guard<std::mutex> advert(out->advert_mutex);
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                if (!out->attached) {
+                    continue;
+                }
+                std::unordered_set<std::string> topics;
+                for (const auto& pair : callbacks_map_) {
+                    if (!pair.second->empty()) {
+                        topics.insert(pair.first);
+                    }
+                }
+                for (const auto& other : links_) {
+                    if (other != out) {
+                        topics.insert(other->interest.begin(), other->interest.end());
+                    }
+                }
+                for (const auto& topic : topics) {
+                    if (out->advertised.count(topic) == 0) {
+                        delta.added.push_back(topic);
+                    }
+                }
+                for (const auto& topic : out->advertised) {
+                    if (topics.count(topic) == 0) {
+                        delta.removed.push_back(topic);
+                    }
+                }
+                if (delta.added.empty() && delta.removed.empty()) {
+                    continue;
+                }
+                out->advertised = std::move(topics);
+                sequence = ++out->advert_seq;
+            }
+            if (out->enter()) {
+                out->to->receive_interest(*out->reverse, sequence, std::move(delta));
+                out->leave();
+            }
+        }
+    }
+
+    [[nodiscard]] LinkStats link_stats(const detail::LinkEnd& end) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return LinkStats{end.interest.size(), end.interest_updates,
+                         end.forwarded.load(std::memory_order_relaxed), end.batches.load(std::memory_order_relaxed)};
+    }
+
+    void unlink_all();
+
+    /// Queues delivery of @p payload on the workers; @p done receives the result, @p on_shed runs if it is dropped.
+    template <typename Payload, typename Done>
+    bool enqueue_async(const std::string& eventName, Payload&& payload, Done&& done,
+                       std::function<void()> on_shed = {})
+    {
+        detail::WorkerPool* const pool = async_.load(std::memory_order_acquire);
+        if (pool == nullptr) {
+            std::ostringstream message;
+            message << "publishAsync('" << eventName << "') called before enableAsync()";
+            log(LogLevel::Error, message.str());
+            return false;
+        }
+
+        TopicSnapshot snapshot = resolve_topic(eventName);
+        PublishResult limited{};
+        if (snapshot.limiter && !admit(*snapshot.limiter, limited)) {
+            return false;
+        }
+
+        auto topic_class = snapshot.topic_class ? std::move(snapshot.topic_class) : default_class_;
+        auto tenant = snapshot.tenant ? std::move(snapshot.tenant) : default_tenant_;
+        const std::string flow_key = tenant != default_tenant_ ? "tenant:" + tenant->name : "topic:" + eventName;
+        return pool->submit(topic_class, tenant, flow_key, [this, name = eventName,
+                                                            payload = std::forward<Payload>(payload),
+                                                            done = std::forward<Done>(done)]() {
+            std::apply([this, &name, &done](const auto&... values) {
+                TopicSnapshot current = resolve_topic(name);
+                PublishResult result{};
+                deliver(name, current, result, values...);
+                done(result);
+            }, payload);
+        }, std::move(on_shed));
+    }
+
+    /// Queues @p task on the workers under the default class and tenant.
+    bool enqueue_task(std::function<void()> task, std::function<void()> on_shed)
+    {
+        detail::WorkerPool* const pool = async_.load(std::memory_order_acquire);
+        if (pool == nullptr) {
+            return false;
+        }
+        return pool->submit(default_class_, default_tenant_, "scheduler", std::move(task), std::move(on_shed));
+    }
+
+    /// Everything publish() does after admission.
+    template <typename... Args>
+    void deliver(const std::string& eventName, TopicSnapshot& snapshot, PublishResult& result, Args&&... args)
+    {
+        const bool verbose = verbose_logging_.load(std::memory_order_relaxed);
+        const detail::LinkEnd* const arrived_from = std::exchange(detail::link_skip(), nullptr);
+        std::uint64_t sequence = 0;
+        if (snapshot.features) {
+            sequence = record_event(eventName, snapshot, result, args...);
+        }
+        if (snapshot.links) {
+            forward_event(eventName, *snapshot.links, arrived_from, result, args...);
+        }
+
+        HeavyHitterTracker* const hot_topics = hot_topics_.load(std::memory_order_acquire);
+        std::chrono::steady_clock::time_point dispatch_start{};
+        if (snapshot.subscriber_count() == 0) {
+            if (verbose) {
+                std::ostringstream message;
+                message << "Event '" << eventName << "' has no callbacks";
+                log(LogLevel::Warning, message.str());
+            }
+        } else {
+            if (hot_topics && snapshot.time_weight != 0) {
+                dispatch_start = std::chrono::steady_clock::now();
+            }
+            publish_to_callbacks(eventName, *snapshot.callbacks, verbose, result, std::forward<Args>(args)...);
+        }
+        if (hot_topics) {
+            track_hot_topic(*hot_topics, eventName, dispatch_start, snapshot.time_weight);
+        }
+
+        // The fsync overlaps with callback dispatch; only the return waits for it.
+        if (sequence != 0 && snapshot.features->durable) {
+            wait_durable(eventName, snapshot, sequence, result);
+        }
+    }
+
+    /// Priorities of classes some pattern still assigns; cleared classes keep their stats but no shedding level.
+    /// Called with the registry lock held.
+    std::vector<int> class_priorities() const
+    {
+        std::vector<int> priorities;
+        topic_classes_.for_each([&priorities](const std::string&, const std::shared_ptr<detail::TopicClassState>& state) {
+            priorities.push_back(state->priority.load(std::memory_order_relaxed));
+        });
+        return priorities;
+    }
+
+public:
+    [[nodiscard]] std::size_t getCallbackCount(const std::string& eventName) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = callbacks_map_.find(eventName);
+        return it != callbacks_map_.end() ? it->second->size() : 0;
+    }
+
+    [[nodiscard]] std::size_t unsubscribe_all(const std::string& eventName)
+    {
+        CallbackList removed_entries;
+        std::size_t count = 0;
+
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+
+            auto it = callbacks_map_.find(eventName);
+            if (it == callbacks_map_.end()) {
+                return 0;
+            }
+
+            removed_entries = *it->second;
+            for (const auto& entry : removed_entries) {
+                deactivate_entry(*entry);
+            }
+            count = removed_entries.size();
+            callbacks_map_.erase(it);
+            topic_filter_.remove(std::hash<std::string>{}(eventName));
+            topic_changed(eventName);
+        }
+
+        wait_for_idle(removed_entries);
+        for (const auto& entry : removed_entries) {
+            close_batch(*entry);
+        }
+        advertise_interest();
+        return count;
+    }
+
+    [[nodiscard]] std::vector<std::string> getAllEventNames() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+
+        std::vector<std::string> event_names;
+        event_names.reserve(callbacks_map_.size());
+
+        for (const auto& pair : callbacks_map_) {
+            if (!pair.second->empty()) {
+                event_names.push_back(pair.first);
+            }
+        }
+
+        return event_names;
+    }
+
+    [[nodiscard]] EventBusStats getStats() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+
+        EventBusStats stats{};
+        stats.total_events = 0;
+        stats.total_callbacks = 0;
+        stats.max_callbacks_per_event = 0;
+
+        for (const auto& pair : callbacks_map_) {
+            if (!pair.second->empty()) {
+                stats.total_events++;
+                std::size_t callback_count = pair.second->size();
+                stats.total_callbacks += callback_count;
+
+                if (callback_count > stats.max_callbacks_per_event) {
+                    stats.max_callbacks_per_event = callback_count;
+                    stats.most_subscribed_event = pair.first;
+                }
+            }
+        }
+
+        return stats;
+    }
+
+    /**
+     * @brief Starts tracking the hottest topics by publish rate and callback time
+     *
+     * Memory is fixed by @p options regardless of the number of topics. Calling
+     * it again returns the existing tracker and ignores @p options.
+     */
+    HeavyHitterTracker& enableHotTopics(HeavyHitterOptions options = {})
+    {
+        HeavyHitterTracker* tracker = nullptr;
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            if (hot_topics_owner_) {
+                return *hot_topics_owner_;
+            }
+            hot_topics_owner_ = std::make_unique<HeavyHitterTracker>(options);
+            tracker = hot_topics_owner_.get();
+            hot_topics_.store(tracker, std::memory_order_release);
+        }
+
+        if (options.decay_interval.count() > 0) {
+            schedule_every(options.decay_interval, [tracker]() { tracker->decay(); });
+        }
+        return *tracker;
+    }
+
+    /// The @p n hottest topics, or empty when enableHotTopics() was not called.
+    [[nodiscard]] std::vector<HotTopic> getHotTopics(std::size_t n,
+                                                     HotTopicOrder order = HotTopicOrder::publishes) const
+    {
+        HeavyHitterTracker* const tracker = hot_topics_.load(std::memory_order_acquire);
+        if (tracker == nullptr) {
+            return {};
+        }
+        tracker->flush();
+        return tracker->top(n, order);
+    }
+
+    /**
+     * @brief Serves the hottest topics from a small direct-mapped slot table
+     *
+     * Every refresh_interval the top @c promote topics from the hot-topic
+     * tracker (enabled on demand) are resolved once and placed in the table;
+     * publish() checks it before the registry and, on a hit, reuses the
+     * resolved subscriber list and topic settings without taking the
+     * registry lock. A subscribe, unsubscribe or setting change for one
+     * topic invalidates only its slot; pattern settings, links and the
+     * journal invalidate all slots. Each re-resolves on its next publish. Calling
+     * it again keeps the existing table and ignores @p options.
+     */
+    void enableFastPath(FastPathOptions options = {})
+    {
+        (void)enableHotTopics();
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            if (fast_path_owner_) {
+                return;
+            }
+            fast_path_owner_ = std::make_unique<FastPathTable>(options);
+            fast_path_.store(fast_path_owner_.get(), std::memory_order_release);
+        }
+
+        if (options.refresh_interval.count() > 0) {
+            schedule_every(options.refresh_interval, [this]() { refreshFastPath(); });
+        }
+    }
+
+    /// Re-ranks hot topics now: promotes the hottest, demotes topics that cooled off.
+    void refreshFastPath()
+    {
+        FastPathTable* const table = fast_path_.load(std::memory_order_acquire);
+        HeavyHitterTracker* const tracker = hot_topics_.load(std::memory_order_acquire);
+        if (table == nullptr || tracker == nullptr) {
+            return;
+        }
+
+        tracker->flush();
+        std::vector<bool> taken(table->options.slots, false);
+        for (const auto& topic : tracker->top(table->options.promote)) {
+            const std::size_t hash = std::hash<std::string>{}(topic.name);
+            const std::size_t index = hash & (table->options.slots - 1);
+            if (taken[index]) {
+                continue;   // a hotter topic owns this slot
+            }
+            taken[index] = true;
+
+            TopicSnapshot snapshot = snapshot_topic(topic.name);
+            FastPathSlot& slot = table->slots[index];
+            std::lock_guard<std::mutex> lock(slot.update_mutex);
+            const PromotedTopic* const current = slot.current.load(std::memory_order_relaxed);
+            if (current == nullptr || current->name != topic.name) {
+                slot.hits.store(0, std::memory_order_relaxed);
+            }
+            replace_promoted(slot, new PromotedTopic{hash, topic.name, std::move(snapshot)});
+        }
+
+        for (std::size_t i = 0; i < table->options.slots; ++i) {
+            if (!taken[i]) {
+                demote(table->slots[i]);
+            }
+        }
+    }
+
+    [[nodiscard]] FastPathStats getFastPathStats() const
+    {
+        FastPathStats stats{};
+        FastPathTable* const table = fast_path_.load(std::memory_order_acquire);
+        if (table == nullptr) {
+            return stats;
+        }
+        stats.slots = table->options.slots;
+        for (std::size_t i = 0; i < table->options.slots; ++i) {
+            const FastPathSlot& slot = table->slots[i];
+            if (slot.current.load(std::memory_order_acquire) != nullptr) {
+                ++stats.promoted;
+                stats.hits += slot.hits.load(std::memory_order_relaxed);
+            }
+        }
+        return stats;
+    }
+
+    template <typename... Args>
+    [[nodiscard]] bool publish_if_min_subscribers(const std::string& eventName, size_t min_subscribers, Args&&... args)
+    {
+        TopicSnapshot snapshot = resolve_topic(eventName);
+        if (snapshot.subscriber_count() == 0 || snapshot.subscriber_count() < min_subscribers) {
+            return false;
+        }
+
+        PublishResult result{};
+        if (snapshot.limiter && !admit(*snapshot.limiter, result)) {
+            return false;
+        }
+
+        deliver(eventName, snapshot, result, std::forward<Args>(args)...);
+        return true;
+    }
+
+    void clear()
+    {
+        CallbackList removed_entries;
+
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            for (const auto& pair : callbacks_map_) {
+                for (const auto& entry : *pair.second) {
+                    deactivate_entry(*entry);
+                    removed_entries.push_back(entry);
+                }
+                topic_filter_.remove(std::hash<std::string>{}(pair.first));
+            }
+            callbacks_map_.clear();
+            registry_changed();
+        }
+
+        wait_for_idle(removed_entries);
+        for (const auto& entry : removed_entries) {
+            close_batch(*entry);
+        }
+        advertise_interest();
+    }
+
+    void close()
+    {
+        // Queued async events are still delivered to the current subscribers.
+        if (detail::WorkerPool* pool = async_.load(std::memory_order_acquire)) {
+            pool->stop();
+        }
+        unlink_all();
+
+        std::unordered_map<std::string, std::shared_ptr<const CallbackList>> removed_callbacks;
+        std::unordered_map<std::string, TopicFeaturesPtr> removed_features;
+        std::unique_ptr<detail::TimerQueue> timers;
+
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            if (closing_ && callbacks_map_.empty() && topic_features_.empty()) {
+                return;
+            }
+
+            closing_ = true;
+            for (const auto& pair : callbacks_map_) {
+                topic_filter_.remove(std::hash<std::string>{}(pair.first));
+            }
+            for (const auto& pair : topic_features_) {
+                topic_filter_.remove(std::hash<std::string>{}(pair.first));
+            }
+            removed_callbacks.swap(callbacks_map_);
+            removed_features.swap(topic_features_);
+            journal_.reset();
+            timers.swap(timers_);
+            registry_changed();
+        }
+
+        timers.reset();
+        if (FastPathTable* table = fast_path_.load(std::memory_order_acquire)) {
+            for (std::size_t i = 0; i < table->options.slots; ++i) {
+                demote(table->slots[i]);
+            }
+        }
+        for (const auto& pair : removed_features) {
+            if (pair.second->compacted) {
+                save_snapshot(*pair.second->compacted);
+            }
+        }
+
+        for (const auto& pair : removed_callbacks) {
+            for (const auto& entry : *pair.second) {
+                deactivate_entry(*entry);
+            }
+        }
+
+        for (const auto& pair : removed_callbacks) {
+            wait_for_idle(*pair.second);
+        }
+        for (const auto& pair : removed_callbacks) {
+            for (const auto& entry : *pair.second) {
+                close_batch(*entry);
+            }
+        }
+    }
+
+private:
+    class InvocationGuard
+    {
+    public:
+        explicit InvocationGuard(CallbackEntry& entry)
+            : entry_(entry)
+        {
+        }
+
+        InvocationGuard(const InvocationGuard&) = delete;
+        InvocationGuard& operator=(const InvocationGuard&) = delete;
+
+        ~InvocationGuard()
+        {
+            end_invocation(entry_);
+        }
+
+    private:
+        CallbackEntry& entry_;
+    };
+
+    TopicSnapshot snapshot_topic(const std::string& eventName) const
+    {
+        TopicSnapshot snapshot;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        snapshot.version = registry_version_.load(std::memory_order_relaxed);
+        if (FastPathTable* const table = fast_path_.load(std::memory_order_acquire)) {
+            snapshot.topic_version = table->slot(std::hash<std::string>{}(eventName)).version.load(std::memory_order_relaxed);
+        }
+        if (closing_) {
+            return snapshot;
+        }
+
+        auto it = callbacks_map_.find(eventName);
+        if (it != callbacks_map_.end()) {
+            snapshot.callbacks = it->second;
+        }
+
+        if (!rate_limits_.empty()) {
+            snapshot.limiter = rate_limits_.match(eventName);
+        }
+        if (!topic_classes_.empty()) {
+            snapshot.topic_class = topic_classes_.match(eventName);
+        }
+        if (!topic_tenants_.empty()) {
+            snapshot.tenant = topic_tenants_.match(eventName);
+        }
+        if (!link_interest_.empty()) {
+            auto links_it = link_interest_.find(eventName);
+            if (links_it != link_interest_.end()) {
+                snapshot.links = links_it->second;
+            }
+        }
+
+        if (!topic_features_.empty()) {
+            auto features_it = topic_features_.find(eventName);
+            if (features_it != topic_features_.end()) {
+                snapshot.features = features_it->second;
+                if (snapshot.features->journaled) {
+                    snapshot.journal = journal_;
+                }
+            }
+        }
+
+        return snapshot;
+    }
+
+    /**
+     * Applies the topic's rate limit; false means the event is dropped.
+     * ThrottlePolicy::delay sleeps here, on the publishing thread (for
+     * publishAsync() too, before the event is queued), for at most max_delay.
+     */
+    static bool admit(RateLimiter& limiter, PublishResult& result)
+    {
+        const auto wait = limiter.acquire();
+        if (!wait) {
+            result.throttled = 1;
+            return false;
+        }
+        if (wait->count() > 0) {
+            result.delayed = 1;
+            std::this_thread::sleep_for(*wait);
+        }
+        return true;
+    }
+
+    /// Called with the unique lock held when settings that can apply to any topic change: patterns, links, the journal.
+    void registry_changed() noexcept
+    {
+        // Prefix patterns apply to topics the filter has never seen.
+        topic_filter_.set_exact(rate_limits_.empty() && topic_classes_.empty() && topic_tenants_.empty());
+        registry_version_.fetch_add(1, std::memory_order_release);
+    }
+
+    /// Called with the unique lock held when one topic's subscribers or settings change.
+    void topic_changed(const std::string& eventName) noexcept
+    {
+        if (FastPathTable* const table = fast_path_.load(std::memory_order_relaxed)) {
+            table->slot(std::hash<std::string>{}(eventName)).version.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    /**
+     * An empty snapshot when the topic filter rules the topic out, then the
+     * fast-path slot when the topic is promoted and its snapshot is current,
+     * otherwise the registry. A promoted topic whose snapshot went stale is
+     * re-resolved into its slot.
+     */
+    TopicSnapshot resolve_topic(const std::string& eventName)
+    {
+        // Read the version first: a filter miss must not be stamped with a version that includes the add.
+        const std::uint64_t version = registry_version_.load(std::memory_order_acquire);
+        const std::size_t hash = std::hash<std::string>{}(eventName);
+        if (!topic_filter_.may_contain(hash)) {
+            TopicSnapshot snapshot;
+            snapshot.version = version;
+            return snapshot;
+        }
+
+        FastPathTable* const table = fast_path_.load(std::memory_order_acquire);
+        if (table == nullptr) {
+            return snapshot_topic(eventName);
+        }
+
+        FastPathSlot& slot = table->slot(hash);
+        bool promoted = false;
+        {
+            FastPathReader reader(slot);
+            const PromotedTopic* const topic = reader.topic();
+            if (topic != nullptr && topic->hash == hash && topic->name == eventName) {
+                if (topic->snapshot.version == version &&
+                    topic->snapshot.topic_version == slot.version.load(std::memory_order_acquire)) {
+                    // Promoted topics are hot by definition; timing one dispatch in
+                    // fast_path_time_sample keeps their callback-time estimate.
+                    TopicSnapshot snapshot = topic->snapshot;
+                    const std::uint64_t hits = slot.hits.fetch_add(1, std::memory_order_relaxed);
+                    snapshot.time_weight = hits % fast_path_time_sample == 0 ? fast_path_time_sample : 0;
+                    return snapshot;
+                }
+                promoted = true;
+            }
+        }
+
+        TopicSnapshot snapshot = snapshot_topic(eventName);
+        if (promoted) {
+            std::lock_guard<std::mutex> lock(slot.update_mutex);
+            const PromotedTopic* const topic = slot.current.load(std::memory_order_relaxed);
+            if (topic != nullptr && topic->name == eventName &&
+                std::tie(topic->snapshot.version, topic->snapshot.topic_version) <
+                    std::tie(snapshot.version, snapshot.topic_version)) {
+                replace_promoted(slot, new PromotedTopic{hash, eventName, snapshot});
+            }
+        }
+        return snapshot;
+    }
+
+    /**
+     * Publishes @p topic (or empties the slot) and frees the previous topic
+     * once no publisher can still be reading it. Called with the slot's
+     * update_mutex held. Readers that sampled the old epoch drain from one
+     * counter while new ones enter the other, so a steady stream of
+     * publishes cannot starve the writer.
+     */
+    static void replace_promoted(FastPathSlot& slot, const PromotedTopic* topic)
+    {
+        const PromotedTopic* const previous = slot.current.exchange(topic, std::memory_order_seq_cst);
+        if (previous == nullptr) {
+            return;
+        }
+        const std::uint32_t epoch = slot.epoch.load(std::memory_order_relaxed);
+        wait_for_readers(slot.readers[(epoch + 1) & 1]);
+        slot.epoch.store(epoch + 1, std::memory_order_seq_cst);
+        wait_for_readers(slot.readers[epoch & 1]);
+        delete previous;
+    }
+
+    static void wait_for_readers(const std::atomic<std::uint32_t>& readers) noexcept
+    {
+        for (std::uint32_t spins = 0; readers.load(std::memory_order_seq_cst) != 0; ++spins) {
+            if (spins < 64) {
+                detail::cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    static void demote(FastPathSlot& slot)
+    {
+        std::lock_guard<std::mutex> lock(slot.update_mutex);
+        replace_promoted(slot, nullptr);
+        slot.hits.store(0, std::memory_order_relaxed);
+    }
+
+    template <typename Update>
+    void update_topic_features(const std::string& eventName, Update&& update)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = topic_features_.find(eventName);
+        auto features = it != topic_features_.end()
+            ? std::make_shared<TopicFeatures>(*it->second)
+            : std::make_shared<TopicFeatures>();
+        update(*features);
+        if (it == topic_features_.end()) {
+            topic_filter_.add(std::hash<std::string>{}(eventName));
+        }
+        topic_features_[eventName] = std::move(features);
+        topic_changed(eventName);
+    }
+
+    /**
+     * Appends the event to the topic's log and journal, as configured. Never
+     * throws; returns the journal sequence or 0 when not journaled.
+     */
+    template <typename... Args>
+    std::uint64_t record_event(const std::string& eventName, TopicSnapshot& snapshot,
+                               PublishResult& result, const Args&... args)
+    {
+        if (snapshot.features->compacted) {
+            compact_event(eventName, snapshot, result, args...);
+        }
+
+        if (snapshot.features->log) {
+            append_to_log(eventName, *snapshot.features->log, result, args...);
+        }
+
+#if EVENTBUS_HAS_POSIX
+        if (snapshot.features->shared_ring) {
+            forward_to_shared_ring(eventName, *snapshot.features->shared_ring, result, args...);
+        }
+#endif
+
+        if (!snapshot.journal) {
+            if (snapshot.features->durable) {
+                std::ostringstream message;
+                message << "Durable event '" << eventName << "' published without a journal";
+                log(LogLevel::Error, message.str());
+            }
+            return 0;
+        }
+
+        if constexpr (detail::is_journal_serializable_v<Args...>) {
+            try {
+                const std::uint64_t sequence = snapshot.journal->append(eventName, args...);
+                result.journaled = 1;
+                return sequence;
+            }
+            catch (const std::exception& e) {
+                std::ostringstream message;
+                message << "Journal append failed for event '" << eventName << "': " << e.what();
+                log(LogLevel::Error, message.str());
+            }
+        } else {
+            std::ostringstream message;
+            message << "Event '" << eventName << "' payload is not journal-serializable; not journaled";
+            log(snapshot.features->durable ? LogLevel::Error : LogLevel::Warning, message.str());
+        }
+        return 0;
+    }
+
+    template <typename... Args>
+    void append_to_log(const std::string& eventName, EventLog& event_log, PublishResult& result, const Args&... args)
+    {
+        if constexpr (detail::is_journal_serializable_v<Args...>) {
+            try {
+                (void)event_log.append(args...);
+                result.logged = 1;
+            }
+            catch (const std::exception& e) {
+                std::ostringstream message;
+                message << "Log append failed for event '" << eventName << "': " << e.what();
+                log(LogLevel::Error, message.str());
+            }
+        } else {
+            std::ostringstream message;
+            message << "Event '" << eventName << "' payload is not serializable; not appended to its log";
+            log(LogLevel::Error, message.str());
+        }
+    }
+
+#if EVENTBUS_HAS_POSIX
+    template <typename... Args>
+    void forward_to_shared_ring(const std::string& eventName, SharedRing& ring, PublishResult& result,
+                                const Args&... args)
+    {
+        if constexpr (detail::is_journal_serializable_v<Args...>) {
+            try {
+                result.shared = ring.publish(args...) ? 1 : 0;
+            }
+            catch (const std::exception& e) {
+                std::ostringstream message;
+                message << "Shared ring publish failed for event '" << eventName << "': " << e.what();
+                log(LogLevel::Error, message.str());
+            }
+        } else {
+            std::ostringstream message;
+            message << "Event '" << eventName << "' payload is not serializable; not forwarded to shared memory";
+            log(LogLevel::Error, message.str());
+        }
+    }
+#endif
+
+    /**
+     * Stores the event as its key's latest value, then re-reads the callback
+     * list: a subscribeWithState() that replayed before this put has
+     * subscribed by now and must receive the event live.
+     */
+    template <typename... Args>
+    void compact_event(const std::string& eventName, TopicSnapshot& snapshot, PublishResult& result,
+                       const Args&... args)
+    {
+        if constexpr (detail::is_journal_serializable_v<Args...>) {
+            try {
+                snapshot.features->compacted->put(args...);
+                result.compacted = 1;
+            }
+            catch (const std::exception& e) {
+                std::ostringstream message;
+                message << "Compaction failed for event '" << eventName << "': " << e.what();
+                log(LogLevel::Error, message.str());
+            }
+
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = callbacks_map_.find(eventName);
+            if (it != callbacks_map_.end()) {
+                snapshot.callbacks = it->second;
+            } else {
+                snapshot.callbacks.reset();
+            }
+        } else {
+            std::ostringstream message;
+            message << "Event '" << eventName << "' payload is not serializable; not retained";
+            log(LogLevel::Error, message.str());
+        }
+    }
+
+    template <typename Ret, typename... Args>
+    void replay_state(const std::string& eventName, const CompactedStore& store,
+                      const std::function<Ret(Args...)>& func)
+    {
+        std::size_t mismatches = 0;
+        store.for_each([&](const std::string&, const CompactedStore::Entry& entry) {
+            auto values = CompactedStore::decode<Args...>(entry);
+            if (!values) {
+                ++mismatches;
+                return;
+            }
+            try {
+                std::apply(func, *values);
+            }
+            catch (const std::exception& e) {
+                std::ostringstream message;
+                message << "Exception replaying state of event '" << eventName << "': " << e.what();
+                log(LogLevel::Error, message.str());
+            }
+        });
+
+        if (mismatches != 0) {
+            std::ostringstream message;
+            message << "Skipped " << mismatches << " retained values of '" << eventName
+                    << "' whose type does not match the subscriber";
+            log(LogLevel::Warning, message.str());
+        }
+    }
+
+    void save_snapshot(CompactedStore& store)
+    {
+        if (store.snapshot_path().empty() || store.save()) {
+            return;
+        }
+        std::ostringstream message;
+        message << "Failed to write state snapshot of '" << store.name() << "' to " << store.snapshot_path();
+        log(LogLevel::Error, message.str());
+    }
+
+    template <typename Task>
+    std::uint64_t schedule_every(std::chrono::milliseconds period, Task&& task)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (closing_) {
+            return 0;
+        }
+        if (!timers_) {
+            timers_ = std::make_unique<detail::TimerQueue>();
+        }
+        return timers_->schedule_every(period, std::forward<Task>(task));
+    }
+
+    /// One-shot timer; dropped once the bus is closed.
+    template <typename Task>
+    void schedule_once(std::chrono::steady_clock::duration delay, Task&& task)
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (timers_) {
+            timers_->schedule(delay, std::chrono::steady_clock::duration::zero(), std::forward<Task>(task));
+        }
+    }
+
+    /// Delivers what a removed batched subscription still buffers.
+    void close_batch(CallbackEntry& entry)
+    {
+        if (!entry.batch) {
+            return;
+        }
+        try {
+            entry.batch->close();
+        }
+        catch (const std::exception& e) {
+            std::ostringstream message;
+            message << "Callback exception (ID: " << entry.callback->get_id() << "): " << e.what();
+            log(LogLevel::Error, message.str());
+        }
+        catch (...) {
+            std::ostringstream message;
+            message << "Callback exception (ID: " << entry.callback->get_id() << "): unknown exception";
+            log(LogLevel::Error, message.str());
+        }
+    }
+
+    /// A default @p dispatch_start means the dispatch was not timed and no time is charged.
+    static void track_hot_topic(HeavyHitterTracker& tracker, const std::string& eventName,
+                                std::chrono::steady_clock::time_point dispatch_start, std::uint32_t weight)
+    {
+        std::uint64_t elapsed_ns = 0;
+        if (dispatch_start != std::chrono::steady_clock::time_point{}) {
+            elapsed_ns = weight * static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - dispatch_start).count());
+        }
+        tracker.record(eventName, elapsed_ns);
+    }
+
+    void wait_durable(const std::string& eventName, const TopicSnapshot& snapshot,
+                      std::uint64_t sequence, PublishResult& result)
+    {
+        if (snapshot.journal->wait_durable(sequence)) {
+            result.durable = 1;
+            return;
+        }
+
+        std::ostringstream message;
+        message << "Journal failed to make durable event '" << eventName << "' durable; the writer keeps retrying";
+        log(LogLevel::Error, message.str());
+    }
+
+    template <typename... Args>
+    void publish_to_callbacks(const std::string& eventName, const CallbackList& callbacks, bool verbose,
+                              PublishResult& result, Args&&... args)
+    {
+        if (verbose) {
+            std::ostringstream message;
+            message
+                << "Publish event: " << eventName
+                << "\n         args: " << sizeof...(Args)
+                << "\n        types: " << typeid(std::tuple<std::decay_t<Args>...>).name()
+                << "\n";
+            log(LogLevel::Debug, message.str());
+        }
+
+        std::any args_any;
+        if constexpr (sizeof...(Args) > 0) {
+            args_any = std::make_tuple(std::forward<Args>(args)...);
+        }
+
+        result.subscribers = callbacks.size();
+
+        for (const auto& entry : callbacks) {
+            try {
+                const InvokeStatus status = invoke_entry(entry, args_any);
+                if (status == InvokeStatus::invoked) {
+                    ++result.invoked;
+                } else if (status == InvokeStatus::consumed) {
+                    ++result.invoked;
+                    result.consumed = true;
+                    break;
+                } else if (status == InvokeStatus::skipped) {
+                    ++result.skipped;
+                } else {
+                    ++result.type_mismatches;
+                    if (verbose) {
+                        auto& wrapper = entry->callback;
+                        std::ostringstream message;
+                        message
+                            << "Type mismatch, skipping callback"
+                            << "\n             ID: " << wrapper->get_id()
+                            << "\n  expected type: " << wrapper->get_args_type().name()
+                            << "\n    actual type: " << typeid(std::tuple<std::decay_t<Args>...>).name()
+                            << "\n";
+                        log(LogLevel::Debug, message.str());
+                    }
+                }
+            }
+            catch (const std::exception& e) {
+                ++result.failed;
+                std::ostringstream message;
+                message << "Callback exception (ID: " << entry->callback->get_id() << "): " << e.what();
+                log(LogLevel::Error, message.str());
+            }
+            catch (...) {
+                ++result.failed;
+                std::ostringstream message;
+                message << "Callback exception (ID: " << entry->callback->get_id() << "): unknown exception";
+                log(LogLevel::Error, message.str());
+            }
+        }
+
+        if (verbose) {
+            std::ostringstream message;
+            message
+                << "Successfully called " << result.invoked << " callbacks"
+                << ", failed " << result.failed
+                << ", mismatched " << result.type_mismatches
+                << ", skipped " << result.skipped
+                << "\n";
+            log(LogLevel::Debug, message.str());
+        }
+    }
+
+    InvokeStatus invoke_entry(const CallbackEntryPtr& entry, const std::any& args_any)
+    {
+        if (!try_begin_invocation(*entry)) {
+            return InvokeStatus::skipped;
+        }
+
+        InvocationGuard invocation_guard(*entry);
+        bool consumed = false;
+        if (!entry->callback->try_invoke(args_any, consumed)) {
+            return InvokeStatus::type_mismatch;
+        }
+        return consumed ? InvokeStatus::consumed : InvokeStatus::invoked;
+    }
+
+    static bool try_begin_invocation(CallbackEntry& entry)
+    {
+        std::lock_guard<std::mutex> lock(entry.state_mutex);
+        if (!entry.active) {
+            return false;
+        }
+
+        ++entry.invoking[detail::ExecutionId::current()];
+
+        ++entry.in_flight;
+        return true;
+    }
+
+    static void end_invocation(CallbackEntry& entry) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(entry.state_mutex);
+            auto invoking_it = entry.invoking.find(detail::ExecutionId::current());
+            if (invoking_it != entry.invoking.end()) {
+                if (invoking_it->second <= 1) {
+                    entry.invoking.erase(invoking_it);
+                } else {
+                    --invoking_it->second;
+                }
+            }
+
+            if (entry.in_flight > 0) {
+                --entry.in_flight;
+            }
+        }
+        entry.idle_cv.notify_all();
+    }
+
+    void deactivate_entry(CallbackEntry& entry)
+    {
+        std::lock_guard<std::mutex> lock(entry.state_mutex);
+        entry.active = false;
+    }
+
+    /// True when the caller, the fiber if on one, is inside @p entry's callback.
+    static bool is_currently_invoking(const CallbackEntry& entry)
+    {
+        std::lock_guard<std::mutex> lock(entry.state_mutex);
+        auto invoking_it = entry.invoking.find(detail::ExecutionId::current());
+        return invoking_it != entry.invoking.end() && invoking_it->second > 0;
+    }
+
+    void wait_for_idle(const CallbackList& entries)
+    {
+        for (const auto& entry : entries) {
+            wait_for_idle(*entry);
+        }
+    }
+
+    void wait_for_idle(CallbackEntry& entry)
+    {
+        if (is_currently_invoking(entry)) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(entry.state_mutex);
+        detail::wait_for(entry.idle_cv, lock, [&entry]() {
+            return entry.in_flight == 0;
+        });
+    }
+
+    void log(LogLevel level, const std::string& message) const noexcept
+    {
+        try {
+            LogHandler handler;
+            {
+                std::lock_guard<std::mutex> lock(log_mutex_);
+                handler = log_handler_;
+            }
+
+            if (handler) {
+                handler(level, message);
+            }
+        }
+        catch (...) {
+        }
+    }
+
+    template<typename Ret, typename... Args>
+    std::shared_ptr<ICallbackWrapper> create_wrapper_from_function(callback_id id,
+                                                                   std::function<Ret(Args...)> func)
+    {
+        return std::make_shared<CallbackWrapper<Ret, Args...>>(id, std::move(func));
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Senders
+// ---------------------------------------------------------------------------
+
+namespace detail {
+
+template <typename Sender>
+using sender_values_t = typename std::decay_t<Sender>::value_types;
+
+template <typename Sender, typename = void>
+struct is_sender : std::false_type
+{
+};
+
+template <typename Sender>
+struct is_sender<Sender, std::void_t<sender_values_t<Sender>>> : std::true_type
+{
+};
+
+template <typename Sender>
+inline constexpr bool is_sender_v = is_sender<Sender>::value;
+
+template <typename Sender, typename Receiver>
+using connect_result_t = decltype(std::declval<Sender>().connect(std::declval<Receiver>()));
+
+template <typename Fn, typename Values>
+struct apply_result;
+
+template <typename Fn, typename... Values>
+struct apply_result<Fn, std::tuple<Values...>>
+{
+    using type = std::invoke_result_t<Fn, Values...>;
+};
+
+template <typename Fn, typename Values>
+using apply_result_t = typename apply_result<Fn, Values>::type;
+
+template <typename Values>
+struct lvalue_refs;
+
+template <typename... Values>
+struct lvalue_refs<std::tuple<Values...>>
+{
+    using type = std::tuple<Values&...>;
+};
+
+template <typename Result>
+using then_values_t = std::conditional_t<std::is_void_v<Result>, std::tuple<>, std::tuple<std::decay_t<Result>>>;
+
+/// Lets std::optional::emplace() build an operation state straight from connect().
+template <typename Fn>
+struct EmplaceFrom
+{
+    Fn fn;
+
+    operator std::invoke_result_t<Fn&>() { return fn(); }
+};
+
+template <typename Fn>
+EmplaceFrom<Fn> emplace_from(Fn fn)
+{
+    return EmplaceFrom<Fn>{std::move(fn)};
+}
+
+template <typename Values>
+struct SyncWaitState
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done{false};
+    std::optional<Values> values;
+    std::exception_ptr error;
+};
+
+template <typename Values>
+struct SyncWaitReceiver
+{
+    SyncWaitState<Values>* state;
+
+    template <typename... Args>
+    void set_value(Args&&... args)
+    {
+        try {
+            state->values.emplace(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            state->error = std::current_exception();
+        }
+        finish();
+    }
+
+    void set_error(std::exception_ptr error)
+    {
+        state->error = std::move(error);
+        finish();
+    }
+
+    void set_stopped() { finish(); }
+
+    /// Notifies under the lock: the waiter may destroy the state as soon as it sees done.
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->done = true;
+        state->cv.notify_all();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Sender/receiver algorithms in the shape of P2300 (std::execution)
+ *
+ * A sender describes work and names the values it completes with in
+ * value_types. connect(receiver) on an rvalue sender returns an operation
+ * state and start() runs it; a receiver is any type with set_value(values...),
+ * set_error(std::exception_ptr) and set_stopped(). Operation states are
+ * stored by whoever connects them (inside the parent operation, or on the
+ * stack in sync_wait()), so a chain allocates no continuations. They may be
+ * moved until start() and must stay put afterwards.
+ */
+namespace exec {
+
+template <typename... Values>
+class JustSender
+{
+public:
+    using value_types = std::tuple<Values...>;
+
+    explicit JustSender(Values... values)
+        : values_(std::move(values)...)
+    {
+    }
+
+    template <typename Receiver>
+    class Operation
+    {
+    public:
+        Operation(value_types values, Receiver receiver)
+            : values_(std::move(values)), receiver_(std::move(receiver))
+        {
+        }
+
+        void start() noexcept
+        {
+            std::apply([this](Values&... values) { receiver_.set_value(std::move(values)...); }, values_);
+        }
+
+    private:
+        value_types values_;
+        Receiver receiver_;
+    };
+
+    template <typename Receiver>
+    Operation<std::decay_t<Receiver>> connect(Receiver&& receiver) &&
+    {
+        return Operation<std::decay_t<Receiver>>(std::move(values_), std::forward<Receiver>(receiver));
+    }
+
+private:
+    value_types values_;
+};
+
+/// Sender that completes inline with @p values.
+template <typename... Values>
+JustSender<std::decay_t<Values>...> just(Values&&... values)
+{
+    return JustSender<std::decay_t<Values>...>(std::forward<Values>(values)...);
+}
+
+/// Completes schedule() inline on the thread that starts it.
+class InlineScheduler
+{
+public:
+    [[nodiscard]] JustSender<> schedule() const noexcept { return JustSender<>(); }
+
+    bool operator==(const InlineScheduler&) const noexcept { return true; }
+    bool operator!=(const InlineScheduler&) const noexcept { return false; }
+};
+
+template <typename Sender, typename Fn>
+class ThenSender
+{
+public:
+    using value_types = detail::then_values_t<detail::apply_result_t<Fn, detail::sender_values_t<Sender>>>;
+
+    ThenSender(Sender sender, Fn fn)
+        : sender_(std::move(sender)), fn_(std::move(fn))
+    {
+    }
+
+    template <typename Receiver>
+    struct ThenReceiver
+    {
+        Fn fn;
+        Receiver receiver;
+
+        template <typename... Values>
+        void set_value(Values&&... values)
+        {
+            using Result = std::invoke_result_t<Fn&, Values...>;
+            if constexpr (std::is_void_v<Result>) {
+                try {
+                    std::invoke(fn, std::forward<Values>(values)...);
+                }
+                catch (...) {
+                    receiver.set_error(std::current_exception());
+                    return;
+                }
+                receiver.set_value();
+            } else {
+                std::optional<std::decay_t<Result>> result;
+                try {
+                    result.emplace(std::invoke(fn, std::forward<Values>(values)...));
+                }
+                catch (...) {
+                    receiver.set_error(std::current_exception());
+                    return;
+                }
+                receiver.set_value(std::move(*result));
+            }
+        }
+
+        void set_error(std::exception_ptr error) { receiver.set_error(std::move(error)); }
+        void set_stopped() { receiver.set_stopped(); }
+    };
+
+    template <typename Receiver>
+    auto connect(Receiver&& receiver) &&
+    {
+        return std::move(sender_).connect(
+            ThenReceiver<std::decay_t<Receiver>>{std::move(fn_), std::forward<Receiver>(receiver)});
+    }
+
+private:
+    Sender sender_;
+    Fn fn_;
+};
+
+template <typename Sender, typename Fn>
+class LetValueSender
+{
+    using Values = detail::sender_values_t<Sender>;
+    using Next = std::decay_t<detail::apply_result_t<Fn, typename detail::lvalue_refs<Values>::type>>;
+
+public:
+    using value_types = detail::sender_values_t<Next>;
+
+    LetValueSender(Sender sender, Fn fn)
+        : sender_(std::move(sender)), fn_(std::move(fn))
+    {
+    }
+
+    template <typename Receiver>
+    class Operation
+    {
+    public:
+        Operation(Sender sender, Fn fn, Receiver receiver)
+            : sender_(std::move(sender)), fn_(std::move(fn)), receiver_(std::move(receiver))
+        {
+        }
+
+        void start() noexcept
+        {
+            first_.emplace(detail::emplace_from([this]() { return std::move(sender_).connect(FirstReceiver{this}); }));
+            first_->start();
+        }
+
+    private:
+        struct FirstReceiver
+        {
+            Operation* op;
+
+            template <typename... Args>
+            void set_value(Args&&... args)
+            {
+                op->run_next(std::forward<Args>(args)...);
+            }
+
+            void set_error(std::exception_ptr error) { op->receiver_.set_error(std::move(error)); }
+            void set_stopped() { op->receiver_.set_stopped(); }
+        };
+
+        struct NextReceiver
+        {
+            Operation* op;
+
+            template <typename... Args>
+            void set_value(Args&&... args)
+            {
+                op->receiver_.set_value(std::forward<Args>(args)...);
+            }
+
+            void set_error(std::exception_ptr error) { op->receiver_.set_error(std::move(error)); }
+            void set_stopped() { op->receiver_.set_stopped(); }
+        };
+
+        /// Keeps the values alive in the operation while the next sender runs.
+        template <typename... Args>
+        void run_next(Args&&... args)
+        {
+            try {
+                values_.emplace(std::forward<Args>(args)...);
+                next_.emplace(detail::emplace_from([this]() {
+                    return std::apply(fn_, *values_).connect(NextReceiver{this});
+                }));
+            }
+            catch (...) {
+                receiver_.set_error(std::current_exception());
+                return;
+            }
+            next_->start();
+        }
+
+        Sender sender_;
+        Fn fn_;
+        Receiver receiver_;
+        std::optional<detail::connect_result_t<Sender, FirstReceiver>> first_;
+        std::optional<Values> values_;
+        std::optional<detail::connect_result_t<Next, NextReceiver>> next_;
+    };
+
+    template <typename Receiver>
+    Operation<std::decay_t<Receiver>> connect(Receiver&& receiver) &&
+    {
+        return Operation<std::decay_t<Receiver>>(std::move(sender_), std::move(fn_), std::forward<Receiver>(receiver));
+    }
+
+private:
+    Sender sender_;
+    Fn fn_;
+};
+
+template <typename Sender, typename Scheduler>
+class ContinuesOnSender
+{
+    using Values = detail::sender_values_t<Sender>;
+    using Schedule = decltype(std::declval<const Scheduler&>().schedule());
+
+public:
+    using value_types = Values;
+
+    ContinuesOnSender(Sender sender, Scheduler scheduler)
+        : sender_(std::move(sender)), scheduler_(std::move(scheduler))
+    {
+    }
+
+    template <typename Receiver>
+    class Operation
+    {
+    public:
+        Operation(Sender sender, Scheduler scheduler, Receiver receiver)
+            : sender_(std::move(sender)), scheduler_(std::move(scheduler)), receiver_(std::move(receiver))
+        {
+        }
+
+        void start() noexcept
+        {
+            first_.emplace(detail::emplace_from([this]() { return std::move(sender_).connect(FirstReceiver{this}); }));
+            first_->start();
+        }
+
+    private:
+        struct FirstReceiver
+        {
+            Operation* op;
+
+            template <typename... Args>
+            void set_value(Args&&... args)
+            {
+                op->hop(std::forward<Args>(args)...);
+            }
+
+            void set_error(std::exception_ptr error) { op->receiver_.set_error(std::move(error)); }
+            void set_stopped() { op->receiver_.set_stopped(); }
+        };
+
+        struct HopReceiver
+        {
+            Operation* op;
+
+            void set_value()
+            {
+                std::apply([this](auto&... values) { op->receiver_.set_value(std::move(values)...); }, *op->values_);
+            }
+
+            void set_error(std::exception_ptr error) { op->receiver_.set_error(std::move(error)); }
+            void set_stopped() { op->receiver_.set_stopped(); }
+        };
+
+        template <typename... Args>
+        void hop(Args&&... args)
+        {
+            try {
+                values_.emplace(std::forward<Args>(args)...);
+                hop_.emplace(detail::emplace_from([this]() {
+                    return scheduler_.schedule().connect(HopReceiver{this});
+                }));
+            }
+            catch (...) {
+                receiver_.set_error(std::current_exception());
+                return;
+            }
+            hop_->start();
+        }
+
+        Sender sender_;
+        Scheduler scheduler_;
+        Receiver receiver_;
+        std::optional<detail::connect_result_t<Sender, FirstReceiver>> first_;
+        std::optional<Values> values_;
+        std::optional<detail::connect_result_t<Schedule, HopReceiver>> hop_;
+    };
+
+    template <typename Receiver>
+    Operation<std::decay_t<Receiver>> connect(Receiver&& receiver) &&
+    {
+        return Operation<std::decay_t<Receiver>>(std::move(sender_), std::move(scheduler_),
+                                                 std::forward<Receiver>(receiver));
+    }
+
+private:
+    Sender sender_;
+    Scheduler scheduler_;
+};
+
+/// Pipeable form of an algorithm: `sender | then(fn)`.
+template <typename Adaptor>
+class Closure
+{
+public:
+    explicit Closure(Adaptor adaptor)
+        : adaptor_(std::move(adaptor))
+    {
+    }
+
+    template <typename Sender, typename = std::enable_if_t<detail::is_sender_v<Sender>>>
+    friend auto operator|(Sender&& sender, Closure closure)
+    {
+        return std::move(closure.adaptor_)(std::forward<Sender>(sender));
+    }
+
+private:
+    Adaptor adaptor_;
+};
+
+template <typename Adaptor>
+Closure<Adaptor> make_closure(Adaptor adaptor)
+{
+    return Closure<Adaptor>(std::move(adaptor));
+}
+
+/// Completes with @p fn applied to the values of @p sender; an exception from @p fn becomes set_error().
+template <typename Sender, typename Fn, typename = std::enable_if_t<detail::is_sender_v<Sender>>>
+ThenSender<std::decay_t<Sender>, std::decay_t<Fn>> then(Sender&& sender, Fn&& fn)
+{
+    return ThenSender<std::decay_t<Sender>, std::decay_t<Fn>>(std::forward<Sender>(sender), std::forward<Fn>(fn));
+}
+
+template <typename Fn>
+auto then(Fn fn)
+{
+    return make_closure([fn = std::move(fn)](auto&& sender) mutable {
+        return then(std::forward<decltype(sender)>(sender), std::move(fn));
+    });
+}
+
+/// Runs the sender returned by @p fn, which receives the values of @p sender as lvalues kept alive meanwhile.
+template <typename Sender, typename Fn, typename = std::enable_if_t<detail::is_sender_v<Sender>>>
+LetValueSender<std::decay_t<Sender>, std::decay_t<Fn>> let_value(Sender&& sender, Fn&& fn)
+{
+    return LetValueSender<std::decay_t<Sender>, std::decay_t<Fn>>(std::forward<Sender>(sender),
+                                                                  std::forward<Fn>(fn));
+}
+
+template <typename Fn>
+auto let_value(Fn fn)
+{
+    return make_closure([fn = std::move(fn)](auto&& sender) mutable {
+        return let_value(std::forward<decltype(sender)>(sender), std::move(fn));
+    });
+}
+
+/// Completes with the values of @p sender on an execution agent of @p scheduler.
+template <typename Sender, typename Scheduler, typename = std::enable_if_t<detail::is_sender_v<Sender>>>
+ContinuesOnSender<std::decay_t<Sender>, std::decay_t<Scheduler>> continues_on(Sender&& sender, Scheduler&& scheduler)
+{
+    return ContinuesOnSender<std::decay_t<Sender>, std::decay_t<Scheduler>>(std::forward<Sender>(sender),
+                                                                            std::forward<Scheduler>(scheduler));
+}
+
+template <typename Scheduler>
+auto continues_on(Scheduler scheduler)
+{
+    return make_closure([scheduler = std::move(scheduler)](auto&& sender) mutable {
+        return continues_on(std::forward<decltype(sender)>(sender), std::move(scheduler));
+    });
+}
+
+/// Starts @p sender on an execution agent of @p scheduler.
+template <typename Scheduler, typename Sender>
+auto starts_on(Scheduler&& scheduler, Sender&& sender)
+{
+    return let_value(scheduler.schedule(), [sender = std::decay_t<Sender>(std::forward<Sender>(sender))]() mutable {
+        return std::move(sender);
+    });
+}
+
+/**
+ * @brief Starts @p sender and blocks until it completes
+ *
+ * Returns the values, or std::nullopt when it completed with set_stopped();
+ * rethrows what it completed with set_error(). Do not call it from a thread
+ * the sender needs in order to finish, such as the only async worker.
+ */
+template <typename Sender, typename = std::enable_if_t<detail::is_sender_v<Sender>>>
+std::optional<detail::sender_values_t<Sender>> sync_wait(Sender&& sender)
+{
+    using Values = detail::sender_values_t<Sender>;
+    detail::SyncWaitState<Values> state;
+    auto operation = std::decay_t<Sender>(std::forward<Sender>(sender)).connect(detail::SyncWaitReceiver<Values>{&state});
+    operation.start();
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.cv.wait(lock, [&state]() { return state.done; });
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+    return std::move(state.values);
+}
+
+} // namespace exec
+
+namespace detail {
+
+/// Completion claim shared by a one-shot subscription and the operation that made it.
+struct OneShot : BatchSink
+{
+    std::mutex mutex;
+    callback_id id{0};
+    bool fired{false};
+    std::function<void()> stopped;      // set before subscribing; runs if the subscription goes away unfired
+
+    /// Claims the completion; @p subscription receives the id to remove, 0 while not yet known.
+    bool fire(callback_id& subscription)
     {
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        log_handler_ = std::move(handler);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fired) {
+            return false;
+        }
+        fired = true;
+        subscription = id;
+        return true;
+    }
+
+    /// Records the subscription id; false when it already fired and the caller must remove it.
+    bool arm(callback_id subscription)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fired) {
+            return false;
+        }
+        id = subscription;
+        return true;
+    }
+
+    /// The subscription was removed, or the bus closed, before an event claimed it.
+    void close() override
+    {
+        callback_id subscription = 0;
+        if (fire(subscription) && stopped) {
+            stopped();
+        }
+    }
+};
+
+struct SenderAccess
+{
+    template <typename Payload, typename Done>
+    static bool enqueue_async(EventBus& bus, const std::string& eventName, Payload&& payload, Done&& done,
+                              std::function<void()> on_shed)
+    {
+        return bus.enqueue_async(eventName, std::forward<Payload>(payload), std::forward<Done>(done),
+                                 std::move(on_shed));
+    }
+
+    static bool enqueue_task(EventBus& bus, std::function<void()> task, std::function<void()> on_shed)
+    {
+        return bus.enqueue_task(std::move(task), std::move(on_shed));
     }
 
     template <typename Callback>
-    callback_id subscribe(const std::string& eventName,
-                          Callback&& callback)
+    static callback_id subscribe_sink(EventBus& bus, const std::string& eventName, Callback&& callback,
+                                      std::shared_ptr<BatchSink> sink)
     {
-        using CallbackType = std::decay_t<Callback>;
-        using Traits = detail::function_traits<CallbackType>;
-        using Signature = typename Traits::signature;
-        static_assert(std::is_void_v<typename Traits::return_type>,
-                      "EventBus callbacks must return void");
+        return bus.subscribe_entry(eventName, std::forward<Callback>(callback), 0, std::move(sink));
+    }
+};
 
-        callback_id id = 0;
-        const bool verbose = verbose_logging_.load(std::memory_order_relaxed);
+/**
+ * Subscribes @p complete to the next event on @p eventName only. The first
+ * publisher to claim the event removes the subscription before calling
+ * @p complete, so concurrent publishers never touch the caller's state
+ * afterwards. If the subscription is removed or the bus closes first,
+ * @p stopped runs instead, on that thread. Returns null when the bus is
+ * closed.
+ */
+template <typename... Values, typename Complete>
+std::shared_ptr<OneShot> subscribe_once(EventBus& bus, const std::string& eventName, Complete complete,
+                                        std::function<void()> stopped)
+{
+    auto shot = std::make_shared<OneShot>();
+    shot->stopped = std::move(stopped);
+    auto callback = [bus = &bus, eventName, shot, complete](const Values&... values) {
+        callback_id subscription = 0;
+        if (!shot->fire(subscription)) {
+            return;
+        }
+        if (subscription != 0) {
+            (void)bus->unsubscribe(eventName, subscription);
+        }
+        complete(values...);
+    };
+    const callback_id id = SenderAccess::subscribe_sink(bus, eventName, std::move(callback), shot);
+    if (id == 0) {
+        return nullptr;
+    }
+    if (!shot->arm(id)) {
+        (void)bus.unsubscribe(eventName, id);
+    }
+    return shot;
+}
+
+} // namespace detail
+
+/// Scheduler over the publishAsync() workers; see EventBus::scheduler().
+class AsyncScheduler
+{
+public:
+    class ScheduleSender
+    {
+    public:
+        using value_types = std::tuple<>;
 
+        explicit ScheduleSender(EventBus* bus) noexcept
+            : bus_(bus)
         {
-            std::unique_lock<std::shared_mutex> lock(mutex_);
-            if (closing_) {
-                return 0;
+        }
+
+        template <typename Receiver>
+        class Operation
+        {
+        public:
+            Operation(EventBus* bus, Receiver receiver)
+                : bus_(bus), receiver_(std::move(receiver))
+            {
             }
 
-            id = next_id_.fetch_add(1, std::memory_order_relaxed) + 1;
-            std::function<Signature> func(std::forward<Callback>(callback));
-            auto entry = std::make_shared<CallbackEntry>(create_wrapper_from_function(id, std::move(func)));
+            void start() noexcept
+            {
+                if (!detail::SenderAccess::enqueue_task(*bus_, [this]() { receiver_.set_value(); },
+                                                        [this]() { receiver_.set_stopped(); })) {
+                    receiver_.set_stopped();
+                }
+            }
 
-            callbacks_map_[eventName].push_back(std::move(entry));
-        }
+        private:
+            EventBus* bus_;
+            Receiver receiver_;
+        };
 
-        if (verbose) {
-            std::ostringstream message;
-            message
-                << "Subscribe event: " << eventName
-                << "\n             ID: " << id
-                << "\n          Types: " << typeid(CallbackType).name()
-                << "\n      Signature: " << typeid(Signature).name()
-                << "\n";
-            log(LogLevel::Debug, message.str());
+        template <typename Receiver>
+        Operation<std::decay_t<Receiver>> connect(Receiver&& receiver) &&
+        {
+            return Operation<std::decay_t<Receiver>>(bus_, std::forward<Receiver>(receiver));
         }
 
-        return id;
+    private:
+        EventBus* bus_;
+    };
+
+    explicit AsyncScheduler(EventBus& bus) noexcept
+        : bus_(&bus)
+    {
     }
 
-    [[nodiscard]] bool unsubscribe(const std::string& eventName, callback_id id)
+    [[nodiscard]] ScheduleSender schedule() const noexcept { return ScheduleSender(bus_); }
+
+    bool operator==(const AsyncScheduler& other) const noexcept { return bus_ == other.bus_; }
+    bool operator!=(const AsyncScheduler& other) const noexcept { return bus_ != other.bus_; }
+
+private:
+    EventBus* bus_;
+};
+
+/// See EventBus::publishSender().
+template <typename... Payload>
+class PublishSender
+{
+public:
+    using value_types = std::tuple<EventBus::PublishResult>;
+
+    PublishSender(EventBus* bus, std::string eventName, std::tuple<Payload...> payload)
+        : bus_(bus), event_name_(std::move(eventName)), payload_(std::move(payload))
     {
-        CallbackEntryPtr removed_entry;
+    }
 
+    template <typename Receiver>
+    class Operation
+    {
+    public:
+        Operation(EventBus* bus, std::string eventName, std::tuple<Payload...> payload, Receiver receiver)
+            : bus_(bus), event_name_(std::move(eventName)), payload_(std::move(payload)),
+              receiver_(std::move(receiver))
         {
-            std::unique_lock<std::shared_mutex> lock(mutex_);
+        }
 
-            auto it = callbacks_map_.find(eventName);
-            if (it == callbacks_map_.end()) {
-                return false;
+        void start() noexcept
+        {
+            bool queued = false;
+            try {
+                queued = detail::SenderAccess::enqueue_async(
+                    *bus_, event_name_, std::move(payload_),
+                    [this](const EventBus::PublishResult& result) { receiver_.set_value(result); },
+                    [this]() { receiver_.set_stopped(); });
             }
-
-            auto& callbacks = it->second;
-            auto callback_it = std::find_if(callbacks.begin(), callbacks.end(),
-                                            [id](const CallbackEntryPtr& entry) {
-                return entry->callback->get_id() == id;
-            });
-
-            if (callback_it == callbacks.end()) {
-                return false;
+            catch (...) {
+                receiver_.set_error(std::current_exception());
+                return;
             }
-
-            removed_entry = *callback_it;
-            deactivate_entry(*removed_entry);
-            callbacks.erase(callback_it);
-            if (callbacks.empty()) {
-                callbacks_map_.erase(it);
+            if (!queued) {
+                receiver_.set_stopped();
             }
         }
 
-        wait_for_idle(*removed_entry);
-        return true;
+    private:
+        EventBus* bus_;
+        std::string event_name_;
+        std::tuple<Payload...> payload_;
+        Receiver receiver_;
+    };
+
+    template <typename Receiver>
+    Operation<std::decay_t<Receiver>> connect(Receiver&& receiver) &&
+    {
+        return Operation<std::decay_t<Receiver>>(bus_, std::move(event_name_), std::move(payload_),
+                                                 std::forward<Receiver>(receiver));
     }
 
-    [[nodiscard]] bool isEventRegistered(const std::string& eventName) const
+private:
+    EventBus* bus_;
+    std::string event_name_;
+    std::tuple<Payload...> payload_;
+};
+
+/// See EventBus::nextEvent().
+template <typename... Args>
+class NextEventSender
+{
+public:
+    using value_types = std::tuple<std::decay_t<Args>...>;
+
+    NextEventSender(EventBus* bus, std::string eventName)
+        : bus_(bus), event_name_(std::move(eventName))
     {
-        std::shared_lock<std::shared_mutex> lock(mutex_);
-        auto it = callbacks_map_.find(eventName);
-        return it != callbacks_map_.end() && !it->second.empty();
     }
 
-    template <typename... Args>
-    PublishResult publish(const std::string& eventName, Args&&... args)
+    template <typename Receiver>
+    class Operation
     {
-        const bool verbose = verbose_logging_.load(std::memory_order_relaxed);
-        CallbackList callbacks = snapshot_callbacks(eventName);
+    public:
+        Operation(EventBus* bus, std::string eventName, Receiver receiver)
+            : bus_(bus), event_name_(std::move(eventName)), receiver_(std::move(receiver))
+        {
+        }
 
-        if (callbacks.empty()) {
-            if (verbose) {
-                std::ostringstream message;
-                message << "Event '" << eventName << "' has no callbacks";
-                log(LogLevel::Warning, message.str());
+        void start() noexcept
+        {
+            std::shared_ptr<detail::OneShot> shot;
+            try {
+                shot = detail::subscribe_once<std::decay_t<Args>...>(*bus_, event_name_,
+                    [this](const std::decay_t<Args>&... values) { receiver_.set_value(values...); },
+                    [this]() { receiver_.set_stopped(); });
+            }
+            catch (...) {
+                receiver_.set_error(std::current_exception());
+                return;
+            }
+            if (!shot) {
+                receiver_.set_stopped();
             }
-            return {};
         }
 
-        return publish_to_callbacks(eventName, callbacks, verbose, std::forward<Args>(args)...);
+    private:
+        EventBus* bus_;
+        std::string event_name_;
+        Receiver receiver_;
+    };
+
+    template <typename Receiver>
+    Operation<std::decay_t<Receiver>> connect(Receiver&& receiver) &&
+    {
+        return Operation<std::decay_t<Receiver>>(bus_, std::move(event_name_), std::forward<Receiver>(receiver));
     }
 
-    [[nodiscard]] std::size_t getCallbackCount(const std::string& eventName) const
+private:
+    EventBus* bus_;
+    std::string event_name_;
+};
+
+/// See EventBus::request().
+template <typename... Replies, typename... Payload>
+class RequestSender<std::tuple<Replies...>, std::tuple<Payload...>>
+{
+public:
+    using value_types = std::tuple<std::decay_t<Replies>...>;
+
+    RequestSender(EventBus* bus, std::string requestTopic, std::string replyTopic, std::tuple<Payload...> payload)
+        : bus_(bus), request_topic_(std::move(requestTopic)), reply_topic_(std::move(replyTopic)),
+          payload_(std::move(payload))
     {
-        std::shared_lock<std::shared_mutex> lock(mutex_);
-        auto it = callbacks_map_.find(eventName);
-        return it != callbacks_map_.end() ? it->second.size() : 0;
     }
 
-    [[nodiscard]] std::size_t unsubscribe_all(const std::string& eventName)
+    template <typename Receiver>
+    class Operation
     {
-        CallbackList removed_entries;
-        std::size_t count = 0;
+    public:
+        Operation(EventBus* bus, std::string requestTopic, std::string replyTopic, std::tuple<Payload...> payload,
+                  Receiver receiver)
+            : bus_(bus), request_topic_(std::move(requestTopic)), reply_topic_(std::move(replyTopic)),
+              payload_(std::move(payload)), receiver_(std::move(receiver))
+        {
+        }
 
+        /// A reply may complete the operation during publish(), so nothing here touches it afterwards unless it won the claim.
+        void start() noexcept
         {
-            std::unique_lock<std::shared_mutex> lock(mutex_);
+            EventBus* const bus = bus_;
+            const std::string request_topic = request_topic_;
+            const std::string reply_topic = reply_topic_;
+            std::tuple<Payload...> payload = std::move(payload_);
 
-            auto it = callbacks_map_.find(eventName);
-            if (it == callbacks_map_.end()) {
-                return 0;
+            std::shared_ptr<detail::OneShot> shot;
+            EventBus::PublishResult result{};
+            try {
+                shot = detail::subscribe_once<std::decay_t<Replies>...>(*bus, reply_topic,
+                    [this](const std::decay_t<Replies>&... replies) { receiver_.set_value(replies...); },
+                    [this]() { receiver_.set_stopped(); });
+                if (!shot) {
+                    receiver_.set_stopped();
+                    return;
+                }
+                result = std::apply([bus, &request_topic](const Payload&... values) {
+                    return bus->publish(request_topic, values...);
+                }, payload);
+            }
+            catch (...) {
+                callback_id subscription = 0;
+                if (shot && shot->fire(subscription)) {
+                    if (subscription != 0) {
+                        (void)bus->unsubscribe(reply_topic, subscription);
+                    }
+                    receiver_.set_error(std::current_exception());
+                }
+                return;
             }
 
-            removed_entries = it->second;
-            for (const auto& entry : removed_entries) {
-                deactivate_entry(*entry);
+            callback_id subscription = 0;
+            if (result.invoked == 0 && shot->fire(subscription)) {
+                (void)bus->unsubscribe(reply_topic, subscription);
+                receiver_.set_stopped();
             }
-            count = removed_entries.size();
-            callbacks_map_.erase(it);
         }
 
-        wait_for_idle(removed_entries);
-        return count;
+    private:
+        EventBus* bus_;
+        std::string request_topic_;
+        std::string reply_topic_;
+        std::tuple<Payload...> payload_;
+        Receiver receiver_;
+    };
+
+    template <typename Receiver>
+    Operation<std::decay_t<Receiver>> connect(Receiver&& receiver) &&
+    {
+        return Operation<std::decay_t<Receiver>>(bus_, std::move(request_topic_), std::move(reply_topic_),
+                                                 std::move(payload_), std::forward<Receiver>(receiver));
     }
 
-    [[nodiscard]] std::vector<std::string> getAllEventNames() const
+private:
+    EventBus* bus_;
+    std::string request_topic_;
+    std::string reply_topic_;
+    std::tuple<Payload...> payload_;
+};
+
+inline AsyncScheduler EventBus::scheduler() noexcept
+{
+    return AsyncScheduler(*this);
+}
+
+template <typename... Args>
+PublishSender<detail::async_value_t<Args>...> EventBus::publishSender(const std::string& eventName, Args&&... args)
+{
+    return PublishSender<detail::async_value_t<Args>...>(
+        this, eventName, std::make_tuple(detail::async_value_t<Args>(std::forward<Args>(args))...));
+}
+
+template <typename... Args>
+NextEventSender<Args...> EventBus::nextEvent(const std::string& eventName)
+{
+    return NextEventSender<Args...>(this, eventName);
+}
+
+template <typename... Replies, typename... Args>
+RequestSender<std::tuple<Replies...>, std::tuple<detail::async_value_t<Args>...>> EventBus::request(
+    const std::string& requestTopic, const std::string& replyTopic, Args&&... args)
+{
+    return RequestSender<std::tuple<Replies...>, std::tuple<detail::async_value_t<Args>...>>(
+        this, requestTopic, replyTopic, std::make_tuple(detail::async_value_t<Args>(std::forward<Args>(args))...));
+}
+
+// ---------------------------------------------------------------------------
+// Federation links
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief Handle of a parent/child link; see EventBus::linkChild()
+ *
+ * Both buses keep the link until unlink() or either bus closes, so the
+ * handle may be dropped.
+ */
+class BusLink : public std::enable_shared_from_this<BusLink>
+{
+public:
+    /// Delivers buffered events and detaches the link from both buses. Idempotent.
+    void unlink()
     {
-        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (!linked_) {
+            return;
+        }
+        linked_ = false;
+        const auto self = shared_from_this();
+
+        down_->from->detach_link(down_);
+        up_->from->detach_link(up_);
+        for (detail::LinkEnd* end : {down_.get(), up_.get()}) {
+            end->shut();
+            if (end->batcher) {
+                end->batcher->close();
+            }
+        }
+        down_->from->advertise_interest();
+        up_->from->advertise_interest();
+        std::atomic_store(&down_->link, std::shared_ptr<BusLink>());
+        std::atomic_store(&up_->link, std::shared_ptr<BusLink>());
+    }
 
-        std::vector<std::string> event_names;
-        event_names.reserve(callbacks_map_.size());
+    [[nodiscard]] bool linked() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return linked_;
+    }
 
-        for (const auto& pair : callbacks_map_) {
-            if (!pair.second.empty()) {
-                event_names.push_back(pair.first);
+    /// Delivers what both directions have buffered now.
+    void flush()
+    {
+        for (detail::LinkEnd* end : {down_.get(), up_.get()}) {
+            if (end->batcher && end->enter()) {
+                end->batcher->flush();
+                end->leave();
             }
         }
+    }
 
-        return event_names;
+    /// Parent to child.
+    [[nodiscard]] LinkStats downstream() const { return down_->from->link_stats(*down_); }
+
+    /// Child to parent.
+    [[nodiscard]] LinkStats upstream() const { return up_->from->link_stats(*up_); }
+
+private:
+    friend class EventBus;
+
+    BusLink(std::shared_ptr<detail::LinkEnd> down, std::shared_ptr<detail::LinkEnd> up)
+        : down_(std::move(down)), up_(std::move(up))
+    {
     }
 
-    [[nodiscard]] EventBusStats getStats() const
+    std::shared_ptr<detail::LinkEnd> down_;
+    std::shared_ptr<detail::LinkEnd> up_;
+    mutable std::recursive_mutex mutex_;        // recursive: a bus closing inside a forwarded delivery unlinks again
+    bool linked_{true};
+};
+
+inline std::shared_ptr<BusLink> EventBus::linkChild(EventBus& child, LinkOptions options)
+{
+    if (&child == this) {
+        throw std::invalid_argument("A bus cannot be linked to itself");
+    }
+    // Serializes the cycle check with the attach below, so two links made at once cannot close a loop.
+    static std::mutex topology_mutex;
+    std::lock_guard<std::mutex> topology(topology_mutex);
     {
         std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& end : links_) {
+            if (end->to == &child) {
+                throw std::invalid_argument("Buses are already linked");
+            }
+        }
+    }
+    std::vector<EventBus*> frontier{&child};
+    std::unordered_set<const EventBus*> reached{&child};
+    while (!frontier.empty()) {
+        EventBus* const bus = frontier.back();
+        frontier.pop_back();
+        std::shared_lock<std::shared_mutex> lock(bus->mutex_);
+        for (const auto& end : bus->links_) {
+            if (end->to == this) {
+                throw std::invalid_argument("Linking these buses would form a cycle");
+            }
+            if (reached.insert(end->to).second) {
+                frontier.push_back(end->to);
+            }
+        }
+    }
 
-        EventBusStats stats{};
-        stats.total_events = 0;
-        stats.total_callbacks = 0;
-        stats.max_callbacks_per_event = 0;
+    auto make_end = [&options](EventBus* from, EventBus* to) {
+        auto end = std::make_shared<detail::LinkEnd>();
+        end->from = from;
+        end->to = to;
+        if (options.max_events > 1) {
+            BatchOptions batching;
+            batching.max_events = options.max_events;
+            batching.max_delay = options.max_delay;
+            detail::LinkEnd* const raw = end.get();
+            end->batcher = std::make_unique<detail::LinkEnd::Batcher>(batching,
+                [raw](const std::vector<std::function<void()>>& events) {
+                    raw->batches.fetch_add(1, std::memory_order_relaxed);
+                    for (const auto& event : events) {
+                        try {
+                            event();
+                        }
+                        catch (...) {
+                        }
+                    }
+                });
+        }
+        return end;
+    };
+    auto down = make_end(this, &child);
+    auto up = make_end(&child, this);
+    down->reverse = up.get();
+    up->reverse = down.get();
+    std::shared_ptr<BusLink> link(new BusLink(down, up));
+    down->link = link;
+    up->link = link;
+
+    if (!attach_link(down)) {
+        std::atomic_store(&down->link, std::shared_ptr<BusLink>());
+        std::atomic_store(&up->link, std::shared_ptr<BusLink>());
+        return nullptr;
+    }
+    if (!child.attach_link(up)) {
+        link->unlink();
+        return nullptr;
+    }
+    // Until both ends are attached an advertisement could be dropped by the far side yet recorded as sent.
+    down->advertising.store(true, std::memory_order_release);
+    up->advertising.store(true, std::memory_order_release);
+    advertise_interest();
+    child.advertise_interest();
+    return link;
+}
+
+inline void EventBus::unlink_all()
+{
+    LinkEnds ends;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        ends = links_;
+    }
+    for (const auto& end : ends) {
+        if (auto link = std::atomic_load(&end->link)) {
+            link->unlink();
+        }
+    }
+}
 
-        for (const auto& pair : callbacks_map_) {
-            if (!pair.second.empty()) {
-                stats.total_events++;
-                std::size_t callback_count = pair.second.size();
-                stats.total_callbacks += callback_count;
+// ---------------------------------------------------------------------------
+// Sharded runtime
+// ---------------------------------------------------------------------------
+
+struct ShardedOptions
+{
+    std::size_t shards{0};                  // 0: one per hardware thread
+    std::size_t queue_capacity{4096};       // events per shard-to-shard queue, rounded up to a power of two
+    bool pin_threads{true};                 // pin shard i to CPU (first_cpu + i) % CPUs, where supported
+    std::size_t first_cpu{0};
+    std::size_t idle_spins{256};            // empty polls before a shard thread parks
+};
+
+struct ShardStats
+{
+    std::size_t shard;
+    std::uint64_t local;        // published on the shard's own thread and dispatched inline
+    std::uint64_t remote;       // arrived from another shard's thread
+    std::uint64_t external;     // arrived from a thread outside the bus
+    std::size_t backlog;        // queued, not yet dispatched
+};
 
-                if (callback_count > stats.max_callbacks_per_event) {
-                    stats.max_callbacks_per_event = callback_count;
-                    stats.most_subscribed_event = pair.first;
-                }
-            }
-        }
+namespace detail {
 
-        return stats;
+/// Bounded single-producer single-consumer ring; indices grow without wrapping.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
     }
 
-    template <typename... Args>
-    [[nodiscard]] bool publish_if_min_subscribers(const std::string& eventName, size_t min_subscribers, Args&&... args)
+    bool try_push(T&& value)
     {
-        const bool verbose = verbose_logging_.load(std::memory_order_relaxed);
-        CallbackList callbacks;
-
-        {
-            std::shared_lock<std::shared_mutex> lock(mutex_);
-            if (closing_) {
-                return false;
-            }
-            auto it = callbacks_map_.find(eventName);
-            if (it == callbacks_map_.end() || it->second.size() < min_subscribers) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
                 return false;
             }
-            callbacks = it->second;
         }
-
-        (void)publish_to_callbacks(eventName, callbacks, verbose, std::forward<Args>(args)...);
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
         return true;
     }
 
-    void clear()
+    bool try_pop(T& value)
     {
-        CallbackList removed_entries;
-
-        {
-            std::unique_lock<std::shared_mutex> lock(mutex_);
-            for (const auto& pair : callbacks_map_) {
-                for (const auto& entry : pair.second) {
-                    deactivate_entry(*entry);
-                    removed_entries.push_back(entry);
-                }
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
             }
-            callbacks_map_.clear();
         }
-
-        wait_for_idle(removed_entries);
+        value = std::move(slots_[head & mask_]);
+        slots_[head & mask_] = T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
     }
 
-    void close()
+    [[nodiscard]] std::size_t size() const noexcept
     {
-        std::unordered_map<std::string, CallbackList> removed_callbacks;
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
 
-        {
-            std::unique_lock<std::shared_mutex> lock(mutex_);
-            if (closing_ && callbacks_map_.empty()) {
-                return;
-            }
+private:
+    std::vector<T> slots_;
+    std::size_t mask_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_{0};                     // consumer's view of tail_
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_{0};                     // producer's view of head_
+};
 
-            closing_ = true;
-            removed_callbacks.swap(callbacks_map_);
-        }
+inline void pin_current_thread(std::size_t cpu) noexcept
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(cpu % CPU_SETSIZE), &set);
+    (void)::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
 
-        for (const auto& pair : removed_callbacks) {
-            for (const auto& entry : pair.second) {
-                deactivate_entry(*entry);
-            }
+} // namespace detail
+
+/**
+ * @brief Thread-per-core bus: each shard owns a slice of the topics
+ *
+ * Topics are hashed to shards. Each shard has its own EventBus (and so its
+ * own registry and lock) and a thread, pinned to a CPU where supported, on
+ * which all of its subscribers run. publish() routes transparently: on the
+ * owning shard's thread the event is dispatched inline, from another
+ * shard's thread it goes through the single-producer queue dedicated to
+ * that pair of shards, and from any other thread through the shard's
+ * mutex-protected inbox. Arguments are copied as in publishAsync().
+ *
+ * A shard thread that finds a full queue keeps dispatching its own inbound
+ * events while it waits, so two shards publishing to each other cannot
+ * deadlock. Those events may publish into full queues in turn; past
+ * max_publish_depth nested waits the event goes to an unbounded overflow
+ * list on the target instead, which bounds the stack but lets it overtake events still
+ * queued from the same shard.
+ */
+class ShardedEventBus
+{
+public:
+    explicit ShardedEventBus(ShardedOptions options = {})
+        : options_(options)
+    {
+        if (options_.shards == 0) {
+            options_.shards = std::max(1u, std::thread::hardware_concurrency());
         }
+        const std::size_t cpus = std::max(1u, std::thread::hardware_concurrency());
 
-        for (const auto& pair : removed_callbacks) {
-            wait_for_idle(pair.second);
+        shards_.reserve(options_.shards);
+        for (std::size_t i = 0; i < options_.shards; ++i) {
+            shards_.push_back(std::make_unique<Shard>(i, options_.shards, options_.queue_capacity));
+        }
+        for (std::size_t i = 0; i < options_.shards; ++i) {
+            Shard* shard = shards_[i].get();
+            const std::size_t cpu = (options_.first_cpu + i) % cpus;
+            shard->thread = std::thread([this, shard, cpu]() {
+                if (options_.pin_threads) {
+                    detail::pin_current_thread(cpu);
+                }
+                run(*shard);
+            });
         }
     }
 
-private:
-    class InvocationGuard
-    {
-    public:
-        explicit InvocationGuard(CallbackEntry& entry)
-            : entry_(entry)
-        {
-        }
+    /// Nested dispatches a shard thread runs while waiting on full queues.
+    static constexpr std::size_t max_publish_depth = 16;
 
-        InvocationGuard(const InvocationGuard&) = delete;
-        InvocationGuard& operator=(const InvocationGuard&) = delete;
+    ShardedEventBus(const ShardedEventBus&) = delete;
+    ShardedEventBus& operator=(const ShardedEventBus&) = delete;
 
-        ~InvocationGuard()
-        {
-            end_invocation(entry_);
-        }
+    ~ShardedEventBus()
+    {
+        close();
+    }
 
-    private:
-        CallbackEntry& entry_;
-    };
+    [[nodiscard]] std::size_t shard_count() const noexcept { return shards_.size(); }
 
-    CallbackList snapshot_callbacks(const std::string& eventName) const
+    [[nodiscard]] std::size_t shard_of(const std::string& eventName) const noexcept
     {
-        std::shared_lock<std::shared_mutex> lock(mutex_);
-        if (closing_) {
-            return {};
-        }
+        return std::hash<std::string>{}(eventName) % shards_.size();
+    }
 
-        auto it = callbacks_map_.find(eventName);
-        if (it == callbacks_map_.end()) {
-            return {};
-        }
+    /// The bus behind shard @p index, for per-topic configuration such as rate limits or journals.
+    [[nodiscard]] EventBus& shard(std::size_t index) { return shards_.at(index)->bus; }
+
+    /// Subscribes on the owning shard; the callback runs on that shard's thread. Ids are unique per shard.
+    template <typename Callback>
+    callback_id subscribe(const std::string& eventName, Callback&& callback)
+    {
+        return shards_[shard_of(eventName)]->bus.subscribe(eventName, std::forward<Callback>(callback));
+    }
 
-        return it->second;
+    [[nodiscard]] bool unsubscribe(const std::string& eventName, callback_id id)
+    {
+        return shards_[shard_of(eventName)]->bus.unsubscribe(eventName, id);
     }
 
+    /**
+     * Routes the event to its owning shard. From outside the bus, false once
+     * close() has begun; subscribers keep publishing until close() has
+     * drained, so events their queued events publish in turn still arrive.
+     */
     template <typename... Args>
-    PublishResult publish_to_callbacks(const std::string& eventName, const CallbackList& callbacks, bool verbose, Args&&... args)
+    bool publish(const std::string& eventName, Args&&... args)
     {
-        if (verbose) {
-            std::ostringstream message;
-            message
-                << "Publish event: " << eventName
-                << "\n         args: " << sizeof...(Args)
-                << "\n        types: " << typeid(std::tuple<std::decay_t<Args>...>).name()
-                << "\n";
-            log(LogLevel::Debug, message.str());
+        CurrentShard& current = current_shard();
+        const bool stopping = current.owner == this ? stopped_.load(std::memory_order_acquire)
+                                                    : closed_.load(std::memory_order_acquire);
+        if (stopping) {
+            return false;
         }
+        Shard& target = *shards_[shard_of(eventName)];
 
-        std::any args_any;
-        if constexpr (sizeof...(Args) > 0) {
-            args_any = std::make_tuple(std::forward<Args>(args)...);
+        if (current.owner == this && current.index == target.index) {
+            ++target.local;
+            (void)target.bus.publish(eventName, std::forward<Args>(args)...);
+            return true;
         }
 
-        PublishResult result{};
-        result.subscribers = callbacks.size();
-
-        for (const auto& entry : callbacks) {
-            try {
-                const InvokeStatus status = invoke_entry(entry, args_any);
-                if (status == InvokeStatus::invoked) {
-                    ++result.invoked;
-                } else if (status == InvokeStatus::skipped) {
-                    ++result.skipped;
-                } else {
-                    ++result.type_mismatches;
-                    if (verbose) {
-                        auto& wrapper = entry->callback;
-                        std::ostringstream message;
-                        message
-                            << "Type mismatch, skipping callback"
-                            << "\n             ID: " << wrapper->get_id()
-                            << "\n  expected type: " << wrapper->get_args_type().name()
-                            << "\n    actual type: " << typeid(std::tuple<std::decay_t<Args>...>).name()
-                            << "\n";
-                        log(LogLevel::Debug, message.str());
-                    }
+        Task task = [&bus = target.bus, name = eventName,
+                     payload = std::make_tuple(detail::async_value_t<Args>(std::forward<Args>(args))...)]() {
+            std::apply([&bus, &name](const auto&... values) { (void)bus.publish(name, values...); }, payload);
+        };
+
+        if (current.owner == this) {
+            target.submitted.fetch_add(1);
+            Shard& source = *shards_[current.index];
+            auto& queue = *target.inbound[current.index];
+            while (!queue.try_push(std::move(task))) {
+                if (current.depth >= max_publish_depth) {
+                    // Polling again could nest without end; the inbox takes the event instead.
+                    std::lock_guard<std::mutex> lock(target.inbox_mutex);
+                    target.overflow.push_back(std::move(task));
+                    break;
+                }
+                // Keep our own inbound traffic moving so the target can drain into us.
+                ++current.depth;
+                const std::size_t done = poll(source);
+                --current.depth;
+                if (done == 0) {
+                    detail::cpu_relax();
                 }
             }
-            catch (const std::exception& e) {
-                ++result.failed;
-                std::ostringstream message;
-                message << "Callback exception (ID: " << entry->callback->get_id() << "): " << e.what();
-                log(LogLevel::Error, message.str());
-            }
-            catch (...) {
-                ++result.failed;
-                std::ostringstream message;
-                message << "Callback exception (ID: " << entry->callback->get_id() << "): unknown exception";
-                log(LogLevel::Error, message.str());
+        } else {
+            // Checked under the lock so close() either drains this event or rejects it.
+            std::lock_guard<std::mutex> lock(target.inbox_mutex);
+            if (target.inbox_closed) {
+                return false;
             }
+            target.submitted.fetch_add(1);
+            target.inbox.push_back(std::move(task));
         }
-
-        if (verbose) {
-            std::ostringstream message;
-            message
-                << "Successfully called " << result.invoked << " callbacks"
-                << ", failed " << result.failed
-                << ", mismatched " << result.type_mismatches
-                << ", skipped " << result.skipped
-                << "\n";
-            log(LogLevel::Debug, message.str());
-        }
-
-        return result;
+        wake(target);
+        return true;
     }
 
-    InvokeStatus invoke_entry(const CallbackEntryPtr& entry, const std::any& args_any)
+    /**
+     * Waits until every event published so far, and everything they published
+     * in turn, is dispatched. On a shard thread it dispatches its own inbound
+     * events while waiting.
+     */
+    void drain()
     {
-        if (!try_begin_invocation(*entry)) {
-            return InvokeStatus::skipped;
+        const CurrentShard& current = current_shard();
+        while (true) {
+            // An event finishing on one shard may have published to a shard already checked; an
+            // unchanged submitted total across the pass rules that out.
+            const std::uint64_t before = submitted_total();
+            bool idle = true;
+            for (const auto& shard : shards_) {
+                if (shard->completed.load(std::memory_order_acquire) != shard->submitted.load(std::memory_order_acquire)) {
+                    idle = false;
+                    break;
+                }
+            }
+            idle = idle && submitted_total() == before;
+            if (idle || stopped_.load(std::memory_order_acquire)) {
+                return;
+            }
+            if (current.owner == this) {
+                if (poll(*shards_[current.index]) == 0) {
+                    detail::cpu_relax();
+                }
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
         }
-
-        InvocationGuard invocation_guard(*entry);
-        return entry->callback->try_invoke(args_any)
-            ? InvokeStatus::invoked
-            : InvokeStatus::type_mismatch;
     }
 
-    static bool try_begin_invocation(CallbackEntry& entry)
+    /// Dispatches what is queued, then stops the shard threads and closes the shard buses. Not callable from a subscriber.
+    void close()
     {
-        std::lock_guard<std::mutex> lock(entry.state_mutex);
-        if (!entry.active) {
-            return false;
+        if (closed_.exchange(true, std::memory_order_acq_rel)) {
+            return;
         }
-
-        const auto thread_id = std::this_thread::get_id();
-        auto thread_it = entry.invoking_threads.find(thread_id);
-        if (thread_it == entry.invoking_threads.end()) {
-            entry.invoking_threads.emplace(thread_id, 1);
-        } else {
-            ++thread_it->second;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->inbox_mutex);
+            shard->inbox_closed = true;
+        }
+        drain();
+        stopped_.store(true, std::memory_order_release);
+        for (auto& shard : shards_) {
+            wake(*shard);
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+        for (auto& shard : shards_) {
+            shard->bus.close();
         }
+    }
 
-        ++entry.in_flight;
-        return true;
+    [[nodiscard]] std::vector<ShardStats> getStats() const
+    {
+        std::vector<ShardStats> stats;
+        stats.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            const std::uint64_t submitted = shard->submitted.load(std::memory_order_acquire);
+            const std::uint64_t completed = shard->completed.load(std::memory_order_acquire);
+            stats.push_back(ShardStats{shard->index, shard->local.load(std::memory_order_relaxed),
+                                       shard->remote.load(std::memory_order_relaxed),
+                                       shard->external.load(std::memory_order_relaxed),
+                                       static_cast<std::size_t>(submitted - std::min(submitted, completed))});
+        }
+        return stats;
     }
 
-    static void end_invocation(CallbackEntry& entry) noexcept
+private:
+    using Task = std::function<void()>;
+
+    struct Shard
     {
+        Shard(std::size_t shard_index, std::size_t shard_count, std::size_t queue_capacity)
+            : index(shard_index)
         {
-            std::lock_guard<std::mutex> lock(entry.state_mutex);
-            const auto thread_id = std::this_thread::get_id();
-            auto thread_it = entry.invoking_threads.find(thread_id);
-            if (thread_it != entry.invoking_threads.end()) {
-                if (thread_it->second <= 1) {
-                    entry.invoking_threads.erase(thread_it);
-                } else {
-                    --thread_it->second;
-                }
-            }
-
-            if (entry.in_flight > 0) {
-                --entry.in_flight;
+            inbound.reserve(shard_count);
+            for (std::size_t i = 0; i < shard_count; ++i) {
+                inbound.push_back(std::make_unique<detail::SpscQueue<Task>>(queue_capacity));
             }
         }
-        entry.idle_cv.notify_all();
-    }
 
-    void deactivate_entry(CallbackEntry& entry)
+        const std::size_t index;
+        EventBus bus;
+        std::vector<std::unique_ptr<detail::SpscQueue<Task>>> inbound;     // by source shard
+        std::mutex inbox_mutex;                     // inbox from threads outside the bus
+        std::deque<Task> inbox;
+        bool inbox_closed{false};                   // set by close(); later external publishes fail
+        std::deque<Task> overflow;                  // from shard threads past max_publish_depth, under inbox_mutex
+        std::thread thread;
+
+        std::mutex park_mutex;
+        std::condition_variable park_cv;
+        std::atomic<bool> parked{false};
+
+        std::atomic<std::uint64_t> submitted{0};
+        std::atomic<std::uint64_t> completed{0};
+        std::atomic<std::uint64_t> local{0};
+        std::atomic<std::uint64_t> remote{0};
+        std::atomic<std::uint64_t> external{0};
+    };
+
+    struct CurrentShard
     {
-        std::lock_guard<std::mutex> lock(entry.state_mutex);
-        entry.active = false;
-    }
+        const ShardedEventBus* owner{nullptr};
+        std::size_t index{0};
+        std::size_t depth{0};       // polls nested inside publish() on a full queue
+    };
 
-    static bool is_currently_invoking(const CallbackEntry& entry)
+    static CurrentShard& current_shard() noexcept
     {
-        std::lock_guard<std::mutex> lock(entry.state_mutex);
-        auto thread_it = entry.invoking_threads.find(std::this_thread::get_id());
-        return thread_it != entry.invoking_threads.end() && thread_it->second > 0;
+        thread_local CurrentShard current;
+        return current;
     }
 
-    void wait_for_idle(const CallbackList& entries)
+    /// Sequentially consistent with the parking thread's store of parked and load of submitted.
+    static void wake(Shard& shard)
     {
-        for (const auto& entry : entries) {
-            wait_for_idle(*entry);
+        if (shard.parked.load()) {
+            std::lock_guard<std::mutex> lock(shard.park_mutex);
+            shard.park_cv.notify_one();
         }
     }
 
-    void wait_for_idle(CallbackEntry& entry)
+    static void execute(Shard& shard, Task& task) noexcept
     {
-        if (is_currently_invoking(entry)) {
-            return;
+        try {
+            task();
         }
+        catch (...) {
+        }
+        task = nullptr;
+        shard.completed.fetch_add(1, std::memory_order_release);
+    }
 
-        std::unique_lock<std::mutex> lock(entry.state_mutex);
-        entry.idle_cv.wait(lock, [&entry]() {
-            return entry.in_flight == 0;
-        });
+    [[nodiscard]] std::uint64_t submitted_total() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard->submitted.load(std::memory_order_acquire);
+        }
+        return total;
     }
 
-    void log(LogLevel level, const std::string& message) const noexcept
+    /// One pass over the shard's inbound queues; returns the number of events dispatched.
+    std::size_t poll(Shard& shard)
     {
-        try {
-            LogHandler handler;
-            {
-                std::lock_guard<std::mutex> lock(log_mutex_);
-                handler = log_handler_;
+        std::size_t done = 0;
+        Task task;
+        for (auto& queue : shard.inbound) {
+            for (std::size_t n = 0; n < 64 && queue->try_pop(task); ++n) {
+                shard.remote.fetch_add(1, std::memory_order_relaxed);
+                execute(shard, task);
+                ++done;
             }
+        }
 
-            if (handler) {
-                handler(level, message);
-            }
+        std::deque<Task> overflow;
+        std::deque<Task> external;
+        {
+            std::lock_guard<std::mutex> lock(shard.inbox_mutex);
+            overflow.swap(shard.overflow);
+            external.swap(shard.inbox);
         }
-        catch (...) {
+        for (auto& overflow_task : overflow) {
+            shard.remote.fetch_add(1, std::memory_order_relaxed);
+            execute(shard, overflow_task);
+            ++done;
         }
+        for (auto& external_task : external) {
+            shard.external.fetch_add(1, std::memory_order_relaxed);
+            execute(shard, external_task);
+            ++done;
+        }
+        return done;
     }
 
-    template<typename... Args>
-    std::shared_ptr<ICallbackWrapper> create_wrapper_from_function(callback_id id,
-                                                                   std::function<void(Args...)> func)
+    void run(Shard& shard)
     {
-        return std::make_shared<CallbackWrapper<Args...>>(id, std::move(func));
+        current_shard() = CurrentShard{this, shard.index};
+        std::size_t idle = 0;
+        while (true) {
+            if (poll(shard) != 0) {
+                idle = 0;
+                continue;
+            }
+            if (stopped_.load(std::memory_order_acquire)) {
+                return;
+            }
+            if (++idle < options_.idle_spins) {
+                detail::cpu_relax();
+                continue;
+            }
+
+            // Park; the timeout bounds the latency of a wakeup lost between the check and the wait.
+            std::unique_lock<std::mutex> lock(shard.park_mutex);
+            shard.parked.store(true);
+            if (shard.completed.load(std::memory_order_acquire) == shard.submitted.load() &&
+                !stopped_.load(std::memory_order_acquire)) {
+                shard.park_cv.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            shard.parked.store(false, std::memory_order_release);
+            idle = 0;
+        }
     }
+
+    ShardedOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> stopped_{false};
 };
 
 } // namespace eventbus
+
+template<>
+struct std::hash<eventbus::InternedString>
+{
+    std::size_t operator()(eventbus::InternedString value) const noexcept
+    {
+        return std::hash<const void*>{}(value.c_str());
+    }
+};
@@ -76,6 +76,28 @@ int main()
     assert(observed_view == "Literal message");
     assert(string_view_calls == 2);
 
+    // Interned strings: one stored copy, delivered to string_view / const std::string& without copying.
+    const InternedString symbol("AAPL");
+    assert(symbol == InternedString(std::string("AAPL")));
+    assert(symbol.c_str() == InternedString("AAPL").c_str());
+    assert(symbol != InternedString("MSFT"));
+    assert(InternedString() == InternedString(""));
+    assert(std::hash<InternedString>{}(InternedString()) == std::hash<InternedString>{}(InternedString(std::string())));
+    const char* seen_data = nullptr;
+    const std::string* seen_string = nullptr;
+    std::string copied;
+    InternedString seen_interned;
+    bus.subscribe("quote", [&seen_data](std::string_view text, double) { seen_data = text.data(); });
+    bus.subscribe("quote", [&seen_string](const std::string& text, double) { seen_string = &text; });
+    bus.subscribe("quote", [&copied](std::string text, double) { copied = std::move(text); });
+    bus.subscribe("quote", [&seen_interned](InternedString text, double) { seen_interned = text; });
+    auto interned_result = bus.publish("quote", symbol, 189.5);
+    assert(interned_result.invoked == 4);
+    assert(seen_data == symbol.c_str());
+    assert(seen_string == &symbol.str());
+    assert(copied == "AAPL");
+    assert(seen_interned == symbol);
+
     int zero_arg_calls = 0;
     bus.subscribe("zero_arg", [&zero_arg_calls]() {
         ++zero_arg_calls;
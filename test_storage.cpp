@@ -0,0 +1,2620 @@
+/**
+ * @file test_storage.cpp
+ * @brief Buffer and storage component tests for EventBus
+ */
+
+#include "eventbus.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#if EVENTBUS_HAS_POSIX
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+using namespace eventbus;
+
+void test_page_buffer()
+{
+    PageBuffer normal(1000, HugePagePolicy::disabled);
+    assert(!normal.empty());
+    assert(normal.size() >= 1000);
+    assert(!normal.uses_huge_pages());
+    std::memset(normal.data(), 0x7f, normal.size());
+
+    // Explicit huge pages are usually not reserved; the buffer must still be usable.
+    PageBuffer huge(3 * 1024 * 1024, HugePagePolicy::explicit_preferred);
+    assert(!huge.empty());
+    assert(huge.size() % PageBuffer::huge_page_size == 0);
+    huge.data()[huge.size() - 1] = std::byte{1};
+
+    // Transparent backing is only reported when the kernel mode allows it; residency is measured separately.
+    PageBuffer advised(4 * 1024 * 1024, HugePagePolicy::transparent);
+    std::memset(advised.data(), 1, advised.size());
+#if EVENTBUS_HAS_POSIX
+    // Advised buffers start on a huge-page boundary, so every 2 MiB of them can be backed by THP.
+    assert(reinterpret_cast<std::uintptr_t>(advised.data()) % PageBuffer::huge_page_size == 0);
+    for (int i = 0; i < 8; ++i) {
+        PageBuffer chunk(PageBuffer::huge_page_size, HugePagePolicy::transparent);
+        assert(reinterpret_cast<std::uintptr_t>(chunk.data()) % PageBuffer::huge_page_size == 0);
+        chunk.data()[chunk.size() - 1] = std::byte{1};
+    }
+#endif
+    if (!detail::transparent_huge_pages_enabled()) {
+        assert(advised.backing() != PageBacking::transparent_huge_pages);
+    }
+    assert(advised.huge_page_bytes() <= advised.size());
+    assert(normal.huge_page_bytes() == 0);
+
+    PageBuffer moved(std::move(huge));
+    assert(huge.empty());
+    assert(moved.data()[moved.size() - 1] == std::byte{1});
+
+    BufferArena arena(64 * 1024, HugePagePolicy::disabled);
+    auto* first = static_cast<std::uint64_t*>(arena.allocate(sizeof(std::uint64_t) * 16, 64));
+    assert(reinterpret_cast<std::uintptr_t>(first) % 64 == 0);
+    void* large = arena.allocate(256 * 1024);
+    assert(large != nullptr);
+    assert(arena.reserved_bytes() >= 64 * 1024 + 256 * 1024);
+    arena.reset();
+    assert(arena.reserved_bytes() == 64 * 1024);
+
+    std::cout << "PageBuffer / BufferArena: PASS" << std::endl;
+}
+
+void test_byte_ring()
+{
+    detail::ByteRing ring(100, HugePagePolicy::disabled);
+    // Capacity is a power of two and at least one page.
+    assert(ring.capacity() >= 128);
+    assert((ring.capacity() & (ring.capacity() - 1)) == 0);
+
+    std::vector<std::uint8_t> input(48);
+    std::vector<std::uint8_t> output(48);
+    const int rounds = static_cast<int>(ring.capacity() / input.size()) + 3;
+    for (int round = 0; round < rounds; ++round) {
+        for (std::size_t i = 0; i < input.size(); ++i) {
+            input[i] = static_cast<std::uint8_t>(round * 48 + i);
+        }
+        assert(ring.try_write(input.data(), input.size()));
+        assert(ring.try_read(output.data(), output.size()));
+        assert(input == output);
+    }
+
+    std::size_t written = 0;
+    while (ring.try_write(input.data(), input.size())) {
+        written += input.size();
+    }
+    assert(written > ring.capacity() - input.size());
+
+    auto spans = ring.readable();
+    assert(spans.first.size + spans.second.size == written);
+    assert(spans.second.size > 0);
+    ring.consume(written);
+    assert(ring.size() == 0);
+
+    std::cout << "ByteRing: PASS" << std::endl;
+}
+
+struct Quote
+{
+    int id;
+    double price;
+};
+
+std::string temp_path(const std::string& name)
+{
+    auto path = std::filesystem::temp_directory_path() / ("eventbus_" + name);
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+const char* backend_name(JournalBackend backend)
+{
+    return backend == JournalBackend::io_uring ? "io_uring" : "thread";
+}
+
+void test_journal(JournalBackend backend, const char* label)
+{
+    const std::string path = temp_path(std::string("journal_") + label + ".log");
+    JournalOptions options;
+    options.ring_bytes = 64 * 1024;
+    options.max_batch_bytes = 4096;
+    options.backend = backend;
+
+    const int threads = 4;
+    const int per_thread = 2000;
+    {
+        EventJournal journal(path, options);
+        if (backend == JournalBackend::thread) {
+            assert(journal.backend() == JournalBackend::thread);
+        }
+        std::cout << "Journal backend: " << backend_name(journal.backend()) << std::endl;
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&journal, t]() {
+                for (int i = 0; i < per_thread; ++i) {
+                    journal.append("quotes", Quote{t * per_thread + i, 1.5 * i}, "EVT");
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+
+        assert(journal.sync());
+        auto stats = journal.stats();
+        assert(stats.records == threads * per_thread);
+        assert(stats.syncs >= 1);
+        assert(stats.batches > 1);
+        assert(journal.last_sequence() == threads * per_thread);
+    }
+
+    JournalReader reader(path);
+    JournalRecord record;
+    std::uint64_t expected_sequence = 1;
+    std::vector<bool> seen(threads * per_thread, false);
+    while (reader.next(record)) {
+        assert(record.sequence == expected_sequence++);
+        assert(record.topic == "quotes");
+        auto values = record.decode<Quote, const char*>();
+        assert(values);
+        assert(std::get<1>(*values) == "EVT");
+        seen[std::get<0>(*values).id] = true;
+        assert(!record.decode<int>());
+    }
+    assert(expected_sequence == threads * per_thread + 1);
+    assert(std::find(seen.begin(), seen.end(), false) == seen.end());
+
+    // A torn tail is dropped on reopen and the sequence continues.
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn.write("garbage", 7);
+    }
+    {
+        EventJournal journal(path, options);
+        assert(journal.last_sequence() == threads * per_thread);
+        assert(journal.append("quotes", Quote{-1, 0.0}, "EVT") == threads * per_thread + 1);
+        assert(journal.flush());
+    }
+    JournalReader reopened(path);
+    std::size_t count = 0;
+    while (reopened.next(record)) {
+        ++count;
+    }
+    assert(count == threads * per_thread + 1);
+
+    // A record whose bytes landed corrupt fails its CRC: readers stop there and reopening truncates it.
+    const auto intact_size = std::filesystem::file_size(path);
+    {
+        EventJournal journal(path, options);
+        assert(journal.append("quotes", Quote{-2, 0.0}, "EVT") == threads * per_thread + 2);
+        assert(journal.flush());
+    }
+    {
+        std::fstream corrupt(path, std::ios::binary | std::ios::in | std::ios::out);
+        corrupt.seekp(static_cast<std::streamoff>(std::filesystem::file_size(path) - 2));
+        corrupt.write("XX", 2);
+    }
+    JournalReader checked(path);
+    count = 0;
+    while (checked.next(record)) {
+        ++count;
+    }
+    assert(count == threads * per_thread + 1);
+    {
+        EventJournal journal(path, options);
+        assert(journal.last_sequence() == threads * per_thread + 1);
+    }
+    assert(std::filesystem::file_size(path) == intact_size);
+    std::filesystem::remove(path);
+
+    std::cout << "EventJournal (" << label << "): PASS" << std::endl;
+}
+
+#if EVENTBUS_HAS_POSIX
+/// Runs @p body in a child whose files may not grow past @p limit bytes until it calls the returned lift function.
+template <typename Body>
+void with_file_size_limit(rlim_t limit, Body&& body)
+{
+    const pid_t pid = ::fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit original{};
+        ::getrlimit(RLIMIT_FSIZE, &original);
+        rlimit capped = original;
+        capped.rlim_cur = limit;
+        ::setrlimit(RLIMIT_FSIZE, &capped);
+        body([original]() { ::setrlimit(RLIMIT_FSIZE, &original); });
+        ::_exit(0);
+    }
+    int status = 0;
+    assert(::waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+#endif
+
+void test_journal_write_errors()
+{
+#if EVENTBUS_HAS_POSIX
+    // Failed writes stay queued and are retried; flush() reports the failure it saw, not a lifetime count.
+    const std::string path = temp_path("journal_errors.log");
+    with_file_size_limit(4096, [&path](auto lift) {
+        JournalOptions options;
+        options.truncate = true;
+        options.backend = JournalBackend::thread;
+        EventJournal journal(path, options);
+        for (int i = 0; i < 200; ++i) {
+            journal.append("ticks", i);
+        }
+        assert(!journal.flush());
+        assert(journal.stats().write_errors >= 1);
+        lift();
+        assert(journal.flush());
+        assert(journal.flush());
+    });
+
+    JournalReader reader(path);
+    JournalRecord record;
+    std::uint64_t expected = 1;
+    while (reader.next(record)) {
+        assert(record.sequence == expected);
+        assert(std::get<0>(*record.decode<int>()) == static_cast<int>(expected - 1));
+        ++expected;
+    }
+    assert(expected == 201);
+
+    // The synced prefix only moves on a successful sync; waiters covered by a failed one are told so.
+    with_file_size_limit(4096, [&path](auto lift) {
+        JournalOptions options;
+        options.truncate = true;
+        options.backend = JournalBackend::thread;
+        EventJournal journal(path, options);
+        for (int i = 0; i < 10; ++i) {
+            journal.append("ticks", i);
+        }
+        assert(journal.sync());
+        const JournalCheckpoint before = journal.checkpoint();
+        assert(before.sequence == 10);
+
+        std::uint64_t last = 0;
+        for (int i = 0; i < 200; ++i) {
+            last = journal.append("ticks", i);
+        }
+        assert(!journal.wait_durable(last));
+        assert(journal.synced_sequence() == before.sequence);
+        assert(journal.checkpoint().offset == before.offset);
+        lift();
+        assert(journal.wait_durable(last));
+        assert(journal.synced_sequence() == last);
+    });
+    std::filesystem::remove(path);
+#endif
+    std::cout << "Journal write errors: PASS" << std::endl;
+}
+
+void test_bus_journal()
+{
+    const std::string path = temp_path("bus_journal.log");
+    auto journal = std::make_shared<EventJournal>(path);
+
+    EventBus bus;
+    bus.setJournal(journal);
+    bus.setTopicJournaled("orders");
+
+    int delivered = 0;
+    bus.subscribe("orders", [&delivered](int, const std::string&) { ++delivered; });
+
+    auto result = bus.publish("orders", 7, "buy");
+    assert(result.invoked == 1);
+    assert(result.journaled == 1);
+
+    // Journaled even without subscribers; other topics are not.
+    assert(bus.publish("orders", 8, std::string("sell")).journaled == 1);
+    assert(bus.publish("orders", 10, InternedString("hold")).journaled == 1);
+    assert(bus.publish("other", 9).journaled == 0);
+    assert(journal->flush());
+
+    JournalReader reader(path);
+    JournalRecord record;
+    std::vector<int> ids;
+    while (reader.next(record)) {
+        auto values = record.decode<int, std::string>();
+        assert(values);
+        ids.push_back(std::get<0>(*values));
+    }
+    assert((ids == std::vector<int>{7, 8, 10}));
+    assert(delivered == 3);
+    std::filesystem::remove(path);
+
+    std::cout << "EventBus journaling: PASS" << std::endl;
+}
+
+void test_durable_group_commit()
+{
+    const std::string path = temp_path("durable.log");
+    JournalOptions options;
+    options.group_commit.max_delay = std::chrono::microseconds(2000);
+    options.group_commit.max_waiters = 8;
+    auto journal = std::make_shared<EventJournal>(path, options);
+
+    EventBus bus;
+    bus.setJournal(journal);
+    bus.setTopicDurable("audit");
+
+    std::atomic<int> delivered{0};
+    bus.subscribe("audit", [&delivered](int) { ++delivered; });
+
+    const int threads = 8;
+    const int per_thread = 25;
+    std::atomic<int> durable{0};
+    std::vector<std::thread> publishers;
+    for (int t = 0; t < threads; ++t) {
+        publishers.emplace_back([&bus, &durable, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                auto result = bus.publish("audit", t * per_thread + i);
+                assert(result.journaled == 1);
+                assert(result.durable == 1);
+                durable += static_cast<int>(result.durable);
+            }
+        });
+    }
+    for (auto& publisher : publishers) {
+        publisher.join();
+    }
+
+    auto stats = journal->stats();
+    assert(durable == threads * per_thread);
+    assert(delivered == threads * per_thread);
+    assert(journal->synced_sequence() == threads * per_thread);
+    // Group commit: far fewer fsyncs than durable publishes.
+    assert(stats.syncs < static_cast<std::uint64_t>(threads * per_thread));
+    std::cout << "Durable publishes: " << durable << ", fsyncs: " << stats.syncs << std::endl;
+
+    // Non-serializable payloads cannot be made durable.
+    auto rejected = bus.publish("audit", std::vector<int>{1});
+    assert(rejected.journaled == 0);
+    assert(rejected.durable == 0);
+
+    std::filesystem::remove(path);
+    std::cout << "Durable group commit: PASS" << std::endl;
+}
+
+void test_log_topic()
+{
+    EventBus bus;
+    LogTopicOptions options;
+    options.segment_bytes = 4096;
+    options.retain_segments = 1;
+    options.huge_pages = HugePagePolicy::disabled;
+    auto log = bus.createLogTopic("prices", options);
+    assert(bus.createLogTopic("prices") == log);
+    assert(!bus.openCursor<int>("not_a_log"));
+
+    auto fast = bus.openCursor<int, std::string>("prices", LogStart::earliest);
+    auto slow = bus.openCursor<int, std::string>("prices", LogStart::earliest);
+    assert(fast && slow);
+
+    const int total = 20000;
+    std::atomic<bool> done{false};
+    std::thread producer([&bus, &done]() {
+        for (int i = 0; i < total; ++i) {
+            auto result = bus.publish("prices", i, "EVT");
+            assert(result.logged == 1);
+            assert(result.subscribers == 0);
+        }
+        done = true;
+    });
+
+    // The fast consumer keeps up concurrently; the slow one has not read anything yet.
+    int expected = 0;
+    while (!done.load() || fast->lag() > 0) {
+        fast->poll([&expected](int value, const std::string& symbol) {
+            assert(value == expected);
+            assert(symbol == "EVT");
+            ++expected;
+        });
+    }
+    producer.join();
+    assert(expected == total);
+    assert(fast->lost() == 0);
+
+    // Unconsumed segments are retained for the slow cursor.
+    assert(log->begin_offset() == 0);
+    int slow_expected = 0;
+    std::size_t batches = 0;
+    while (slow->poll([&slow_expected](int value, const std::string&) {
+        assert(value == slow_expected++);
+    }, 1000) > 0) {
+        ++batches;
+    }
+    assert(slow_expected == total);
+    assert(batches == total / 1000);
+
+    // Rewind within the retained range re-delivers records.
+    slow->rewind(10);
+    int rewound = 0;
+    slow->poll([&rewound](int value, const std::string&) {
+        assert(value >= total - 10);
+        ++rewound;
+    });
+    assert(rewound == 10);
+
+    // Consumed segments are released once new segments are rolled.
+    for (int i = 0; i < 1000; ++i) {
+        bus.publish("prices", total + i, "EVT");
+    }
+    fast->poll([](int, const std::string&) {});
+    slow->poll([](int, const std::string&) {});
+    for (int i = 0; i < 1000; ++i) {
+        bus.publish("prices", total + 1000 + i, "EVT");
+    }
+    assert(log->begin_offset() > static_cast<std::uint64_t>(total));
+    assert(log->segment_count() < 16);
+
+    // A mismatched cursor type skips records instead of misreading them.
+    auto wrong = log->open_cursor<double>(LogStart::earliest);
+    assert(wrong.poll([](double) { assert(false); }) == 0);
+    assert(wrong.mismatches() > 0);
+
+    std::cout << "Log topic cursors: PASS" << std::endl;
+}
+
+void test_log_topic_limits_and_files()
+{
+    LogTopicOptions capped;
+    capped.segment_bytes = 4096;
+    capped.max_segments = 2;
+    capped.huge_pages = HugePagePolicy::disabled;
+    auto log = std::make_shared<EventLog>("capped", capped);
+    auto lagging = log->open_cursor<std::uint64_t>(LogStart::earliest);
+    for (std::uint64_t i = 0; i < 5000; ++i) {
+        log->append(i);
+    }
+    std::uint64_t first = 0;
+    bool seen_first = false;
+    lagging.poll([&first, &seen_first](std::uint64_t value) {
+        if (!seen_first) {
+            first = value;
+            seen_first = true;
+        }
+    });
+    assert(log->segment_count() == 2);
+    assert(lagging.lost() == first);
+    assert(lagging.lost() > 0);
+    assert(lagging.position() == 5000);
+
+    const auto directory = std::filesystem::temp_directory_path() / "eventbus_log_segments";
+    std::filesystem::remove_all(directory);
+    LogTopicOptions mapped;
+    mapped.segment_bytes = 16384;
+    mapped.directory = directory.string();
+    {
+        auto file_log = std::make_shared<EventLog>("orders/eu", mapped);
+        for (int i = 0; i < 1000; ++i) {
+            file_log->append(i, "order");
+        }
+        assert(file_log->segment_count() > 1);
+    }
+    {
+        auto reopened = std::make_shared<EventLog>("orders/eu", mapped);
+        assert(reopened->end_offset() == 1000);
+        assert(reopened->append(1000, "order") == 1000);
+        auto cursor = reopened->open_cursor<int, std::string>(LogStart::earliest);
+        int next = 0;
+        cursor.poll([&next](int value, const std::string& text) {
+            assert(value == next++);
+            assert(text == "order");
+        });
+        assert(next == 1001);
+    }
+    std::filesystem::remove_all(directory);
+
+    std::cout << "Log topic retention / mmap segments: PASS" << std::endl;
+}
+
+void test_log_spill()
+{
+    const auto spill_directory = std::filesystem::temp_directory_path() / "eventbus_spill";
+    std::filesystem::remove_all(spill_directory);
+    std::filesystem::create_directories(spill_directory);
+
+    LogTopicOptions options;
+    options.segment_bytes = 64 * 1024;
+    options.huge_pages = HugePagePolicy::disabled;
+    options.memory_budget_bytes = 4 * 64 * 1024;
+    options.spill_directory = spill_directory.string();
+
+    EventBus bus;
+    auto log = bus.createLogTopic("downstream", options);
+    auto stalled = bus.openCursor<int, std::string>("downstream", LogStart::earliest);
+    auto live = bus.openCursor<int, std::string>("downstream", LogStart::earliest);
+
+    // The downstream consumer is stalled: the queue grows far beyond the budget.
+    const int total = 50000;
+    const std::string payload(40, 'x');
+    for (int i = 0; i < total; ++i) {
+        bus.publish("downstream", i, payload);
+        if (i % 1000 == 0) {
+            live->poll([](int, const std::string&) {});
+        }
+    }
+
+    // Spilling runs on a background thread; wait for it to catch up with the budget.
+    auto spill_files = [&spill_directory]() {
+        return static_cast<std::size_t>(std::distance(std::filesystem::directory_iterator(spill_directory),
+                                                      std::filesystem::directory_iterator{}));
+    };
+    auto stats = log->stats();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((stats.resident_bytes > options.memory_budget_bytes + 2 * options.segment_bytes ||
+            spill_files() != stats.spilled_segments) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        stats = log->stats();
+    }
+    assert(stats.spilled_segments > 0);
+    assert(stats.spill_failures == 0);
+    assert(stats.resident_bytes <= options.memory_budget_bytes + 2 * options.segment_bytes);
+    assert(spill_files() == stats.spilled_segments);
+
+    // Catching up streams spilled segments back in order.
+    int expected = 0;
+    stalled->poll([&expected, &payload](int value, const std::string& text) {
+        assert(value == expected++);
+        assert(text == payload);
+    });
+    assert(expected == total);
+    assert(stalled->lost() == 0);
+    live->poll([](int, const std::string&) {});
+
+    // Consumed spilled segments are released along with their files.
+    for (int i = 0; i < 5000; ++i) {
+        bus.publish("downstream", total + i, payload);
+    }
+    stalled.reset();
+    live.reset();
+    for (int i = 0; i < 5000; ++i) {
+        bus.publish("downstream", total + 5000 + i, payload);
+    }
+    assert(log->stats().spilled_segments < stats.spilled_segments);
+    std::cout << "Spilled segments: " << stats.spilled_segments << ", bytes: " << stats.spilled_bytes << std::endl;
+
+    bus.close();
+    log.reset();
+    std::filesystem::remove_all(spill_directory);
+    std::cout << "Log spill-to-disk: PASS" << std::endl;
+}
+
+void test_compacted_state()
+{
+    const std::string path = temp_path("state.snapshot");
+    CompactionOptions options;
+    options.snapshot_path = path;
+    options.snapshot_interval = std::chrono::milliseconds(20);
+
+    {
+        EventBus bus;
+        auto store = bus.enableCompaction("prices", options);
+        assert(bus.enableCompaction("prices") == store);
+
+        for (int round = 0; round < 100; ++round) {
+            for (int id = 0; id < 10; ++id) {
+                auto result = bus.publish("prices", std::string("sym") + std::to_string(id), round * 1.0);
+                assert(result.compacted == 1);
+            }
+        }
+        assert(store->size() == 10);
+        auto latest = store->get<std::string, double>("sym3");
+        assert(latest && std::get<1>(*latest) == 99.0);
+
+        // A late subscriber sees one value per key, then live updates.
+        std::vector<std::pair<std::string, double>> seen;
+        bus.subscribeWithState("prices", [&seen](const std::string& symbol, double price) {
+            seen.emplace_back(symbol, price);
+        });
+        assert(seen.size() == 10);
+        for (const auto& [symbol, price] : seen) {
+            assert(price == 99.0);
+        }
+        bus.publish("prices", std::string("sym0"), 100.0);
+        assert(seen.size() == 11 && seen.back().second == 100.0);
+
+        // Mismatched subscribers get no replay.
+        int mismatched = 0;
+        bus.subscribeWithState("prices", [&mismatched](int, int) { ++mismatched; });
+        assert(mismatched == 0);
+
+        // The periodic snapshot catches up without a close().
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!std::filesystem::exists(path) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        assert(std::filesystem::exists(path));
+
+        bus.publish("prices", std::string("sym1"), -1.0);
+    }
+
+    // A restarted service restores state from the snapshot written on close.
+    EventBus restarted;
+    auto restored = restarted.enableCompaction("prices", options);
+    assert(restored->size() == 10);
+    std::vector<double> prices(10, 0.0);
+    restarted.subscribeWithState("prices", [&prices](const std::string& symbol, double price) {
+        prices[static_cast<std::size_t>(std::stoi(symbol.substr(3)))] = price;
+    });
+    assert(prices[0] == 100.0);
+    assert(prices[1] == -1.0);
+    assert(prices[9] == 99.0);
+
+    // A torn snapshot is rejected and leaves the store untouched.
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::trunc);
+        torn << "EBKV";
+    }
+    CompactedStore scratch("scratch");
+    scratch.put(std::string("k"), 1.0);
+    assert(!scratch.load(path));
+    assert(scratch.size() == 1);
+
+    restarted.close();
+    std::filesystem::remove(path);
+    std::cout << "Compacted state: PASS" << std::endl;
+}
+
+void test_timer_queue()
+{
+    detail::TimerQueue timers;
+    std::atomic<int> ticks{0};
+    std::atomic<int> once{0};
+    const auto id = timers.schedule_every(std::chrono::milliseconds(1), [&ticks]() { ++ticks; });
+    timers.schedule(std::chrono::milliseconds(2), std::chrono::milliseconds(0), [&once]() { ++once; });
+
+    while (ticks.load() < 5 || once.load() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    timers.cancel(id);
+    const int after_cancel = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(ticks.load() == after_cancel);
+    assert(once.load() == 1);
+    std::cout << "Timer queue: PASS" << std::endl;
+}
+
+void test_bus_snapshot()
+{
+    const std::string journal_path = temp_path("snapshot.journal");
+    const std::string snapshot_path = temp_path("bus.snapshot");
+
+    JournalOptions journal_options;
+    journal_options.ring_bytes = 1 << 20;
+    journal_options.huge_pages = HugePagePolicy::disabled;
+    journal_options.backend = JournalBackend::thread;
+    journal_options.delta_encoding = true;
+    journal_options.keyframe_interval = 16;
+
+    LogTopicOptions log_options;
+    log_options.segment_bytes = 64 * 1024;
+    log_options.retain_segments = 2;
+    log_options.huge_pages = HugePagePolicy::disabled;
+
+    std::uint64_t last_sequence = 0;
+    {
+        EventBus bus;
+        bus.setJournal(std::make_shared<EventJournal>(journal_path, journal_options));
+        bus.setTopicDurable("orders");
+        bus.setTopicJournaled("audit");
+        bus.createLogTopic("ticks", log_options);
+        bus.enableCompaction("prices");
+
+        for (int i = 0; i < 100; ++i) {
+            bus.publish("orders", i);
+            bus.publish("prices", i % 7, i * 0.5);
+        }
+        last_sequence = bus.getJournal()->last_sequence();
+        assert(bus.saveSnapshot(snapshot_path));
+    }
+
+    EventBus restarted;
+    assert(!restarted.loadSnapshot(snapshot_path + ".missing"));
+    assert(restarted.loadSnapshot(snapshot_path));
+
+    auto journal = restarted.getJournal();
+    assert(journal && journal->path() == journal_path);
+    assert(journal->last_sequence() == last_sequence);
+    assert(journal->checkpoint().sequence == last_sequence);
+    assert(journal->options().delta_encoding && journal->options().keyframe_interval == 16);
+
+    auto log = restarted.getLogTopic("ticks");
+    assert(log && log->options().segment_bytes == log_options.segment_bytes);
+    assert(log->options().retain_segments == 2);
+
+    auto store = restarted.getCompactedStore("prices");
+    assert(store && store->size() == 7);
+    auto value = store->get<int, double>(6);
+    assert(value && std::get<1>(*value) == 97 * 0.5);
+
+    auto result = restarted.publish("orders", 100);
+    assert(result.journaled == 1 && result.durable == 1);
+    assert(journal->last_sequence() == last_sequence + 1);
+    assert(restarted.publish("audit", std::string("x")).journaled == 1);
+
+    // Records appended after the snapshot are still found when reopening from it.
+    restarted.close();
+    journal.reset();
+    EventBus again;
+    assert(again.loadSnapshot(snapshot_path));
+    assert(again.getJournal()->last_sequence() == last_sequence + 2);
+
+    // A truncated snapshot is rejected as a whole.
+    std::filesystem::resize_file(snapshot_path, std::filesystem::file_size(snapshot_path) / 2);
+    EventBus torn;
+    assert(!torn.loadSnapshot(snapshot_path));
+    assert(!torn.getJournal() && !torn.getCompactedStore("prices"));
+
+    again.close();
+    std::filesystem::remove(journal_path);
+    std::filesystem::remove(snapshot_path);
+    std::cout << "Bus snapshot: PASS" << std::endl;
+}
+
+#if EVENTBUS_HAS_POSIX
+void test_shared_ring()
+{
+    const std::string name = "test_ring." + std::to_string(::getpid());
+    SharedRingOptions options;
+    options.slot_count = 1 << 12;
+    options.slot_bytes = 64;
+    auto ring = SharedRing::open(name, options);
+    assert(ring->slot_count() == 4096);
+
+    // Several producer processes share the ring; one consumer follows along.
+    constexpr int producers = 3;
+    constexpr int per_producer = 20000;
+    auto cursor = ring->open_cursor<int, int>(LogStart::earliest);
+    std::vector<pid_t> children;
+    for (int p = 0; p < producers; ++p) {
+        const pid_t pid = ::fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+            auto producer = SharedRing::open(name);
+            for (int i = 0; i < per_producer; ++i) {
+                (void)producer->publish(p, i);
+            }
+            ::_exit(0);
+        }
+        children.push_back(pid);
+    }
+
+    std::vector<int> next(producers, 0);
+    std::uint64_t out_of_order = 0;
+    auto consume = [&](int producer, int value) {
+        out_of_order += value < next[static_cast<std::size_t>(producer)] ? 1 : 0;
+        next[static_cast<std::size_t>(producer)] = value + 1;
+    };
+    int exited = 0;
+    while (exited < producers) {
+        cursor.poll(consume);
+        int status = 0;
+        if (::waitpid(-1, &status, WNOHANG) > 0) {
+            assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+            ++exited;
+        }
+    }
+    cursor.poll(consume);
+
+    auto stats = cursor.stats();
+    const auto ring_stats = ring->stats();
+    assert(out_of_order == 0);
+    assert(stats.gaps == 0 && stats.mismatches == 0 && stats.lag == 0);
+    assert(ring_stats.published + ring_stats.abandoned == std::uint64_t{producers} * per_producer);
+    assert(stats.received + stats.lost == ring->last_sequence());
+    std::cout << "Shared ring: received " << stats.received << ", lost " << stats.lost << std::endl;
+
+    // A cursor that falls a full lap behind reports the overrun.
+    SharedRingOptions impatient_options;
+    impatient_options.gap_timeout = std::chrono::milliseconds(1);
+    auto impatient = SharedRing::open(name, impatient_options);
+    assert(impatient->slot_count() == ring->slot_count());
+    auto slow = impatient->open_cursor<int, int>();
+    for (int i = 0; i < 10000; ++i) {
+        (void)ring->publish(9, i);
+    }
+    int first = -1;
+    assert(slow.poll([&first](int, int value) { if (first < 0) first = value; }) == 4096);
+    assert(slow.stats().lost == 10000 - 4096);
+    assert(first == 10000 - 4096);
+
+    // A producer that claims a sequence and dies leaves a gap the consumer skips after gap_timeout.
+    {
+        const int fd = ::shm_open(("/eventbus." + name).c_str(), O_RDWR, 0600);
+        assert(fd >= 0);
+        void* memory = ::mmap(nullptr, sizeof(detail::SharedRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        assert(memory != MAP_FAILED);
+        static_cast<detail::SharedRingHeader*>(memory)->claimed.fetch_add(1);
+        ::munmap(memory, sizeof(detail::SharedRingHeader));
+        ::close(fd);
+    }
+    assert(ring->publish(9, 10000));
+    assert(slow.poll([](int, int) {}) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    int after_gap = -1;
+    assert(slow.poll([&after_gap](int, int value) { after_gap = value; }) == 1);
+    assert(after_gap == 10000);
+    assert(slow.stats().gaps == 1);
+
+    // A slot torn by a lapped producer still writing after the takeover fails its CRC and is dropped.
+    assert(ring->publish(9, 10001));
+    assert(ring->publish(9, 10002));
+    {
+        const int fd = ::shm_open(("/eventbus." + name).c_str(), O_RDWR, 0600);
+        assert(fd >= 0);
+        struct stat info {};
+        assert(::fstat(fd, &info) == 0);
+        void* memory = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, 0);
+        assert(memory != MAP_FAILED);
+        const auto* header = static_cast<detail::SharedRingHeader*>(memory);
+        const std::uint64_t torn = ring->last_sequence() - 1;
+        auto* slot = static_cast<std::byte*>(memory) + sizeof(detail::SharedRingHeader) +
+                     (torn & (header->slot_count - 1)) * header->slot_stride;
+        slot[sizeof(detail::SharedSlotHeader) + 4] ^= std::byte{0xff};
+        ::munmap(memory, static_cast<std::size_t>(info.st_size));
+        ::close(fd);
+    }
+    const std::uint64_t lost_before = slow.stats().lost;
+    int after_torn = -1;
+    assert(slow.poll([&after_torn](int, int value) { after_torn = value; }) == 1);
+    assert(after_torn == 10002);
+    assert(slow.stats().lost == lost_before + 1);
+
+    // Bus topics forward into the ring.
+    EventBus bus;
+    bus.setTopicSharedRing("ticks", ring);
+    auto remote = ring->open_cursor<std::string>();
+    assert(bus.publish("ticks", "hello").shared == 1);
+    std::string text;
+    assert(remote.poll([&text](const std::string& value) { text = value; }) == 1);
+    assert(text == "hello");
+
+    bool oversized = false;
+    try {
+        (void)ring->publish(std::string(100, 'x'));
+    }
+    catch (const std::length_error&) {
+        oversized = true;
+    }
+    assert(oversized);
+
+    assert(SharedRing::remove(name));
+    std::cout << "Shared-memory ring: PASS" << std::endl;
+}
+#endif
+
+struct Book
+{
+    int symbol;
+    double bid;
+    double ask;
+    double last;
+    std::int64_t volume;
+    std::int64_t timestamp;
+};
+
+void test_delta_journal()
+{
+    const std::string path = temp_path("delta.journal");
+    JournalOptions options;
+    options.ring_bytes = 1 << 20;
+    options.huge_pages = HugePagePolicy::disabled;
+    options.delta_encoding = true;
+    options.keyframe_interval = 16;
+
+    std::vector<Book> sent;
+    {
+        EventJournal journal(path, options);
+        Book book{0, 10.0, 10.5, 10.25, 0, 0};
+        for (int i = 0; i < 1000; ++i) {
+            book.symbol = i % 10;
+            book.bid += (i % 3 == 0) ? 0.01 : 0.0;
+            book.timestamp = i;
+            sent.push_back(book);
+            journal.append("books", book.symbol, book);
+            if (i % 100 == 0) {
+                journal.append("books", std::string("halt"), i);  // other key type in the same topic
+            }
+        }
+        journal.append("trades", 1, std::string("short"));
+        journal.append("trades", 1, std::string("a longer text"));
+        assert(journal.sync());
+
+        const auto stats = journal.stats();
+        assert(stats.delta_records > 800);
+        assert(stats.delta_bytes_saved > stats.delta_records * 16);
+    }
+
+    JournalReader reader(path);
+    JournalRecord record;
+    std::size_t books = 0;
+    std::size_t halts = 0;
+    std::vector<std::string> trades;
+    while (reader.next(record)) {
+        if (auto book = record.decode<int, Book>()) {
+            const Book& expected = sent[books++];
+            const Book& actual = std::get<1>(*book);
+            assert(std::get<0>(*book) == expected.symbol);
+            assert(std::memcmp(&actual, &expected, sizeof(Book)) == 0);
+        } else if (auto halt = record.decode<std::string, int>()) {
+            assert(std::get<0>(*halt) == "halt");
+            ++halts;
+        } else if (auto trade = record.decode<int, std::string>()) {
+            trades.push_back(std::get<1>(*trade));
+        } else {
+            assert(false);
+        }
+    }
+    assert(books == sent.size());
+    assert(halts == 10);
+    assert(trades.size() == 2 && trades[1] == "a longer text");
+
+    // Frames decode independently of the journal as well.
+    DeltaEncoder encoder(4);
+    DeltaDecoder decoder;
+    std::vector<std::byte> frame;
+    std::vector<std::byte> decoded;
+    std::vector<std::byte> payload(40, std::byte{1});
+    std::size_t deltas = 0;
+    for (int i = 0; i < 8; ++i) {
+        payload[static_cast<std::size_t>(i)] = std::byte{static_cast<unsigned char>(i)};
+        frame.clear();
+        const bool delta = encoder.encode("k", 7, payload.data(), payload.size(), frame);
+        deltas += delta ? 1 : 0;
+        assert(decoder.decode(delta, 7, frame.data(), frame.size(), decoded));
+        assert(decoded == payload);
+    }
+    assert(deltas == 6);  // keyframes at 0 and 4
+
+    // A delta whose keyframe was never seen is rejected.
+    DeltaDecoder fresh;
+    frame.clear();
+    assert(!encoder.encode("k", 7, payload.data(), payload.size(), frame));
+    frame.clear();
+    assert(encoder.encode("k", 7, payload.data(), payload.size(), frame));
+    assert(!fresh.decode(true, 7, frame.data(), frame.size(), decoded));
+
+    // A frame prepared but never written does not become the base of the next delta.
+    DeltaDecoder follower;
+    std::vector<std::byte> base(40, std::byte{1});
+    frame.clear();
+    DeltaEncoder staged(16);
+    assert(!staged.encode("s", 7, base.data(), base.size(), frame));
+    assert(follower.decode(false, 7, frame.data(), frame.size(), decoded));
+    std::vector<std::byte> dropped(40, std::byte{9});
+    frame.clear();
+    (void)staged.prepare("s", 7, dropped.data(), dropped.size(), frame);
+    std::vector<std::byte> next = base;
+    next[3] = std::byte{4};
+    frame.clear();
+    assert(staged.encode("s", 7, next.data(), next.size(), frame));
+    assert(follower.decode(true, 7, frame.data(), frame.size(), decoded) && decoded == next);
+
+    // The same through the journal: a record too large for the ring leaves the key's base untouched.
+    {
+        const std::string notes_path = temp_path("delta-notes.journal");
+        JournalOptions small = options;
+        small.ring_bytes = 64 * 1024;
+        {
+            EventJournal journal(notes_path, small);
+            journal.append("notes", 1, std::string(64, 'a'));
+            bool threw = false;
+            try {
+                journal.append("notes", 1, std::string(256 * 1024, 'b'));
+            }
+            catch (const std::length_error&) {
+                threw = true;
+            }
+            assert(threw);
+            std::string edited(64, 'a');
+            edited[10] = 'c';
+            journal.append("notes", 1, edited);
+            assert(journal.sync());
+            assert(journal.stats().delta_records == 1);
+        }
+        JournalReader notes(notes_path);
+        std::vector<std::string> texts;
+        while (notes.next(record)) {
+            auto note = record.decode<int, std::string>();
+            assert(note);
+            texts.push_back(std::get<1>(*note));
+        }
+        std::string edited(64, 'a');
+        edited[10] = 'c';
+        assert(texts.size() == 2 && texts[0] == std::string(64, 'a') && texts[1] == edited);
+        std::filesystem::remove(notes_path);
+    }
+
+    std::filesystem::remove(path);
+    std::cout << "Delta-encoded journal: PASS" << std::endl;
+}
+
+void test_hot_topics()
+{
+    HeavyHitterOptions options;
+    options.width = 1024;
+    options.top_k = 8;
+    options.decay_interval = std::chrono::milliseconds(0);
+
+    // A few hot topics among many cold ones; estimates never undercount.
+    HeavyHitterTracker tracker(options);
+    const std::size_t memory = tracker.memory_bytes();
+    const std::pair<const char*, int> hot[] = {{"hot0", 5000}, {"hot1", 3000}, {"hot2", 2000}};
+    for (int round = 0; round < 1000; ++round) {
+        for (const auto& topic : hot) {
+            for (int i = 0; i < topic.second / 1000; ++i) {
+                tracker.record(topic.first, 10);
+            }
+        }
+        tracker.record("cold" + std::to_string(round * 7 % 5000), 1);
+        tracker.record("cold" + std::to_string(round * 13 % 5000), 1);
+    }
+    tracker.flush();
+    auto top = tracker.top(3);
+    assert(top.size() == 3);
+    for (std::size_t i = 0; i < top.size(); ++i) {
+        assert(top[i].name == hot[i].first);
+        assert(top[i].publishes >= static_cast<std::uint64_t>(hot[i].second));
+        assert(top[i].publishes < static_cast<std::uint64_t>(hot[i].second) + 100);
+    }
+    assert(tracker.top(100).size() <= options.top_k);
+    assert(tracker.memory_bytes() == memory);
+
+    tracker.decay();
+    assert(tracker.estimate("hot0").publishes >= 2500);
+    assert(tracker.estimate("hot0").publishes < 2600);
+
+    // Thread-local buffers are flushed when their threads exit.
+    HeavyHitterTracker shared(options);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared]() {
+            for (int i = 0; i < 1001; ++i) {
+                shared.record("shared", 1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(shared.estimate("shared").publishes == 4004);
+    assert(shared.estimate("shared").callback_ns == 4004);
+
+    // The bus ranks by publish count and by time spent in callbacks.
+    EventBus bus;
+    assert(bus.getHotTopics(5).empty());
+    HeavyHitterTracker& bus_tracker = bus.enableHotTopics(options);
+    assert(&bus.enableHotTopics() == &bus_tracker);
+    bus.subscribe("fast", [](int) {});
+    bus.subscribe("slow", [](int) { std::this_thread::sleep_for(std::chrono::microseconds(500)); });
+    for (int i = 0; i < 200; ++i) {
+        bus.publish("fast", i);
+        if (i % 20 == 0) {
+            bus.publish("slow", i);
+        }
+    }
+    assert(bus.publish_if_min_subscribers("fast", 1, 0));
+    auto by_rate = bus.getHotTopics(2);
+    assert(by_rate.size() == 2);
+    assert(by_rate[0].name == "fast" && by_rate[0].publishes >= 201);
+    assert(by_rate[1].name == "slow" && by_rate[1].publishes >= 10);
+    auto by_time = bus.getHotTopics(1, HotTopicOrder::callback_time);
+    assert(by_time.size() == 1);
+    assert(by_time[0].name == "slow");
+    assert(by_time[0].callback_ns >= 10 * 500000ULL);
+
+    std::cout << "Hot topics: PASS" << std::endl;
+}
+
+void test_fast_path()
+{
+    EventBus bus;
+    FastPathOptions options;
+    options.slots = 16;
+    options.promote = 4;
+    options.refresh_interval = std::chrono::milliseconds(0);
+    bus.enableFastPath(options);
+
+    std::atomic<int> ticks{0};
+    const auto id = bus.subscribe("tick", [&ticks](int) { ++ticks; });
+    for (int i = 0; i < 100; ++i) {
+        bus.publish("tick", i);
+    }
+    bus.publish("cold", 1);
+    assert(bus.getFastPathStats().promoted == 0);
+
+    bus.refreshFastPath();
+    auto stats = bus.getFastPathStats();
+    assert(stats.slots == 16);
+    assert(stats.promoted >= 1);
+    for (int i = 0; i < 10; ++i) {
+        assert(bus.publish("tick", i).invoked == 1);
+    }
+    assert(bus.getFastPathStats().hits == 10);
+
+    // Subscribing to a topic in another slot leaves the promoted snapshot valid.
+    std::string other = "other";
+    while ((std::hash<std::string>{}(other) & 15) == (std::hash<std::string>{}("tick") & 15)) {
+        other += "+";
+    }
+    const auto other_id = bus.subscribe(other, [](int) {});
+    assert(bus.publish("tick", 0).invoked == 1);
+    assert(bus.getFastPathStats().hits == 11);
+    assert(bus.unsubscribe(other, other_id));
+
+    // Registry changes invalidate promoted snapshots; the next publish re-resolves.
+    int extra = 0;
+    const auto extra_id = bus.subscribe("tick", [&extra](int) { ++extra; });
+    assert(bus.publish("tick", 0).invoked == 2);
+    assert(bus.publish("tick", 0).invoked == 2);
+    assert(extra == 2);
+    assert(bus.unsubscribe("tick", extra_id));
+    assert(bus.publish("tick", 0).invoked == 1);
+    assert(extra == 2);
+    bus.setTopicJournaled("tick");
+    assert(bus.publish("tick", 0).journaled == 0);     // no journal configured
+    assert(bus.publish_if_min_subscribers("tick", 1, 0));
+    assert(!bus.publish_if_min_subscribers("tick", 2, 0));
+
+    // Concurrent publishers see every subscription change.
+    const int publishers = 4;
+    const int per_thread = 5000;
+    const int before = ticks.load();
+    std::atomic<bool> done{false};
+    std::thread churn([&bus, &done]() {
+        while (!done.load()) {
+            const auto churn_id = bus.subscribe("tick", [](int) {});
+            (void)bus.unsubscribe("tick", churn_id);
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int t = 0; t < publishers; ++t) {
+        threads.emplace_back([&bus]() {
+            for (int i = 0; i < per_thread; ++i) {
+                bus.publish("tick", i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    done = true;
+    churn.join();
+    assert(ticks.load() == before + publishers * per_thread);
+    assert(bus.unsubscribe("tick", id));
+    assert(bus.publish("tick", 0).invoked == 0);
+
+    bus.close();
+    assert(bus.getFastPathStats().promoted == 0);
+    assert(bus.publish("tick", 0).subscribers == 0);
+
+    std::cout << "Fast-path slots: PASS" << std::endl;
+}
+
+void test_rate_limits()
+{
+    EventBus bus;
+    int received = 0;
+    bus.subscribe("telemetry.cpu", [&received](int) { ++received; });
+    bus.subscribe("telemetry.disk", [&received](int) { ++received; });
+    bus.subscribe("orders", [&received](int) { ++received; });
+
+    // Reject: a prefix limit shares one bucket across the matching topics.
+    RateLimit reject;
+    reject.rate = 1.0;
+    reject.burst = 10.0;
+    bus.setRateLimit("telemetry.*", reject);
+    std::size_t throttled = 0;
+    for (int i = 0; i < 10; ++i) {
+        throttled += bus.publish(i % 2 == 0 ? "telemetry.cpu" : "telemetry.disk", i).throttled;
+    }
+    assert(throttled == 0 && received == 10);
+    auto result = bus.publish("telemetry.cpu", 0);
+    assert(result.throttled == 1 && result.invoked == 0);
+    assert(bus.publish("telemetry.disk", 0).throttled == 1);
+    assert(!bus.publish_if_min_subscribers("telemetry.cpu", 1, 0));
+    assert(bus.publish("orders", 0).invoked == 1);
+    assert(bus.getRateLimitStats("telemetry.*")->throttled == 3);
+    assert(!bus.getRateLimitStats("orders"));
+
+    // An exact limit overrides the prefix; clearing it restores the prefix.
+    RateLimit generous;
+    generous.rate = 1e6;
+    generous.burst = 1e6;
+    bus.setRateLimit("telemetry.cpu", generous);
+    assert(bus.publish("telemetry.cpu", 0).invoked == 1);
+    assert(bus.publish("telemetry.disk", 0).throttled == 1);
+    assert(bus.clearRateLimit("telemetry.cpu"));
+    assert(!bus.clearRateLimit("telemetry.cpu"));
+    assert(bus.publish("telemetry.cpu", 0).throttled == 1);
+
+    // Sample: one excess event in sample_every gets through.
+    RateLimit sample;
+    sample.rate = 1.0;
+    sample.burst = 1.0;
+    sample.policy = ThrottlePolicy::sample;
+    sample.sample_every = 5;
+    bus.setRateLimit("orders", sample);
+    received = 0;
+    throttled = 0;
+    for (int i = 0; i < 21; ++i) {
+        throttled += bus.publish("orders", i).throttled;
+    }
+    assert(received == 5 && throttled == 16);
+    assert(bus.getRateLimitStats("orders")->sampled == 4);
+
+    // Delay: publishers wait for a token, up to max_delay.
+    RateLimit delay;
+    delay.rate = 1000.0;
+    delay.burst = 1.0;
+    delay.policy = ThrottlePolicy::delay;
+    delay.max_delay = std::chrono::microseconds(50000);
+    bus.setRateLimit("orders", delay);
+    received = 0;
+    std::size_t delayed = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 21; ++i) {
+        delayed += bus.publish("orders", i).delayed;
+    }
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(19));
+    assert(received == 21 && delayed >= 1);
+    delay.rate = 1.0;
+    delay.max_delay = std::chrono::microseconds(1000);
+    bus.setRateLimit("orders", delay);
+    assert(bus.publish("orders", 0).delayed == 0);
+    assert(bus.publish("orders", 0).throttled == 1);
+
+    // Per-thread buckets: each publisher gets its own burst.
+    RateLimit per_thread;
+    per_thread.rate = 1.0;
+    per_thread.burst = 5.0;
+    per_thread.per_thread = true;
+    bus.setRateLimit("telemetry.*", per_thread);
+    std::atomic<int> accepted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&bus, &accepted]() {
+            for (int i = 0; i < 20; ++i) {
+                if (bus.publish("telemetry.cpu", i).throttled == 0) {
+                    ++accepted;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(accepted.load() == 4 * 5);
+
+    // Buckets of exited threads are pruned once full again, so short-lived publishers do not pile up.
+    RateLimit fast;
+    fast.rate = 1e6;
+    fast.per_thread = true;
+    bus.setRateLimit("churn", fast);
+    for (int t = 0; t < 500; ++t) {
+        std::thread([&bus]() { assert(bus.publish("churn", 0).throttled == 0); }).join();
+    }
+    assert(bus.getRateLimitStats("churn")->thread_buckets < 130);
+
+    std::cout << "Rate limits: PASS" << std::endl;
+}
+
+void test_async_shedding()
+{
+    {
+        EventBus bus;
+        assert(!bus.publishAsync("early", 1));
+    }
+
+    // Async delivery copies character pointers and runs subscribers on workers.
+    {
+        EventBus bus;
+        bus.enableAsync();
+        std::atomic<int> delivered{0};
+        std::atomic<bool> off_thread{true};
+        const auto publisher = std::this_thread::get_id();
+        bus.subscribe("greet", [&](const std::string& name, int n) {
+            if (name == "bob" && n == 7) {
+                ++delivered;
+            }
+            if (std::this_thread::get_id() == publisher) {
+                off_thread = false;
+            }
+        });
+        for (int i = 0; i < 100; ++i) {
+            std::string name = "bob";
+            assert(bus.publishAsync("greet", name.c_str(), 7));
+        }
+        bus.close();
+        assert(delivered.load() == 100);
+        assert(off_thread.load());
+        assert(!bus.publishAsync("greet", "bob", 7));
+        auto stats = bus.getAsyncStats();
+        assert(stats.executed == 100 && stats.shed == 0 && stats.queued == 0);
+    }
+
+    // Standing queue delay sheds the lowest-priority class first, never the highest.
+    EventBus bus;
+    AsyncOptions options;
+    options.workers = 1;
+    options.target_delay = std::chrono::microseconds(1000);
+    options.interval = std::chrono::milliseconds(5);
+    options.default_priority = 5;
+    bus.enableAsync(options);
+    bus.setTopicClass("bulk.*", TopicClass{"bulk", 0});
+    bus.setTopicClass("critical.*", TopicClass{"critical", 10});
+
+    std::atomic<int> bulk{0};
+    std::atomic<int> critical{0};
+    auto slow = [](std::atomic<int>& counter) {
+        return [&counter](int) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            ++counter;
+        };
+    };
+    bus.subscribe("bulk.reindex", slow(bulk));
+    bus.subscribe("critical.trade", slow(critical));
+
+    const int per_class = 300;
+    std::size_t rejected = 0;
+    for (int i = 0; i < per_class; ++i) {
+        rejected += bus.publishAsync("bulk.reindex", i) ? 0 : 1;
+        assert(bus.publishAsync("critical.trade", i));
+    }
+    bus.close();
+
+    auto stats = bus.getAsyncStats();
+    const TopicClassStats* bulk_stats = nullptr;
+    const TopicClassStats* critical_stats = nullptr;
+    for (const auto& topic_class : stats.classes) {
+        if (topic_class.name == "bulk") {
+            bulk_stats = &topic_class;
+        } else if (topic_class.name == "critical") {
+            critical_stats = &topic_class;
+        }
+    }
+    assert(bulk_stats != nullptr && critical_stats != nullptr);
+    assert(critical_stats->shed == 0 && critical.load() == per_class);
+    assert(bulk_stats->shed > 0);
+    assert(bulk_stats->admitted + rejected == static_cast<std::uint64_t>(per_class));
+    assert(bulk_stats->executed + bulk_stats->shed == static_cast<std::uint64_t>(per_class));
+    assert(static_cast<std::uint64_t>(bulk.load()) == bulk_stats->executed);
+    assert(stats.shed == bulk_stats->shed);
+    std::cout << "Async shed: bulk " << bulk_stats->shed << " of " << per_class
+              << ", critical 0 of " << per_class << std::endl;
+
+    // A cleared class no longer holds a shedding level: only default (5) and critical (10) remain.
+    {
+        EventBus cleared;
+        cleared.enableAsync(options);
+        cleared.setTopicClass("bulk.*", TopicClass{"bulk", 0});
+        cleared.setTopicClass("critical.*", TopicClass{"critical", 10});
+        assert(cleared.clearTopicClass("bulk.*"));
+        cleared.subscribe("misc.slow", [](int) { std::this_thread::sleep_for(std::chrono::microseconds(200)); });
+        std::size_t max_level = 0;
+        const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+        for (int i = 0; std::chrono::steady_clock::now() < until; ++i) {
+            (void)cleared.publishAsync("misc.slow", i);
+            max_level = std::max(max_level, cleared.getAsyncStats().shed_level);
+        }
+        cleared.close();
+        assert(max_level == 1);
+    }
+
+    // Concurrent close() calls join the workers once; both return after the queue drained.
+    for (int round = 0; round < 20; ++round) {
+        EventBus racing;
+        racing.enableAsync();
+        std::atomic<int> delivered{0};
+        racing.subscribe("tick", [&delivered](int) { ++delivered; });
+        for (int i = 0; i < 100; ++i) {
+            assert(racing.publishAsync("tick", i));
+        }
+        std::thread other([&racing, &delivered]() {
+            racing.close();
+            assert(delivered.load() == 100);
+        });
+        racing.close();
+        assert(delivered.load() == 100);
+        other.join();
+    }
+
+    std::cout << "Async load shedding: PASS" << std::endl;
+}
+
+void test_fair_scheduling()
+{
+    auto spin = [](std::chrono::microseconds duration) {
+        const auto until = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    };
+
+    EventBus bus;
+    AsyncOptions options;
+    options.workers = 1;
+    options.quantum = std::chrono::microseconds(300);
+    bus.enableAsync(options);
+    bus.setTopicTenant("heavy.*", Tenant{"heavy", 3});
+    bus.setTopicTenant("light.*", Tenant{"light", 1});
+
+    // A quiet topic is not stuck behind a noisy tenant's backlog.
+    std::atomic<int> heavy{0};
+    std::atomic<int> light{0};
+    std::atomic<int> heavy_at_light_done{-1};
+    const int light_events = 40;
+    bus.subscribe("heavy.scan", [&](int) {
+        spin(std::chrono::microseconds(100));
+        ++heavy;
+    });
+    bus.subscribe("light.scan", [&](int) {
+        spin(std::chrono::microseconds(100));
+        if (++light == light_events) {
+            heavy_at_light_done = heavy.load();
+        }
+    });
+    std::atomic<int> quiet_at{-1};
+    bus.subscribe("quiet", [&](int) { quiet_at = heavy.load(); });
+
+    const int heavy_events = 600;
+    for (int i = 0; i < heavy_events; ++i) {
+        assert(bus.publishAsync("heavy.scan", i));
+    }
+    for (int i = 0; i < light_events; ++i) {
+        assert(bus.publishAsync("light.scan", i));
+    }
+    assert(bus.publishAsync("quiet", 1));
+    bus.close();
+
+    assert(heavy.load() == heavy_events && light.load() == light_events);
+    assert(quiet_at.load() >= 0 && quiet_at.load() < heavy_events / 4);
+
+    // With weights 3:1 the heavy tenant runs about three events per light one.
+    const int ratio_base = heavy_at_light_done.load();
+    assert(ratio_base > light_events && ratio_base < light_events * 6);
+
+    auto stats = bus.getAsyncStats();
+    const TenantStats* heavy_stats = nullptr;
+    const TenantStats* light_stats = nullptr;
+    for (const auto& tenant : stats.tenants) {
+        if (tenant.name == "heavy") {
+            heavy_stats = &tenant;
+        } else if (tenant.name == "light") {
+            light_stats = &tenant;
+        }
+    }
+    assert(heavy_stats != nullptr && light_stats != nullptr);
+    assert(heavy_stats->weight == 3 && heavy_stats->executed == static_cast<std::uint64_t>(heavy_events));
+    assert(light_stats->executed == static_cast<std::uint64_t>(light_events) && light_stats->queued == 0);
+    assert(heavy_stats->cpu_time > light_stats->cpu_time && light_stats->cpu_time.count() > 0);
+    std::cout << "Fair share: heavy ran " << ratio_base << " while light ran " << light_events
+              << ", quiet after " << quiet_at.load() << std::endl;
+
+    // With several workers a backlogged flow is charged at dispatch, so it cannot take every
+    // worker before its first event finishes: here noisy events block until a calm one runs.
+    {
+        EventBus pool_bus;
+        AsyncOptions pool_options;
+        pool_options.workers = 4;
+        pool_bus.enableAsync(pool_options);
+        std::mutex gate_mutex;
+        std::condition_variable gate_cv;
+        bool calm_ran = false;
+        bool released = false;
+        std::atomic<int> holding{0};
+        std::atomic<int> stuck{0};
+        // Occupy every worker first so the noisy and calm events are all queued before any is picked.
+        pool_bus.subscribe("hold", [&](int) {
+            ++holding;
+            std::unique_lock<std::mutex> lock(gate_mutex);
+            gate_cv.wait(lock, [&released]() { return released; });
+        });
+        pool_bus.subscribe("noisy", [&](int) {
+            std::unique_lock<std::mutex> lock(gate_mutex);
+            if (!gate_cv.wait_for(lock, std::chrono::seconds(2), [&calm_ran]() { return calm_ran; })) {
+                ++stuck;
+            }
+        });
+        pool_bus.subscribe("calm", [&](int) {
+            {
+                std::lock_guard<std::mutex> lock(gate_mutex);
+                calm_ran = true;
+            }
+            gate_cv.notify_all();
+        });
+        for (int i = 0; i < 4; ++i) {
+            assert(pool_bus.publishAsync("hold", i));
+        }
+        while (holding.load() < 4) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        for (int i = 0; i < 8; ++i) {
+            assert(pool_bus.publishAsync("noisy", i));
+        }
+        assert(pool_bus.publishAsync("calm", 0));
+        {
+            std::lock_guard<std::mutex> lock(gate_mutex);
+            released = true;
+        }
+        gate_cv.notify_all();
+        pool_bus.close();
+        assert(calm_ran && stuck.load() == 0);
+    }
+    std::cout << "Fair scheduling: PASS" << std::endl;
+}
+
+void test_event_consumption()
+{
+    EventBus bus;
+    std::vector<std::string> order;
+
+    // Higher priority runs first; equal priorities keep subscription order.
+    bus.subscribe("command.open", [&](const std::string&) { order.push_back("audit"); }, -10);
+    bus.subscribe("command.open", [&](const std::string& path) {
+        order.push_back("text");
+        return path.size() > 4 && path.compare(path.size() - 4, 4, ".txt") == 0;
+    });
+    bus.subscribe("command.open", [&](const std::string& path) {
+        order.push_back("image");
+        return path.size() > 4 && path.compare(path.size() - 4, 4, ".png") == 0 ? Dispatch::consume
+                                                                                 : Dispatch::proceed;
+    });
+    bus.subscribe("command.open", [&](const std::string&) { order.push_back("trace"); }, 100);
+
+    auto result = bus.publish("command.open", std::string("notes.txt"));
+    assert(result.consumed && result.invoked == 2 && result.subscribers == 4);
+    assert((order == std::vector<std::string>{"trace", "text"}));
+
+    order.clear();
+    result = bus.publish("command.open", "photo.png");
+    assert(result.consumed && result.invoked == 3);
+    assert((order == std::vector<std::string>{"trace", "text", "image"}));
+
+    // Nobody claims it: every subscriber runs, lowest priority last.
+    order.clear();
+    result = bus.publish("command.open", std::string("data.bin"));
+    assert(!result.consumed && result.invoked == 4);
+    assert((order == std::vector<std::string>{"trace", "text", "image", "audit"}));
+
+    // A throwing handler does not consume, and type mismatches are passed over.
+    EventBus guarded;
+    int fallback = 0;
+    guarded.subscribe("job", [](int) -> bool { throw std::runtime_error("busy"); }, 5);
+    guarded.subscribe("job", [](const std::string&) { return true; }, 3);
+    guarded.subscribe("job", [&](int) { ++fallback; return true; });
+    guarded.subscribe("job", [&](int) { fallback += 100; });
+    guarded.setLogHandler([](LogLevel, const std::string&) {});
+    result = guarded.publish("job", 1);
+    assert(result.failed == 1 && result.type_mismatches == 1 && result.consumed && fallback == 1);
+
+    std::cout << "Event consumption: PASS" << std::endl;
+}
+
+void test_micro_batching()
+{
+    // The size bound delivers on the publishing thread; unsubscribing flushes the rest.
+    {
+        EventBus bus;
+        std::vector<std::vector<int>> batches;
+        BatchOptions options;
+        options.max_events = 4;
+        options.max_delay = std::chrono::seconds(10);
+        const auto id = bus.subscribeBatched("rows", [&](BatchView<int> rows) {
+            batches.emplace_back(rows.begin(), rows.end());
+        }, options);
+        for (int i = 0; i < 10; ++i) {
+            assert(bus.publish("rows", i).invoked == 1);
+        }
+        assert(batches.size() == 2);
+        assert((batches[0] == std::vector<int>{0, 1, 2, 3}) && (batches[1] == std::vector<int>{4, 5, 6, 7}));
+        assert(bus.unsubscribe("rows", id));
+        assert(batches.size() == 3 && (batches[2] == std::vector<int>{8, 9}));
+    }
+
+    // The latency bound delivers a partial batch from the timer thread.
+    {
+        EventBus bus;
+        std::mutex mutex;
+        std::vector<std::size_t> sizes;
+        std::atomic<bool> off_thread{false};
+        const auto publisher = std::this_thread::get_id();
+        BatchOptions options;
+        options.max_events = 500;
+        options.max_delay = std::chrono::milliseconds(2);
+        bus.subscribeBatched("orders", [&](BatchView<std::tuple<int, std::string>> orders) {
+            assert(std::get<1>(orders[0]) == "buy");
+            std::lock_guard<std::mutex> lock(mutex);
+            sizes.push_back(orders.size());
+            off_thread = std::this_thread::get_id() != publisher;
+        }, options);
+        for (int i = 0; i < 3; ++i) {
+            bus.publish("orders", i, "buy");
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!sizes.empty()) {
+                break;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(sizes.size() == 1 && sizes[0] == 3 && off_thread.load());
+    }
+
+    // Concurrent publishers: nothing lost or duplicated, close() flushes the tail.
+    {
+        EventBus bus;
+        std::atomic<long long> sum{0};
+        std::atomic<int> count{0};
+        std::atomic<std::size_t> largest{0};
+        BatchOptions options;
+        options.max_events = 64;
+        bus.subscribeBatched("ticks", [&](BatchView<int> ticks) {
+            for (int value : ticks) {
+                sum += value;
+            }
+            count += static_cast<int>(ticks.size());
+            if (ticks.size() > largest.load()) {
+                largest = ticks.size();
+            }
+        }, options);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&bus]() {
+                for (int i = 1; i <= 1000; ++i) {
+                    bus.publish("ticks", i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        bus.close();
+        assert(count.load() == 4000 && sum.load() == 4LL * 500500 && largest.load() <= 64);
+    }
+
+    // A timer-delivered batch whose callback unsubscribes while another publish fills the
+    // buffer: the publisher hands its batch over instead of blocking while counted in flight.
+    {
+        EventBus bus;
+        std::atomic<int> delivered{0};
+        std::thread publisher;
+        callback_id id = 0;
+        BatchOptions options;
+        options.max_events = 2;
+        options.max_delay = std::chrono::milliseconds(1);
+        id = bus.subscribeBatched("fills", [&](BatchView<int> fills) {
+            delivered += static_cast<int>(fills.size());
+            if (fills[0] != 0) {
+                return;
+            }
+            std::atomic<bool> published{false};
+            publisher = std::thread([&bus, &published]() {
+                bus.publish("fills", 1);
+                bus.publish("fills", 2);
+                published = true;
+            });
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!published.load() && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            assert(published.load());
+            assert(bus.unsubscribe("fills", id));
+        }, options);
+        bus.publish("fills", 0);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (delivered.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(delivered.load() == 3);
+        publisher.join();
+        assert(bus.getCallbackCount("fills") == 0);
+    }
+
+    std::cout << "Micro-batching: PASS" << std::endl;
+}
+
+void test_batch_filters()
+{
+    using Quote = std::tuple<std::string, double, int>;
+
+    // Every batch size around the 64-event word boundaries matches a scalar reference.
+    BatchFilter<Quote> filter;
+    filter.greater<1>(100.0).between<2>(10, 20);
+    std::vector<Quote> quotes;
+    for (int i = 0; i < 200; ++i) {
+        const double price = i % 7 == 0 ? std::nan("") : 90.0 + (i * 37) % 25;
+        quotes.emplace_back("q", price, (i * 13) % 30);
+    }
+    std::vector<std::uint32_t> selection;
+    for (std::size_t size : {0u, 1u, 63u, 64u, 65u, 128u, 130u, 200u}) {
+        filter.select(BatchView<Quote>(quotes.data(), size), selection);
+        std::vector<std::uint32_t> expected;
+        for (std::size_t i = 0; i < size; ++i) {
+            const double price = std::get<1>(quotes[i]);
+            const int qty = std::get<2>(quotes[i]);
+            if (price > 100.0 && qty >= 10 && qty <= 20) {
+                expected.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+        assert(selection == expected);
+    }
+
+    BatchFilter<int> odd_range;
+    odd_range.greater_equal<0>(5).less<0>(8);
+    const std::vector<int> values{3, 5, 7, 8, 6};
+    odd_range.select(BatchView<int>(values.data(), values.size()), selection);
+    assert((selection == std::vector<std::uint32_t>{1, 2, 4}));
+
+    // Subscribers receive the batch with a selection vector; empty selections are not delivered.
+    EventBus bus;
+    BatchOptions options;
+    options.max_events = 8;
+    options.max_delay = std::chrono::seconds(10);
+    std::vector<double> prices;
+    int deliveries = 0;
+    bus.subscribeBatched("quotes", BatchFilter<Quote>().greater<1>(100.0),
+                         [&](BatchView<Quote> batch, BatchView<std::uint32_t> selected) {
+        ++deliveries;
+        for (std::uint32_t index : selected) {
+            prices.push_back(std::get<1>(batch[index]));
+        }
+    }, options);
+    for (int i = 0; i < 8; ++i) {
+        bus.publish("quotes", std::string("ACME"), 99.0, i);
+    }
+    assert(deliveries == 0);
+    for (int i = 0; i < 8; ++i) {
+        bus.publish("quotes", std::string("ACME"), i % 2 == 0 ? 101.0 : 50.0, i);
+    }
+    assert(deliveries == 1 && (prices == std::vector<double>{101.0, 101.0, 101.0, 101.0}));
+
+    std::cout << "Batch filters: PASS" << std::endl;
+}
+
+struct Fill
+{
+    double price;
+    std::int32_t qty;
+    std::uint64_t order_id;
+    char venue;                 // not registered, so not stored in columns
+};
+
+EVENTBUS_BATCH_FIELDS(Fill, &Fill::price, &Fill::qty, &Fill::order_id);
+
+void test_columnar_batches()
+{
+    EventBus bus;
+    BatchOptions options;
+    options.max_events = 100;
+    options.max_delay = std::chrono::seconds(10);
+
+    double notional = 0;
+    std::size_t delivered = 0;
+    Fill last{};
+    bus.subscribeBatched("fills", [&](const ColumnBatch<Fill>& fills) {
+        assert(ColumnBatch<Fill>::field_count() == 3);
+        const auto prices = fills.column<0>();
+        const auto quantities = fills.column<1>();
+        for (std::size_t i = 0; i < fills.size(); ++i) {
+            notional += prices[i] * quantities[i];
+        }
+        delivered += fills.size();
+        last = fills.row(fills.size() - 1);
+    }, options);
+
+    // Columnar filters compare the double column in place and convert the integer one.
+    std::vector<std::uint64_t> selected_ids;
+    bus.subscribeBatched("fills", BatchFilter<Fill>().greater_equal<0>(10.0).less<1>(50),
+                         [&](const ColumnBatch<Fill>& fills, BatchView<std::uint32_t> selected) {
+        const auto ids = fills.column<2>();
+        for (std::uint32_t index : selected) {
+            selected_ids.push_back(ids[index]);
+        }
+    }, options);
+
+    std::vector<std::uint64_t> row_ids;
+    bus.subscribeBatched("fills", BatchFilter<Fill>().greater_equal<0>(10.0).less<1>(50),
+                         [&](BatchView<Fill> fills, BatchView<std::uint32_t> selected) {
+        for (std::uint32_t index : selected) {
+            row_ids.push_back(fills[index].order_id);
+        }
+    }, options);
+
+    double expected = 0;
+    for (int i = 0; i < 100; ++i) {
+        const Fill fill{5.0 + (i % 10), (i * 7) % 100, static_cast<std::uint64_t>(1000 + i), 'X'};
+        expected += fill.price * fill.qty;
+        bus.publish("fills", fill);
+    }
+    assert(delivered == 100 && notional == expected);
+    assert(last.price == 5.0 + 9 && last.qty == (99 * 7) % 100 && last.order_id == 1099 && last.venue == 0);
+    assert(!selected_ids.empty() && selected_ids == row_ids);
+    for (std::uint64_t id : selected_ids) {
+        const int i = static_cast<int>(id - 1000);
+        assert(5.0 + (i % 10) >= 10.0 && (i * 7) % 100 < 50);
+    }
+
+    std::cout << "Columnar batches: PASS" << std::endl;
+}
+
+struct MergeQuote
+{
+    std::int64_t ts;
+    double bid;
+};
+
+struct MergeTrade
+{
+    std::int64_t ts;
+    int qty;
+};
+
+void test_topic_merge()
+{
+    using Event = std::variant<MergeQuote, MergeTrade>;
+    auto time_of = [](const auto& event) { return event.ts; };
+
+    // Out-of-order arrivals within the lateness bound come out sorted; older ones are dropped.
+    // The watermark follows the slowest input, so a fast one cannot release events ahead of it.
+    {
+        EventBus bus;
+        std::vector<std::int64_t> order;
+        std::vector<std::size_t> kinds;
+        MergeOptions options;
+        options.lateness = 5;
+        auto merge = bus.mergeTopics<MergeQuote, MergeTrade>({"quotes", "trades"}, time_of, [&](const Event& event) {
+            order.push_back(std::visit([](const auto& value) { return value.ts; }, event));
+            kinds.push_back(event.index());
+        }, options);
+        assert(merge->subscriptions().size() == 2);
+
+        bus.publish("quotes", MergeQuote{100, 1.0});        // trades silent: no watermark yet
+        bus.publish("trades", MergeTrade{95, 5});           // watermark 90
+        assert(order.empty());
+        bus.publish("trades", MergeTrade{110, 7});          // watermark 95
+        assert((order == std::vector<std::int64_t>{95}));
+        bus.publish("quotes", MergeQuote{104, 1.05});       // watermark 99
+        bus.publish("quotes", MergeQuote{108, 1.08});       // watermark 103: emits 100
+        assert((order == std::vector<std::int64_t>{95, 100}));
+        bus.publish("quotes", MergeQuote{90, 0.9});         // older than 100, already emitted
+        bus.publish("trades", MergeTrade{120, 1});          // quotes still at 108: watermark stays 103
+        assert((order == std::vector<std::int64_t>{95, 100}));
+        bus.publish("quotes", MergeQuote{115, 1.15});       // watermark 110
+        assert((order == std::vector<std::int64_t>{95, 100, 104, 108, 110}));
+        assert((kinds == std::vector<std::size_t>{1, 0, 0, 0, 1}));
+
+        auto stats = merge->stats();
+        assert(stats.buffered == 2 && stats.emitted == 5 && stats.late == 1 && stats.forced == 0);
+        assert(bus.unsubscribe("quotes", merge->subscriptions()[0]));
+        assert(order.back() == 120 && merge->stats().buffered == 0);
+    }
+
+    // A consumer that waits on another publisher and then removes an input does not deadlock.
+    {
+        EventBus bus;
+        std::vector<std::int64_t> order;
+        std::shared_ptr<TopicMerge<MergeQuote, MergeTrade>> merge;
+        merge = bus.mergeTopics<MergeQuote, MergeTrade>({"quotes", "trades"}, time_of, [&](const Event& event) {
+            order.push_back(std::visit([](const auto& value) { return value.ts; }, event));
+            if (order.size() == 1) {
+                std::thread publisher([&bus]() {
+                    bus.publish("quotes", MergeQuote{2, 1.0});
+                    bus.publish("trades", MergeTrade{2, 1});
+                });
+                publisher.join();
+                assert(bus.unsubscribe("quotes", merge->subscriptions()[0]));
+            }
+        });
+        bus.publish("quotes", MergeQuote{1, 1.0});
+        bus.publish("trades", MergeTrade{1, 1});
+        assert((order == std::vector<std::int64_t>{1, 1, 2, 2}));
+        assert(merge->stats().buffered == 0);
+    }
+
+    // Equal timestamps keep input order; max_buffered forces the oldest out.
+    {
+        EventBus bus;
+        std::vector<std::size_t> kinds;
+        MergeOptions options;
+        options.lateness = 1000;
+        options.max_buffered = 3;
+        auto merge = bus.mergeTopics<MergeQuote, MergeTrade>({"quotes", "trades"}, time_of,
+                                                             [&](const Event& event) { kinds.push_back(event.index()); },
+                                                             options);
+        bus.publish("trades", MergeTrade{1, 1});
+        bus.publish("quotes", MergeQuote{1, 1.0});
+        bus.publish("trades", MergeTrade{2, 1});
+        assert(kinds.empty());
+        bus.publish("quotes", MergeQuote{3, 1.0});
+        assert((kinds == std::vector<std::size_t>{0}) && merge->stats().forced == 1);
+        merge->flush();
+        assert((kinds == std::vector<std::size_t>{0, 1, 1, 0}));
+    }
+
+    // Concurrent publishers on both inputs: close() drains everything in order.
+    {
+        EventBus bus;
+        std::vector<std::int64_t> order;
+        MergeOptions options;
+        options.lateness = std::numeric_limits<std::int32_t>::max();
+        options.max_buffered = 1000000;
+        auto merge = bus.mergeTopics<MergeQuote, MergeTrade>({"quotes", "trades"}, time_of, [&](const Event& event) {
+            order.push_back(std::visit([](const auto& value) { return value.ts; }, event));
+        }, options);
+        std::thread quotes([&bus]() {
+            for (std::int64_t i = 0; i < 2000; ++i) {
+                bus.publish("quotes", MergeQuote{2 * i, 1.0});
+            }
+        });
+        std::thread trades([&bus]() {
+            for (std::int64_t i = 0; i < 2000; ++i) {
+                bus.publish("trades", MergeTrade{2 * i + 1, 1});
+            }
+        });
+        quotes.join();
+        trades.join();
+        bus.close();
+        assert(order.size() == 4000 && std::is_sorted(order.begin(), order.end()));
+        assert(merge->stats().late == 0);
+    }
+
+    std::cout << "Topic merge: PASS" << std::endl;
+}
+
+void test_sharded_bus()
+{
+    ShardedOptions options;
+    options.shards = 4;
+    options.queue_capacity = 8;
+    ShardedEventBus bus(options);
+    assert(bus.shard_count() == 4);
+
+    // Find two topics owned by different shards.
+    std::string ping = "ping";
+    std::string pong;
+    for (int i = 0; pong.empty(); ++i) {
+        const std::string candidate = "pong." + std::to_string(i);
+        if (bus.shard_of(candidate) != bus.shard_of(ping)) {
+            pong = candidate;
+        }
+    }
+
+    // Each topic's subscribers run on its shard's thread; cross-shard publishes go through the queues.
+    std::mutex mutex;
+    std::set<std::thread::id> ping_threads;
+    std::set<std::thread::id> pong_threads;
+    std::atomic<int> pings{0};
+    std::atomic<int> pongs{0};
+    std::atomic<int> echoes{0};
+    bus.subscribe(ping, [&](int n) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ping_threads.insert(std::this_thread::get_id());
+        }
+        ++pings;
+        bus.publish(pong, n, "reply");
+    });
+    bus.subscribe(pong, [&](int n, const std::string& text) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pong_threads.insert(std::this_thread::get_id());
+        }
+        assert(text == "reply");
+        ++pongs;
+        // Shards publishing to each other through tiny queues must not deadlock.
+        if (n % 2 == 0) {
+            bus.publish(ping + ".echo", n);
+        }
+    });
+    bus.subscribe(ping + ".echo", [&](int) { ++echoes; });
+
+    const int events = 5000;
+    std::vector<std::thread> publishers;
+    for (int t = 0; t < 2; ++t) {
+        publishers.emplace_back([&bus, &ping, t]() {
+            for (int i = t; i < events; i += 2) {
+                assert(bus.publish(ping, i));
+            }
+        });
+    }
+    for (auto& publisher : publishers) {
+        publisher.join();
+    }
+    bus.drain();
+
+    assert(pings.load() == events && pongs.load() == events && echoes.load() == events / 2);
+    assert(ping_threads.size() == 1 && pong_threads.size() == 1);
+    assert(*ping_threads.begin() != *pong_threads.begin());
+    assert(ping_threads.count(std::this_thread::get_id()) == 0);
+
+    std::uint64_t external = 0;
+    std::uint64_t remote = 0;
+    for (const auto& shard : bus.getStats()) {
+        external += shard.external;
+        remote += shard.remote + shard.local;
+        assert(shard.backlog == 0);
+    }
+    assert(external == static_cast<std::uint64_t>(events));
+    assert(remote == static_cast<std::uint64_t>(events + events / 2));
+
+    bus.close();
+    assert(!bus.publish(ping, 1));
+
+    // A shard stuck behind a full queue dispatches its inbound events at a bounded depth.
+    {
+        ShardedOptions nested_options;
+        nested_options.shards = 2;
+        nested_options.queue_capacity = 2;
+        ShardedEventBus nested(nested_options);
+        std::string source = "source";
+        std::string sink;
+        for (int i = 0; sink.empty(); ++i) {
+            const std::string candidate = "sink." + std::to_string(i);
+            if (nested.shard_of(candidate) != nested.shard_of(source)) {
+                sink = candidate;
+            }
+        }
+        std::atomic<bool> open{false};
+        std::atomic<int> sources{0};
+        std::atomic<int> sinks{0};
+        std::atomic<int> deepest{0};
+        int nesting = 0;        // only touched on the source shard's thread
+        nested.subscribe(source, [&](int n) {
+            ++nesting;
+            deepest = std::max(deepest.load(), nesting);
+            ++sources;
+            nested.publish(sink, n);
+            --nesting;
+        });
+        nested.subscribe(sink, [&](int) {
+            while (!open.load()) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            ++sinks;
+        });
+
+        const int count = 100;
+        for (int i = 0; i < count; ++i) {
+            assert(nested.publish(source, i));
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (sources.load() <= i && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::yield();
+            }
+        }
+        open = true;
+        nested.drain();
+        assert(sources.load() == count && sinks.load() == count);
+        assert(deepest.load() <= static_cast<int>(ShardedEventBus::max_publish_depth) + 1);
+    }
+
+    // close() still delivers what queued events publish in turn, across shards and back.
+    {
+        ShardedOptions cascade_options;
+        cascade_options.shards = 2;
+        ShardedEventBus cascade(cascade_options);
+        std::string first = "first";
+        std::string second;
+        for (int i = 0; second.empty(); ++i) {
+            const std::string candidate = "second." + std::to_string(i);
+            if (cascade.shard_of(candidate) != cascade.shard_of(first)) {
+                second = candidate;
+            }
+        }
+        std::atomic<int> hops{0};
+        std::atomic<bool> onward_accepted{true};
+        cascade.subscribe(first, [&](int n) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));     // still running when close() starts
+            if (!cascade.publish(second, n + 1)) {
+                onward_accepted = false;
+            }
+        });
+        cascade.subscribe(second, [&](int n) {
+            hops.fetch_add(n);
+            if (n == 1 && !cascade.publish(first + ".back", n + 1)) {
+                onward_accepted = false;
+            }
+        });
+        cascade.subscribe(first + ".back", [&](int n) { hops.fetch_add(n); });
+        assert(cascade.publish(first, 0));
+        cascade.close();
+        assert(onward_accepted.load() && hops.load() == 1 + 2);
+        assert(!cascade.publish(first, 0));
+    }
+
+    // External publishes racing close() are either delivered or rejected, never lost.
+    for (int round = 0; round < 10; ++round) {
+        ShardedOptions racing_options;
+        racing_options.shards = 2;
+        ShardedEventBus racing(racing_options);
+        std::atomic<int> delivered{0};
+        racing.subscribe("race", [&delivered](int) { ++delivered; });
+        std::atomic<int> accepted{0};
+        std::vector<std::thread> racers;
+        for (int t = 0; t < 3; ++t) {
+            racers.emplace_back([&racing, &accepted]() {
+                while (racing.publish("race", 1)) {
+                    ++accepted;
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        racing.close();
+        for (auto& racer : racers) {
+            racer.join();
+        }
+        assert(delivered.load() == accepted.load());
+    }
+    std::cout << "Sharded bus: PASS" << std::endl;
+}
+
+void test_senders()
+{
+    // Pure composition runs inline; errors from a continuation reach sync_wait().
+    auto sum = exec::sync_wait(exec::just(2, 3) | exec::then([](int a, int b) { return a + b; }));
+    assert(sum && std::get<0>(*sum) == 5);
+    bool threw = false;
+    try {
+        (void)exec::sync_wait(exec::just() | exec::then([]() -> int { throw std::runtime_error("boom"); }));
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    EventBus bus;
+    assert(!exec::sync_wait(bus.publishSender("orders", 1)));     // enableAsync() not called: stopped
+    bus.enableAsync();
+    const auto caller = std::this_thread::get_id();
+
+    // Async publish completes on the worker after the subscriber ran.
+    std::atomic<int> seen{0};
+    bus.subscribe("orders", [&seen](int value) { seen.fetch_add(value); });
+    auto published = exec::sync_wait(bus.publishSender("orders", 7) | exec::then([&](const EventBus::PublishResult& result) {
+        assert(std::this_thread::get_id() != caller);
+        return result.invoked;
+    }));
+    assert(published && std::get<0>(*published) == 1 && seen.load() == 7);
+
+    // Scheduler hops: starts_on runs on a worker, continues_on moves back onto one.
+    auto on_worker = exec::sync_wait(exec::starts_on(bus.scheduler(), exec::just(4) | exec::then([&](int value) {
+        return std::this_thread::get_id() != caller ? value : -1;
+    })));
+    assert(on_worker && std::get<0>(*on_worker) == 4);
+    auto hopped = exec::sync_wait(exec::just(std::string("x")) | exec::continues_on(bus.scheduler()) |
+                                  exec::then([&](std::string value) {
+        return std::this_thread::get_id() != caller ? value + "y" : std::string();
+    }));
+    assert(hopped && std::get<0>(*hopped) == "xy");
+
+    // Request/reply with an inline responder and one that replies from a worker.
+    bus.subscribe("math.square", [&bus](int value) { bus.publish("math.square.reply", value * value); });
+    bus.subscribe("math.twice", [&bus](int value) { bus.publishAsync("math.twice.reply", value * 2); });
+    auto square = exec::sync_wait(bus.request<int>("math.square", "math.square.reply", 12));
+    assert(square && std::get<0>(*square) == 144);
+    auto twice = exec::sync_wait(bus.request<int>("math.twice", "math.twice.reply", 21));
+    assert(twice && std::get<0>(*twice) == 42);
+    assert(!exec::sync_wait(bus.request<int>("math.nobody", "math.nobody.reply", 1)));
+    assert(!bus.isEventRegistered("math.square.reply") && !bus.isEventRegistered("math.nobody.reply"));
+
+    // next event, chained into a publish; the one-shot subscription is gone afterwards.
+    std::thread publisher([&bus]() {
+        while (!bus.isEventRegistered("ticker")) {
+            std::this_thread::yield();
+        }
+        bus.publish("ticker", std::string("AAPL"), 101.5);
+    });
+    auto chained = exec::sync_wait(bus.nextEvent<std::string, double>("ticker") |
+                                   exec::let_value([&bus](const std::string& symbol, double price) {
+        return bus.publishSender("orders", static_cast<int>(price) + static_cast<int>(symbol.size()));
+    }));
+    publisher.join();
+    assert(chained && std::get<0>(*chained).invoked == 1 && seen.load() == 7 + 105);
+    assert(!bus.isEventRegistered("ticker"));
+
+    // Concurrent publishers complete the operation exactly once.
+    for (int round = 0; round < 20; ++round) {
+        std::atomic<bool> go{false};
+        std::vector<std::thread> racers;
+        for (int i = 0; i < 4; ++i) {
+            racers.emplace_back([&bus, &go, i]() {
+                while (!go.load()) {
+                    std::this_thread::yield();
+                }
+                bus.publish("race", i);
+            });
+        }
+        std::thread starter([&go, &bus]() {
+            while (!bus.isEventRegistered("race")) {
+                std::this_thread::yield();
+            }
+            go.store(true);
+        });
+        auto winner = exec::sync_wait(bus.nextEvent<int>("race"));
+        assert(winner && std::get<0>(*winner) >= 0 && std::get<0>(*winner) < 4);
+        starter.join();
+        for (auto& racer : racers) {
+            racer.join();
+        }
+    }
+
+    // Removing a pending one-shot subscription completes it with set_stopped().
+    std::thread remover([&bus]() {
+        while (!bus.isEventRegistered("pending")) {
+            std::this_thread::yield();
+        }
+        assert(bus.unsubscribe_all("pending") == 1);
+    });
+    assert(!exec::sync_wait(bus.nextEvent<int>("pending")));
+    remover.join();
+    bus.subscribe("math.drop", [&bus](int) { (void)bus.unsubscribe_all("math.drop.reply"); });
+    assert(!exec::sync_wait(bus.request<int>("math.drop", "math.drop.reply", 1)));
+
+    // So does closing the bus from another thread while the operation waits.
+    {
+        EventBus closing;
+        std::thread closer([&closing]() {
+            while (!closing.isEventRegistered("never")) {
+                std::this_thread::yield();
+            }
+            closing.close();
+        });
+        assert(!exec::sync_wait(closing.nextEvent<int>("never")));
+        closer.join();
+    }
+
+    bus.close();
+    assert(!exec::sync_wait(bus.nextEvent<int>("ticker")));
+    std::cout << "Senders: PASS" << std::endl;
+}
+
+void test_fiber_subscribers()
+{
+    AsyncOptions options;
+    options.workers = 2;
+    options.fibers = 1000;
+    options.blocking_threads = 2;
+
+    // A thousand handlers parked in sleep_for() share two workers instead of queueing behind each other.
+    {
+        EventBus bus;
+        bus.enableAsync(options);
+        std::atomic<int> done{0};
+        std::atomic<int> on_fiber{0};
+        bus.subscribe("disk.read", [&](int) {
+            if (this_fiber::active()) {
+                on_fiber.fetch_add(1);
+            }
+            this_fiber::sleep_for(std::chrono::milliseconds(50));
+            this_fiber::yield();
+            done.fetch_add(1);
+        });
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 1000; ++i) {
+            assert(bus.publishAsync("disk.read", i));
+        }
+        while (done.load() < 1000 && std::chrono::steady_clock::now() - start < std::chrono::seconds(60)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(done.load() == 1000);
+#if EVENTBUS_HAS_FIBERS
+        assert(on_fiber.load() == 1000);
+        assert(elapsed < std::chrono::seconds(5));      // 25s if each sleep held a worker
+#endif
+        (void)elapsed;
+        assert(bus.getAsyncStats().executed == 1000);
+    }
+
+    // run_blocking() returns results and exceptions; close() waits for parked fibers.
+    {
+        EventBus bus;
+        bus.enableAsync(options);
+        std::atomic<int> sum{0};
+        std::atomic<int> errors{0};
+        bus.subscribe("io", [&](int value) {
+            sum.fetch_add(this_fiber::run_blocking([value]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                return value * 2;
+            }));
+            try {
+                this_fiber::run_blocking([]() { throw std::runtime_error("io error"); });
+            }
+            catch (const std::runtime_error&) {
+                errors.fetch_add(1);
+            }
+        });
+        for (int i = 1; i <= 50; ++i) {
+            assert(bus.publishAsync("io", i));
+        }
+        bus.close();
+        assert(sum.load() == 2 * (50 * 51 / 2));
+        assert(errors.load() == 50);
+    }
+
+    // unsubscribe() from one fiber waits for the callback parked on another fiber of the same worker.
+    {
+        AsyncOptions single = options;
+        single.workers = 1;
+        single.fibers = 8;
+        EventBus bus;
+        bus.enableAsync(single);
+        std::atomic<bool> parked{false};
+        std::atomic<bool> finished{false};
+        std::atomic<int> finished_before_return{-1};
+        const callback_id slow = bus.subscribe("slow", [&](int) {
+            parked = true;
+            this_fiber::sleep_for(std::chrono::milliseconds(50));
+            finished = true;
+        });
+        bus.subscribe("stop", [&](int) {
+            while (!parked.load()) {
+                this_fiber::yield();
+            }
+            assert(bus.unsubscribe("slow", slow));
+            finished_before_return = finished.load() ? 1 : 0;
+        });
+        assert(bus.publishAsync("slow", 1));
+        assert(bus.publishAsync("stop", 1));
+        bus.close();
+#if EVENTBUS_HAS_FIBERS
+        assert(finished_before_return.load() == 1);
+#endif
+        assert(finished.load());
+    }
+
+    // Outside a fiber the helpers block the calling thread as usual.
+    assert(!this_fiber::active());
+    assert(this_fiber::run_blocking([]() { return 7; }) == 7);
+    this_fiber::sleep_for(std::chrono::milliseconds(1));
+    std::cout << "Fiber subscribers: PASS" << std::endl;
+}
+
+void test_bus_federation()
+{
+    LinkOptions inline_links;
+    inline_links.max_events = 1;
+
+    // Only advertised topics cross a link, in either direction, and never echo back.
+    {
+        EventBus global;
+        EventBus orders;
+        EventBus risk;
+        auto orders_link = global.linkChild(orders, inline_links);
+        auto risk_link = global.linkChild(risk, inline_links);
+        assert(orders_link && risk_link);
+
+        std::vector<int> orders_seen;
+        std::vector<int> global_seen;
+        const callback_id orders_id = orders.subscribe("order.new", [&](int id) { orders_seen.push_back(id); });
+        global.subscribe("order.filled", [&](int id) { global_seen.push_back(id); });
+        assert(orders_link->downstream().interest == 1 && risk_link->downstream().interest == 0);
+        assert(orders_link->upstream().interest == 1 && risk_link->upstream().interest == 2);
+
+        auto result = global.publish("order.new", 1);
+        assert(result.forwarded == 1 && (orders_seen == std::vector<int>{1}));
+        assert(global.publish("order.unknown", 1).forwarded == 0);
+        assert(risk.publish("order.new", 2).forwarded == 1);             // risk -> global -> orders
+        assert((orders_seen == std::vector<int>{1, 2}));
+        assert(risk_link->downstream().forwarded == 0);                   // not sent back to risk
+
+        orders.publish("order.filled", 3);
+        assert((global_seen == std::vector<int>{3}));
+        global.subscribe("order.filled", [&](int) {});
+        assert(orders_link->upstream().forwarded == 1);
+
+        assert(orders.unsubscribe("order.new", orders_id));
+        assert(orders_link->downstream().interest == 0 && risk_link->upstream().interest == 1);
+        assert(global.publish("order.new", 4).forwarded == 0);
+        assert(risk.publish("order.new", 5).forwarded == 0);
+    }
+
+    // Interest propagates through a hierarchy; closing a bus removes its link.
+    {
+        EventBus root;
+        EventBus middle;
+        EventBus leaf;
+        auto upper = root.linkChild(middle, inline_links);
+        auto lower = middle.linkChild(leaf, inline_links);
+        std::atomic<int> leaf_total{0};
+        leaf.subscribe("tick", [&](int value) { leaf_total.fetch_add(value); });
+        assert(upper->downstream().interest == 1);
+        root.publish("tick", 5);
+        assert(leaf_total.load() == 5);
+
+        bool threw = false;
+        try {
+            (void)root.linkChild(middle);
+        }
+        catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+        threw = false;
+        try {
+            (void)leaf.linkChild(root);       // root -> middle -> leaf -> root
+        }
+        catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw && root.publish("tick", 0).forwarded == 1);
+
+        leaf.close();
+        assert(!lower->linked() && upper->linked());
+        assert(upper->downstream().interest == 0);
+        assert(root.publish("tick", 1).forwarded == 0);
+        middle.close();
+        assert(!upper->linked());
+    }
+
+    // Batched links forward on size or delay; unlink() delivers what is left.
+    {
+        EventBus parent;
+        EventBus child;
+        LinkOptions batched;
+        batched.max_events = 4;
+        batched.max_delay = std::chrono::milliseconds(5);
+        auto link = parent.linkChild(child, batched);
+        std::atomic<int> received{0};
+        child.subscribe("quote", [&](int) { received.fetch_add(1); });
+
+        for (int i = 0; i < 3; ++i) {
+            parent.publish("quote", i);
+        }
+        assert(received.load() == 0);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (received.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(received.load() == 3);
+
+        for (int i = 0; i < 4; ++i) {
+            parent.publish("quote", i);
+        }
+        assert(received.load() == 7);
+        parent.publish("quote", 0);
+        link->unlink();
+        assert(received.load() == 8 && !link->linked());
+        auto stats = link->downstream();
+        assert(stats.forwarded == 8 && stats.batches == 3 && stats.interest == 0);
+        assert(parent.publish("quote", 0).forwarded == 0);
+    }
+
+    // Advertisements carry only the topics that changed, not the whole set each time.
+    {
+        EventBus parent;
+        EventBus child;
+        auto link = parent.linkChild(child, inline_links);
+        for (int i = 0; i < 50; ++i) {
+            child.subscribe("topic." + std::to_string(i), [](int) {});
+        }
+        auto stats = link->downstream();
+        assert(stats.interest == 50 && stats.interest_updates == 50);
+        for (int i = 0; i < 10; ++i) {
+            assert(child.unsubscribe_all("topic." + std::to_string(i)) == 1);
+        }
+        stats = link->downstream();
+        assert(stats.interest == 40 && stats.interest_updates == 60);
+        assert(parent.publish("topic.20", 1).forwarded == 1 && parent.publish("topic.5", 1).forwarded == 0);
+    }
+    std::cout << "Bus federation: PASS" << std::endl;
+}
+
+void test_topic_filter()
+{
+    // Counts survive overlapping names: a shared counter only clears when every name is gone.
+    {
+        detail::TopicFilter filter;
+        const std::size_t a = std::hash<std::string>{}("alpha");
+        const std::size_t b = std::hash<std::string>{}("beta");
+        assert(!filter.may_contain(a) && !filter.may_contain(b));
+        filter.add(a);
+        filter.add(b);
+        filter.remove(a);
+        assert(filter.may_contain(b));
+        filter.remove(b);
+        assert(!filter.may_contain(a) && !filter.may_contain(b));
+        filter.set_exact(false);
+        assert(filter.may_contain(a));
+    }
+
+    // Unknown topics are answered by the filter; topics known for any reason still reach the registry.
+    EventBus bus;
+    int received = 0;
+    std::size_t misses = 0;
+    for (int i = 0; i < 1000; ++i) {
+        misses += bus.publish("trace." + std::to_string(i), i).subscribers == 0 ? 1 : 0;
+    }
+    assert(misses == 1000);
+
+    const callback_id id = bus.subscribe("trace.7", [&](int) { ++received; });
+    assert(bus.publish("trace.7", 7).invoked == 1);
+    assert(bus.unsubscribe("trace.7", id));
+    assert(bus.publish("trace.7", 7).subscribers == 0 && received == 1);
+
+    assert(bus.createLogTopic("audit"));
+    assert(bus.publish("audit", 1).logged == 1);
+
+    RateLimit reject;
+    reject.rate = 1.0;
+    reject.burst = 1.0;
+    bus.setRateLimit("debug.*", reject);
+    assert(bus.publish("debug.gc", 1).throttled == 0);
+    assert(bus.publish("debug.gc", 2).throttled == 1);
+    assert(bus.clearRateLimit("debug.*"));
+    assert(bus.publish("debug.gc", 3).throttled == 0);
+
+    bus.subscribe("trace.9", [&](int) { ++received; });
+    bus.clear();
+    assert(bus.publish("trace.9", 9).subscribers == 0 && received == 1);
+    std::cout << "Topic filter: PASS" << std::endl;
+}
+
+int main()
+{
+    std::cout << "=== EventBus Storage Test ===" << std::endl;
+
+    test_page_buffer();
+    test_byte_ring();
+    test_journal(JournalBackend::automatic, "automatic");
+    test_journal(JournalBackend::thread, "thread");
+    test_journal_write_errors();
+    test_bus_journal();
+    test_durable_group_commit();
+    test_log_topic();
+    test_log_topic_limits_and_files();
+    test_log_spill();
+    test_timer_queue();
+    test_compacted_state();
+    test_bus_snapshot();
+    test_delta_journal();
+    test_hot_topics();
+    test_fast_path();
+    test_rate_limits();
+    test_async_shedding();
+    test_fair_scheduling();
+    test_event_consumption();
+    test_micro_batching();
+    test_batch_filters();
+    test_columnar_batches();
+    test_topic_merge();
+    test_sharded_bus();
+    test_senders();
+    test_fiber_subscribers();
+    test_bus_federation();
+    test_topic_filter();
+#if EVENTBUS_HAS_POSIX
+    test_shared_ring();
+#endif
+
+    std::cout << "=== Test Complete ===" << std::endl;
+    return 0;
+}